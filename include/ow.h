@@ -113,6 +113,25 @@ typedef union ow_sysconf_result {
 	const char  *s;
 } ow_sysconf_result_t;
 
+/**
+ * @brief Memory allocator of an OW instance. See `OW_CTL_ALLOCATOR`.
+ *
+ * All memory of an instance is allocated with its allocator, and the sizes passed
+ * to the functions are exact, so the allocator can keep count of the memory in use.
+ * The functions may be called concurrently from several threads (e.g. background
+ * garbage collector threads), so they must be thread-safe.
+ */
+typedef struct ow_allocator {
+	/// Allocate `size` bytes aligned to `alignment`, which is a power of 2. Return NULL on failure.
+	void *(*allocate)(void *data, size_t size, size_t alignment);
+	/// Resize memory allocated with alignment `alignment`. Return NULL on failure. Optional.
+	void *(*reallocate)(void *data, void *ptr, size_t old_size, size_t new_size, size_t alignment);
+	/// Free memory allocated with the same `size` and `alignment`.
+	void (*deallocate)(void *data, void *ptr, size_t size, size_t alignment);
+	/// User data passed to the functions.
+	void *data;
+} ow_allocator_t;
+
 #define OW_SC_DEBUG           0 ///< Whether compiled with debug code.
 #define OW_SC_VERSION         1 ///< Get version number (`(MAJOR<<24)|(MINOR<<16)|(PATCH<<8)`).
 #define OW_SC_VERSION_STR     2 ///< Get version string.
@@ -131,6 +150,14 @@ OW_API union ow_sysconf_result ow_sysconf(int name) OW_NOEXCEPT;
 #define OW_CTL_VERBOSE        0 ///< Enable verbose output. Value: `"[!]NAME"`.
 #define OW_CTL_STACKSIZE      1 ///< Set stack size (number of objects). Value: pointer to integer.
 #define OW_CTL_DEFAULTPATH    2 ///< Default module paths. Value: `"path_1\0path_2\0...path_n\0"`.
+#define OW_CTL_STACKRESERVE   3 ///< Reserve a guard-page-protected stack (number of objects; 0 to disable). Value: pointer to integer.
+#define OW_CTL_GCMARKBUDGET   4 ///< Do full GCs incrementally, marking this many objects at a time (0 to disable). Value: pointer to integer.
+#define OW_CTL_GCMARKTHREADS  5 ///< Number of threads for marking in full GCs (1 to disable parallel marking). Value: pointer to integer.
+#define OW_CTL_GCCOMPACT      6 ///< Compact the heap in a full GC if this percentage of it was fragmented after last full GC (0 to disable). Value: pointer to integer.
+#define OW_CTL_GCCPUGOAL      7 ///< Size the heap so that GC takes about this percentage of time (0 for a fixed growth policy). Value: pointer to integer.
+#define OW_CTL_GCHEAPGOAL     8 ///< Keep the heap within this size (bytes; 0 for no goal) if possible, at the cost of more GCs. Value: pointer to integer.
+#define OW_CTL_HEAPLIMIT      9 ///< Raise an out-of-memory exception if the heap exceeds this size (bytes; 0 for the default). Value: pointer to integer.
+#define OW_CTL_ALLOCATOR     10 ///< Memory allocator for instances created afterwards. Value: pointer to `ow_allocator_t` (copied), or NULL for the default one.
 
 /**
  * @breif Write runtime parameters.
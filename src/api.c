@@ -37,6 +37,7 @@
 #include <objects/tupleobj.h>
 #include <utilities/array.h>
 #include <utilities/attributes.h>
+#include <utilities/malloc.h>
 #include <utilities/platform.h>
 #include <utilities/stream.h>
 #include <utilities/strings.h>
@@ -141,8 +142,79 @@ OW_API int ow_sysctl(int name, const void *val, size_t val_sz) {
 
 	case OW_CTL_STACKSIZE: {
 		const int64_t v = _ow_sysctl_read_int(val, val_sz);
-		if (v == INT64_MIN)
+		if (v <= 0)
 			return OW_ERR_FAIL;
+		ow_sysparam.stack_size = (size_t)v;
+		return 0;
+	}
+
+	case OW_CTL_STACKRESERVE: {
+		const int64_t v = _ow_sysctl_read_int(val, val_sz);
+		if (v < 0)
+			return OW_ERR_FAIL;
+		ow_sysparam.stack_reserve = (size_t)v;
+		return 0;
+	}
+
+	case OW_CTL_GCMARKBUDGET: {
+		const int64_t v = _ow_sysctl_read_int(val, val_sz);
+		if (v < 0)
+			return OW_ERR_FAIL;
+		ow_sysparam.gc_mark_budget = (size_t)v;
+		return 0;
+	}
+
+	case OW_CTL_GCMARKTHREADS: {
+		const int64_t v = _ow_sysctl_read_int(val, val_sz);
+		if (v < 1 || v > 256)
+			return OW_ERR_FAIL;
+		ow_sysparam.gc_mark_threads = (size_t)v;
+		return 0;
+	}
+
+	case OW_CTL_GCCOMPACT: {
+		const int64_t v = _ow_sysctl_read_int(val, val_sz);
+		if (v < 0 || v > 100)
+			return OW_ERR_FAIL;
+		ow_sysparam.gc_compact_threshold = (size_t)v;
+		return 0;
+	}
+
+	case OW_CTL_GCCPUGOAL: {
+		const int64_t v = _ow_sysctl_read_int(val, val_sz);
+		if (v < 0 || v >= 100)
+			return OW_ERR_FAIL;
+		ow_sysparam.gc_cpu_goal = (size_t)v;
+		return 0;
+	}
+
+	case OW_CTL_GCHEAPGOAL: {
+		const int64_t v = _ow_sysctl_read_int(val, val_sz);
+		if (v < 0)
+			return OW_ERR_FAIL;
+		ow_sysparam.gc_heap_goal = (size_t)v;
+		return 0;
+	}
+
+	case OW_CTL_HEAPLIMIT: {
+		const int64_t v = _ow_sysctl_read_int(val, val_sz);
+		if (v < 0)
+			return OW_ERR_FAIL;
+		ow_sysparam.heap_limit = (size_t)v;
+		return 0;
+	}
+
+	case OW_CTL_ALLOCATOR: {
+		if (!val) {
+			ow_sysparam.allocator = (struct ow_allocator){NULL, NULL, NULL, NULL};
+			return 0;
+		}
+		if (val_sz != sizeof(ow_allocator_t))
+			return OW_ERR_FAIL;
+		const ow_allocator_t *const allocator = val;
+		if (!allocator->allocate || !allocator->deallocate)
+			return OW_ERR_FAIL;
+		ow_sysparam.allocator = *allocator;
 		return 0;
 	}
 
@@ -172,39 +244,56 @@ OW_API void ow_setjmp(ow_machine_t *om, ow_jmpbuf_t env) {
 
 OW_API int ow_longjmp(ow_machine_t *om, ow_jmpbuf_t env) {
 	struct ow_machine_jmpbuf *const jb = (struct ow_machine_jmpbuf *)env;
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 	const bool ok = ow_machine_longjmp(om, jb);
+	ow_malloc_set_allocator(prev_allocator);
 	return ok ? 0 : OW_ERR_FAIL;
 }
 
 OW_API void ow_push_nil(ow_machine_t *om) {
+	ow_machine_stack_reserve(om, 1);
 	*++om->callstack.regs.sp = om->globals->value_nil;
 }
 
 OW_API void ow_push_bool(ow_machine_t *om, bool val) {
+	ow_machine_stack_reserve(om, 1);
 	*++om->callstack.regs.sp =
 		val ? om->globals->value_true : om->globals->value_false;
 }
 
 OW_API void ow_push_int(ow_machine_t *om, intmax_t val) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
+	ow_machine_stack_reserve(om, 1);
 	static_assert(sizeof val == sizeof(int64_t), "");
 	*++om->callstack.regs.sp = ow_int_obj_or_smallint(om, val);
+	ow_malloc_set_allocator(prev_allocator);
 }
 
 OW_API void ow_push_float(ow_machine_t *om, double val) {
-	*++om->callstack.regs.sp = ow_object_from(ow_float_obj_new(om, val));
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
+	ow_machine_stack_reserve(om, 1);
+	*++om->callstack.regs.sp = ow_float_obj_or_flonum(om, val);
+	ow_malloc_set_allocator(prev_allocator);
 }
 
 OW_API void ow_push_symbol(ow_machine_t *om, const char *str, size_t len) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
+	ow_machine_stack_reserve(om, 1);
 	assert(str || !len);
 	*++om->callstack.regs.sp = ow_object_from(ow_symbol_obj_new(om, str, len));
+	ow_malloc_set_allocator(prev_allocator);
 }
 
 OW_API void ow_push_string(ow_machine_t *om, const char *str, size_t len) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
+	ow_machine_stack_reserve(om, 1);
 	assert(str || !len);
 	*++om->callstack.regs.sp = ow_object_from(ow_string_obj_new(om, str, len));
+	ow_malloc_set_allocator(prev_allocator);
 }
 
 OW_API void ow_make_array(ow_machine_t *om, size_t count) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 	struct ow_object **data = om->callstack.regs.sp - count + 1;
 	if (ow_unlikely(data < om->callstack.regs.fp)) {
 		data = om->callstack.regs.fp;
@@ -212,9 +301,11 @@ OW_API void ow_make_array(ow_machine_t *om, size_t count) {
 	}
 	*data = ow_object_from(ow_array_obj_new(om, data, count));
 	om->callstack.regs.sp = data;
+	ow_malloc_set_allocator(prev_allocator);
 }
 
 OW_API void ow_make_tuple(ow_machine_t *om, size_t count) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 	struct ow_object **data = om->callstack.regs.sp - count + 1;
 	if (ow_unlikely(data < om->callstack.regs.fp)) {
 		data = om->callstack.regs.fp;
@@ -222,9 +313,11 @@ OW_API void ow_make_tuple(ow_machine_t *om, size_t count) {
 	}
 	*data = ow_object_from(ow_tuple_obj_new(om, data, count));
 	om->callstack.regs.sp = data;
+	ow_malloc_set_allocator(prev_allocator);
 }
 
 OW_API void ow_make_set(ow_machine_t *om, size_t count) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 	struct ow_object **data = om->callstack.regs.sp - count + 1;
 	if (ow_unlikely(data < om->callstack.regs.fp)) {
 		data = om->callstack.regs.fp;
@@ -235,9 +328,11 @@ OW_API void ow_make_set(ow_machine_t *om, size_t count) {
 		ow_set_obj_insert(om, set, data[i]);
 	*data = ow_object_from(set);
 	om->callstack.regs.sp = data;
+	ow_malloc_set_allocator(prev_allocator);
 }
 
 OW_API void ow_make_map(ow_machine_t *om, size_t count) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 	struct ow_object **data = om->callstack.regs.sp - count * 2 + 1;
 	if (ow_unlikely(data < om->callstack.regs.fp)) {
 		data = om->callstack.regs.fp;
@@ -250,16 +345,20 @@ OW_API void ow_make_map(ow_machine_t *om, size_t count) {
 	}
 	*data = ow_object_from(map);
 	om->callstack.regs.sp = data;
+	ow_malloc_set_allocator(prev_allocator);
 }
 
 OW_API int ow_make_exception(ow_machine_t *om, int type, const char *fmt, ...) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 	ow_unused_var(type); // TODO: Make exception of different type.
 	va_list ap;
 	va_start(ap, fmt);
 	struct ow_exception_obj *const exc_o =
 		ow_exception_format(om, NULL, fmt, ap);
 	va_end(ap);
+	ow_machine_stack_reserve(om, 1);
 	*++om->callstack.regs.sp = ow_object_from(exc_o);
+	ow_malloc_set_allocator(prev_allocator);
 	return 0;
 }
 
@@ -289,19 +388,20 @@ ow_noinline static int _compile_module_from_stream(
 	return ok ? 0 : OW_ERR_FAIL;
 }
 
-OW_API int ow_make_module(
+static int _make_module(
 		ow_machine_t *om, const char *name, const void *src, int flags) {
 	const int mode = flags & 0xf;
 
 	if (ow_unlikely(flags & OW_MKMOD_INCR)) {
 		assert(om->callstack.regs.fp >= om->callstack._data);
 		struct ow_object *const v = *om->callstack.regs.sp;
-		if (ow_smallint_check(v) ||
+		if (ow_object_is_immediate(v) ||
 				ow_object_class(v) != om->builtin_classes->module)
 			*om->callstack.regs.sp = ow_object_from(ow_module_obj_new(om));
 	} else {
 		struct ow_object *const v = ow_likely(mode != OW_MKMOD_LOAD) ?
 			ow_object_from(ow_module_obj_new(om)) : om->globals->value_nil;
+		ow_machine_stack_reserve(om, 1);
 		*++om->callstack.regs.sp = v;
 	}
 
@@ -354,6 +454,14 @@ OW_API int ow_make_module(
 	}
 }
 
+OW_API int ow_make_module(
+		ow_machine_t *om, const char *name, const void *src, int flags) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
+	const int status = _make_module(om, name, src, flags);
+	ow_malloc_set_allocator(prev_allocator);
+	return status;
+}
+
 OW_API int ow_load_local(ow_machine_t *om, int index) {
 	if (ow_likely(index < 0)) {
 		assert(om->callstack.frame_info_list.current);
@@ -361,14 +469,18 @@ OW_API int ow_load_local(ow_machine_t *om, int index) {
 			om->callstack.frame_info_list.current->arg_list + (size_t)(-index - 1);
 		if (ow_unlikely(vp >= om->callstack.regs.fp))
 			return OW_ERR_INDEX;
-		*++om->callstack.regs.sp = *vp;
+		struct ow_object *const v = *vp;
+		ow_machine_stack_reserve(om, 1);
+		*++om->callstack.regs.sp = v;
 		return 0;
 	} else if (ow_likely(index > 0)) {
 		assert(om->callstack.regs.fp >= om->callstack._data);
 		struct ow_object **const vp = om->callstack.regs.fp + (size_t)(index - 1);
 		if (ow_unlikely(vp > om->callstack.regs.sp))
 			return OW_ERR_INDEX;
-		*++om->callstack.regs.sp = *vp;
+		struct ow_object *const v = *vp;
+		ow_machine_stack_reserve(om, 1);
+		*++om->callstack.regs.sp = v;
 		return 0;
 	} else {
 		return OW_ERR_INDEX;
@@ -397,7 +509,7 @@ static struct ow_object *_get_local(ow_machine_t *om, int index) {
 	}
 }
 
-OW_API int ow_load_global(ow_machine_t *om, const char *name) {
+static int _load_global(ow_machine_t *om, const char *name) {
 	assert(name);
 	assert(om->callstack.frame_info_list.current);
 	assert(om->callstack.frame_info_list.current->arg_list - 1 >= om->callstack._data);
@@ -420,20 +532,25 @@ OW_API int ow_load_global(ow_machine_t *om, const char *name) {
 		if (ow_unlikely(!v))
 			return OW_ERR_INDEX;
 	}
+	ow_machine_stack_reserve(om, 1);
 	*++om->callstack.regs.sp = v;
 	return 0;
 }
 
-OW_API int ow_load_attribute(ow_machine_t *om, int index, const char *name) {
+OW_API int ow_load_global(ow_machine_t *om, const char *name) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
+	const int status = _load_global(om, name);
+	ow_malloc_set_allocator(prev_allocator);
+	return status;
+}
+
+static int _load_attribute(ow_machine_t *om, int index, const char *name) {
 	assert(name);
 	struct ow_object *const obj = _get_local(om, index);
 	if (ow_unlikely(!obj))
 		return OW_ERR_INDEX;
-	struct ow_class_obj *obj_class;
-	if (ow_unlikely(ow_smallint_check(obj)))
-		obj_class = om->builtin_classes->int_;
-	else
-		obj_class = ow_object_class(obj);
+	struct ow_class_obj *const obj_class =
+		ow_builtin_classes_class_of(om->builtin_classes, obj);
 	struct ow_symbol_obj *const name_o = ow_symbol_obj_new(om, name, (size_t)-1);
 	struct ow_object *attr;
 	if (obj_class == om->builtin_classes->module) {
@@ -450,13 +567,22 @@ OW_API int ow_load_attribute(ow_machine_t *om, int index, const char *name) {
 			return OW_ERR_INDEX;
 		}
 	}
+	ow_machine_stack_reserve(om, 1);
 	*++om->callstack.regs.sp = attr;
 	return 0;
 }
 
+OW_API int ow_load_attribute(ow_machine_t *om, int index, const char *name) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
+	const int status = _load_attribute(om, index, name);
+	ow_malloc_set_allocator(prev_allocator);
+	return status;
+}
+
 OW_API void ow_dup(ow_machine_t *om, size_t count) {
 	assert(om->callstack.regs.sp >= om->callstack.regs.fp);
 	struct ow_object *const v = *om->callstack.regs.sp;
+	ow_machine_stack_reserve(om, count);
 	while (count--)
 		*++om->callstack.regs.sp = v;
 }
@@ -472,7 +598,7 @@ OW_API int ow_read_nil(ow_machine_t *om, int index) {
 	struct ow_object *const v = _get_local(om, index);
 	if (ow_unlikely(!v))
 		return OW_ERR_INDEX;
-	if (ow_unlikely(ow_smallint_check(v)))
+	if (ow_unlikely(ow_object_is_immediate(v)))
 		return OW_ERR_TYPE;
 	if (ow_likely(ow_class_obj_is_base(
 			om->builtin_classes->nil, ow_object_class(v))))
@@ -490,7 +616,7 @@ OW_API int ow_read_bool(ow_machine_t *om, int index, bool *val_p) {
 	} else if (v == om->globals->value_false) {
 		*val_p = false;
 		return 0;
-	} else if (!ow_smallint_check(v) && ow_class_obj_is_base(
+	} else if (!ow_object_is_immediate(v) && ow_class_obj_is_base(
 			om->builtin_classes->bool_, ow_object_class(v))) {
 		*val_p = ow_bool_obj_value(ow_object_cast(v, struct ow_bool_obj));
 		return 0;
@@ -507,7 +633,7 @@ OW_API int ow_read_int(ow_machine_t *om, int index, intmax_t *val_p) {
 		*val_p = ow_smallint_from_ptr(v);
 		return 0;
 	}
-	if (ow_likely(ow_class_obj_is_base(
+	if (ow_likely(!ow_flonum_check(v) && ow_class_obj_is_base(
 			om->builtin_classes->int_, ow_object_class(v)))) {
 		*val_p = ow_int_obj_value(ow_object_cast(v, struct ow_int_obj));
 		return 0;
@@ -519,6 +645,10 @@ OW_API int ow_read_float(ow_machine_t *om, int index, double *val_p) {
 	struct ow_object *const v = _get_local(om, index);
 	if (ow_unlikely(!v))
 		return OW_ERR_INDEX;
+	if (ow_likely(ow_flonum_check(v))) {
+		*val_p = ow_flonum_from_ptr(v);
+		return 0;
+	}
 	if (ow_unlikely(ow_smallint_check(v)))
 		return OW_ERR_TYPE;
 	if (ow_likely(ow_class_obj_is_base(
@@ -534,7 +664,7 @@ OW_API int ow_read_symbol(
 	struct ow_object *const v = _get_local(om, index);
 	if (ow_unlikely(!v))
 		return OW_ERR_INDEX;
-	if (ow_unlikely(ow_smallint_check(v)))
+	if (ow_unlikely(ow_object_is_immediate(v)))
 		return OW_ERR_TYPE;
 	if (ow_unlikely(!ow_class_obj_is_base(
 			om->builtin_classes->symbol, ow_object_class(v))))
@@ -553,16 +683,18 @@ OW_API int ow_read_string(
 	struct ow_object *const v = _get_local(om, index);
 	if (ow_unlikely(!v))
 		return OW_ERR_INDEX;
-	if (ow_unlikely(ow_smallint_check(v)))
+	if (ow_unlikely(ow_object_is_immediate(v)))
 		return OW_ERR_TYPE;
 	if (ow_unlikely(!ow_class_obj_is_base(
 			om->builtin_classes->string, ow_object_class(v))))
 		return OW_ERR_TYPE;
 
 	struct ow_string_obj *const str_o = ow_object_cast(v, struct ow_string_obj);
-	if (str_p)
+	if (str_p) {
+		const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 		*str_p = ow_string_obj_flatten(om, str_o, len_p);
-	else if (len_p)
+		ow_malloc_set_allocator(prev_allocator);
+	} else if (len_p)
 		*len_p = ow_string_obj_size(str_o);
 	return 0;
 }
@@ -572,7 +704,7 @@ OW_API int ow_read_string_to(
 	struct ow_object *const v = _get_local(om, index);
 	if (ow_unlikely(!v))
 		return OW_ERR_INDEX;
-	if (ow_unlikely(ow_smallint_check(v)))
+	if (ow_unlikely(ow_object_is_immediate(v)))
 		return OW_ERR_TYPE;
 	if (ow_unlikely(!ow_class_obj_is_base(
 			om->builtin_classes->string, ow_object_class(v))))
@@ -596,7 +728,7 @@ size_t ow_read_array(ow_machine_t *om, int index, size_t elem_idx) {
 	struct ow_object *const v = _get_local(om, index);
 	if (ow_unlikely(!v))
 		return (size_t)OW_ERR_INDEX;
-	if (ow_unlikely(ow_smallint_check(v)))
+	if (ow_unlikely(ow_object_is_immediate(v)))
 		return (size_t)OW_ERR_TYPE;
 	if (ow_unlikely(!ow_class_obj_is_base(
 			om->builtin_classes->array, ow_object_class(v))))
@@ -606,12 +738,14 @@ size_t ow_read_array(ow_machine_t *om, int index, size_t elem_idx) {
 	const size_t len = ow_array_size(data);
 	assert(len < SIZE_MAX / 2);
 	if (ow_likely(elem_idx >= 1 && elem_idx <= len)) {
+		ow_machine_stack_reserve(om, 1);
 		*++om->callstack.regs.sp = ow_array_at(data, elem_idx - 1);
 		return 0;
 	}
 	if (elem_idx == 0)
 		return len;
 	if (elem_idx == (size_t)-1) {
+		ow_machine_stack_reserve(om, len);
 		for (size_t i = 0; i < len; i++)
 			*++om->callstack.regs.sp = ow_array_at(data, i);
 		return len;
@@ -623,7 +757,7 @@ size_t ow_read_tuple(ow_machine_t *om, int index, size_t elem_idx) {
 	struct ow_object *const v = _get_local(om, index);
 	if (ow_unlikely(!v))
 		return (size_t)OW_ERR_INDEX;
-	if (ow_unlikely(ow_smallint_check(v)))
+	if (ow_unlikely(ow_object_is_immediate(v)))
 		return (size_t)OW_ERR_TYPE;
 	if (ow_unlikely(!ow_class_obj_is_base(
 			om->builtin_classes->tuple, ow_object_class(v))))
@@ -631,6 +765,7 @@ size_t ow_read_tuple(ow_machine_t *om, int index, size_t elem_idx) {
 	struct ow_tuple_obj *const tuple_obj = ow_object_cast(v, struct ow_tuple_obj);
 	struct ow_object *const elem = ow_tuple_obj_get(tuple_obj, elem_idx - 1);
 	if (ow_likely(elem)) {
+		ow_machine_stack_reserve(om, 1);
 		*++om->callstack.regs.sp = elem;
 		return 0;
 	}
@@ -639,6 +774,7 @@ size_t ow_read_tuple(ow_machine_t *om, int index, size_t elem_idx) {
 	if (elem_idx == 0)
 		return len;
 	if (elem_idx == (size_t)-1) {
+		ow_machine_stack_reserve(om, len);
 		struct ow_object **const start = om->callstack.regs.sp + 1;
 		om->callstack.regs.sp += len;
 		const size_t copied_cnt = ow_tuple_obj_copy(tuple_obj, 0, len, start, len);
@@ -659,7 +795,7 @@ OW_API size_t ow_read_set(ow_machine_t *om, int index, int op) {
 	struct ow_object *const v = _get_local(om, index);
 	if (ow_unlikely(!v))
 		return (size_t)OW_ERR_INDEX;
-	if (ow_unlikely(ow_smallint_check(v)))
+	if (ow_unlikely(ow_object_is_immediate(v)))
 		return (size_t)OW_ERR_TYPE;
 	if (ow_unlikely(!ow_class_obj_is_base(
 			om->builtin_classes->set, ow_object_class(v))))
@@ -670,6 +806,7 @@ OW_API size_t ow_read_set(ow_machine_t *om, int index, int op) {
 	if (op == 0)
 		return len;
 	if (op == -1) {
+		ow_machine_stack_reserve(om, len);
 		ow_set_obj_foreach(set_obj, _set_expand_walker, om);
 		return len;
 	}
@@ -688,7 +825,7 @@ OW_API size_t ow_read_map(ow_machine_t *om, int index, int key_idx) {
 	struct ow_object *const v = _get_local(om, index);
 	if (ow_unlikely(!v))
 		return (size_t)OW_ERR_INDEX;
-	if (ow_unlikely(ow_smallint_check(v)))
+	if (ow_unlikely(ow_object_is_immediate(v)))
 		return (size_t)OW_ERR_TYPE;
 	if (ow_unlikely(!ow_class_obj_is_base(
 			om->builtin_classes->map, ow_object_class(v))))
@@ -698,9 +835,12 @@ OW_API size_t ow_read_map(ow_machine_t *om, int index, int key_idx) {
 		struct ow_object *const kv = _get_local(om, key_idx);
 		if (!kv)
 			return (size_t)OW_ERR_FAIL;
+		const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 		struct ow_object *const res = ow_map_obj_get(om, map_obj, kv);
+		ow_malloc_set_allocator(prev_allocator);
 		if (ow_unlikely(!res))
 			return (size_t)OW_ERR_FAIL;
+		ow_machine_stack_reserve(om, 1);
 		*++om->callstack.regs.sp = res;
 		return 0;
 	}
@@ -708,6 +848,7 @@ OW_API size_t ow_read_map(ow_machine_t *om, int index, int key_idx) {
 	if (key_idx == OW_RDMAP_GETLEN)
 		return len;
 	if (key_idx == OW_RDMAP_EXPAND) {
+		ow_machine_stack_reserve(om, len * 2);
 		ow_map_obj_foreach(map_obj, _map_expand_walker, om);
 		return len;
 	}
@@ -718,16 +859,18 @@ OW_API int ow_read_exception(ow_machine_t *om, int index, int flags, ...) {
 	struct ow_object *const v = _get_local(om, index);
 	if (ow_unlikely(!v))
 		return OW_ERR_INDEX;
-	if (ow_unlikely(ow_smallint_check(v)))
+	if (ow_unlikely(ow_object_is_immediate(v)))
 		return OW_ERR_TYPE;
 	if (ow_unlikely(!ow_class_obj_is_base(
 			om->builtin_classes->exception, ow_object_class(v))))
 		return OW_ERR_TYPE;
 
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 	const int flags_target = flags & 0xf0;
 	struct ow_exception_obj *const exc_o =
 		ow_object_cast(v, struct ow_exception_obj);
 	if (flags_target == OW_RDEXC_PUSH) {
+		ow_machine_stack_reserve(om, 1);
 		*++om->callstack.regs.sp = ow_exception_obj_data(exc_o);
 	} else {
 		va_list ap;
@@ -760,6 +903,7 @@ OW_API int ow_read_exception(ow_machine_t *om, int index, int flags, ...) {
 		va_end(ap);
 	}
 
+	ow_malloc_set_allocator(prev_allocator);
 	return 0;
 }
 
@@ -777,6 +921,7 @@ OW_API int ow_read_args(ow_machine_t *om, int flags, const char *fmt, ...) {
 		return 0;
 	}
 
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 	va_start(ap, fmt);
 	status = 0;
 	for (int index = -1; ; index--) {
@@ -826,7 +971,9 @@ OW_API int ow_read_args(ow_machine_t *om, int flags, const char *fmt, ...) {
 				if (flags & OW_RDARG_MKEXC) {
 					const char *const type_name =
 						ow_symbol_obj_data(ow_class_obj_pub_info(
-							ow_object_class(_get_local(om, index)))->class_name);
+							ow_builtin_classes_class_of(om->builtin_classes,
+								_get_local(om, index)))->class_name);
+					ow_machine_stack_reserve(om, 1);
 					*++om->callstack.regs.sp = ow_object_from(ow_exception_format(om, NULL,
 						"unexpected %s object for argument %i", type_name, -index));
 					status = OW_ERR_FAIL;
@@ -834,6 +981,7 @@ OW_API int ow_read_args(ow_machine_t *om, int flags, const char *fmt, ...) {
 				break;
 			} else if (status == OW_ERR_FAIL) {
 				if (flags & OW_RDARG_MKEXC) {
+					ow_machine_stack_reserve(om, 1);
 					*++om->callstack.regs.sp = ow_object_from(
 						ow_exception_format(om, NULL, "illegal usage of API"));
 					status = OW_ERR_FAIL;
@@ -845,6 +993,7 @@ OW_API int ow_read_args(ow_machine_t *om, int flags, const char *fmt, ...) {
 		}
 	}
 	va_end(ap);
+	ow_malloc_set_allocator(prev_allocator);
 
 	return status;
 }
@@ -870,7 +1019,7 @@ OW_API int ow_store_local(ow_machine_t *om, int index) {
 	}
 }
 
-OW_API int ow_store_global(ow_machine_t *om, const char *name) {
+static int _store_global(ow_machine_t *om, const char *name) {
 	assert(name);
 	assert(om->callstack.frame_info_list.current);
 	assert(om->callstack.frame_info_list.current->arg_list - 1 >= om->callstack._data);
@@ -886,10 +1035,17 @@ OW_API int ow_store_global(ow_machine_t *om, const char *name) {
 	else
 		return OW_ERR_INDEX;
 	struct ow_symbol_obj *const name_o = ow_symbol_obj_new(om, name, (size_t)-1);
-	ow_module_obj_set_global_y(module, name_o, *om->callstack.regs.sp--);
+	ow_module_obj_set_global_y(om, module, name_o, *om->callstack.regs.sp--);
 	return 0;
 }
 
+OW_API int ow_store_global(ow_machine_t *om, const char *name) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
+	const int status = _store_global(om, name);
+	ow_malloc_set_allocator(prev_allocator);
+	return status;
+}
+
 OW_API int ow_drop(ow_machine_t *om, int count) {
 	struct ow_object **const fp_m1 = om->callstack.regs.fp - 1;
 	struct ow_object **new_sp = om->callstack.regs.sp - (size_t)(unsigned)count;
@@ -900,6 +1056,7 @@ OW_API int ow_drop(ow_machine_t *om, int count) {
 }
 
 OW_API int ow_invoke(ow_machine_t *om, int argc, int flags) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 	int status;
 	struct ow_object *result;
 
@@ -911,7 +1068,7 @@ OW_API int ow_invoke(ow_machine_t *om, int argc, int flags) {
 		status = ow_machine_invoke(om, argc, &result);
 	} else if (mode == OW_IVK_METHOD) {
 		struct ow_object *const name_o = *(om->callstack.regs.sp - argc);
-		if (ow_unlikely(ow_smallint_check(name_o) ||
+		if (ow_unlikely(ow_object_is_immediate(name_o) ||
 				ow_object_class(name_o) != om->builtin_classes->symbol)) {
 			result = ow_object_from(ow_exception_format(
 				om, NULL, "%s is not a %s object", "method name", "Symbol"));
@@ -922,7 +1079,7 @@ OW_API int ow_invoke(ow_machine_t *om, int argc, int flags) {
 			om, ow_object_cast(name_o, struct ow_symbol_obj), argc, NULL, &result);
 	} else if (mode == OW_IVK_MODULE) {
 		struct ow_object *const mod_o = *(om->callstack.regs.sp - argc);
-		if (ow_unlikely(ow_smallint_check(mod_o) ||
+		if (ow_unlikely(ow_object_is_immediate(mod_o) ||
 				ow_object_class(mod_o) != om->builtin_classes->module)) {
 			result = ow_object_from(ow_exception_format(
 				om, NULL, "%s is not a %s object", "module", "Module"));
@@ -940,11 +1097,13 @@ OW_API int ow_invoke(ow_machine_t *om, int argc, int flags) {
 	if (ow_unlikely(status) || !(flags & OW_IVK_NORETVAL))
 		*++om->callstack.regs.sp = result;
 
+	ow_malloc_set_allocator(prev_allocator);
 	assert(status == 0 || status == OW_ERR_FAIL);
 	return status;
 }
 
 OW_API int ow_syscmd(ow_machine_t *om, int name, ...) {
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 	int status = 0;
 	va_list ap;
 	va_start(ap, name);
@@ -961,5 +1120,6 @@ OW_API int ow_syscmd(ow_machine_t *om, int name, ...) {
 	}
 
 	va_end(ap);
+	ow_malloc_set_allocator(prev_allocator);
 	return status;
 }
@@ -187,7 +187,8 @@ static const char *write_operand_comment(
 	}
 	if (opcode == OW_OPC_Jmp     || opcode == OW_OPC_JmpW ||
 		opcode == OW_OPC_JmpWhen || opcode == OW_OPC_JmpWhenW ||
-		opcode == OW_OPC_JmpUnls || opcode == OW_OPC_JmpUnlsW) {
+		opcode == OW_OPC_JmpUnls || opcode == OW_OPC_JmpUnlsW ||
+		(opcode >= OW_OPC_JmpUnlsLt && opcode <= OW_OPC_JmpUnlsNeW)) {
 		snprintf(buf, buf_sz, "target=%04zx", (offset + (ptrdiff_t)operand));
 		return buf;
 	}
@@ -205,6 +206,26 @@ static const char *write_operand_comment(
 		}
 		return NULL;
 	}
+	if (opcode == OW_OPC_LdLoc2 || opcode == OW_OPC_AddLoc2 ||
+		opcode == OW_OPC_SubLoc2) {
+		snprintf(buf, buf_sz, "loc=%i,%i", operand & 0xff, operand >> 8);
+		return buf;
+	}
+	if (opcode == OW_OPC_IncLoc || opcode == OW_OPC_DecLoc) {
+		snprintf(buf, buf_sz, "loc=%i, val=%i", operand & 0xff, (int8_t)(operand >> 8));
+		return buf;
+	}
+	if (opcode == OW_OPC_LdLocMethY) {
+		const char *name = "?";
+		if (func) {
+			struct ow_symbol_obj *const v =
+				ow_func_obj_get_symbol(func, (size_t)(operand >> 8));
+			if (v)
+				name = ow_symbol_obj_data(v);
+		}
+		snprintf(buf, buf_sz, "loc=%i, %s", operand & 0xff, name);
+		return buf;
+	}
 	if (opcode == OW_OPC_LdGlob || opcode == OW_OPC_LdGlobW ||
 		opcode == OW_OPC_StGlob || opcode == OW_OPC_StGlobW) {
 		if (func) {
@@ -90,6 +90,41 @@
 	ELEM(MkSetW     , 0x55, u16) \
 	ELEM(MkMap      , 0x56,  u8) \
 	ELEM(MkMapW     , 0x57, u16) \
+	ELEM(LdLoc2     , 0x58, u16) \
+	ELEM(AddLoc2    , 0x59, u16) \
+	ELEM(SubLoc2    , 0x5a, u16) \
+	ELEM(IncLoc     , 0x5b, u16) \
+	ELEM(LdLocMethY , 0x5c, u16) \
+	ELEM(JmpUnlsLt  , 0x5d,  i8) \
+	ELEM(JmpUnlsLtW , 0x5e, i16) \
+	ELEM(JmpUnlsLe  , 0x5f,  i8) \
+	ELEM(JmpUnlsLeW , 0x60, i16) \
+	ELEM(JmpUnlsGt  , 0x61,  i8) \
+	ELEM(JmpUnlsGtW , 0x62, i16) \
+	ELEM(JmpUnlsGe  , 0x63,  i8) \
+	ELEM(JmpUnlsGeW , 0x64, i16) \
+	ELEM(JmpUnlsEq  , 0x65,  i8) \
+	ELEM(JmpUnlsEqW , 0x66, i16) \
+	ELEM(JmpUnlsNe  , 0x67,  i8) \
+	ELEM(JmpUnlsNeW , 0x68, i16) \
+	ELEM(AddSmi     , 0x69,   0) \
+	ELEM(SubSmi     , 0x6a,   0) \
+	ELEM(MulSmi     , 0x6b,   0) \
+	ELEM(CmpLtSmi   , 0x6c,   0) \
+	ELEM(CmpLeSmi   , 0x6d,   0) \
+	ELEM(CmpGtSmi   , 0x6e,   0) \
+	ELEM(CmpGeSmi   , 0x6f,   0) \
+	ELEM(CmpEqSmi   , 0x70,   0) \
+	ELEM(CmpNeSmi   , 0x71,   0) \
+	ELEM(AddFlt     , 0x72,   0) \
+	ELEM(SubFlt     , 0x73,   0) \
+	ELEM(MulFlt     , 0x74,   0) \
+	ELEM(DivFlt     , 0x75,   0) \
+	ELEM(CmpLtFlt   , 0x76,   0) \
+	ELEM(CmpLeFlt   , 0x77,   0) \
+	ELEM(CmpGtFlt   , 0x78,   0) \
+	ELEM(CmpGeFlt   , 0x79,   0) \
+	ELEM(DecLoc     , 0x7a, u16) \
 // ^^^ OW_OPCODE_LIST ^^^
 
 /// Opcodes.
@@ -11,6 +11,8 @@
 
 typedef LONG  volatile __declspec(align(32)) atomic_int;
 typedef ULONG volatile __declspec(align(32)) atomic_uint;
+typedef CHAR volatile atomic_bool;
+typedef ULONG64 volatile atomic_uint_least64_t;
 
 #define atomic_store(obj_ptr, desired) \
 	InterlockedExchange((LONG *)obj_ptr, (LONG)desired)
@@ -22,4 +24,9 @@ typedef ULONG volatile __declspec(align(32)) atomic_uint;
 #define atomic_fetch_sub(obj_ptr, value) \
 	InterlockedExchangeAdd((LONG *)obj_ptr, -(LONG)(value))
 
+#define atomic_fetch_or(obj_ptr, value) \
+	InterlockedOr64((LONG64 *)obj_ptr, (LONG64)value) // 64-bit objects only.
+#define atomic_exchange(obj_ptr, desired) \
+	InterlockedExchange8((CHAR *)obj_ptr, (CHAR)desired) // 8-bit objects only.
+
 #endif // !__STDC_NO_ATOMICS__
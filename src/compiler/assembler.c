@@ -4,6 +4,7 @@
 #include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <machine/machine.h>
@@ -137,6 +138,16 @@ size_t ow_assembler_constant(struct ow_assembler *as, struct ow_assembler_consta
 
 	for (size_t i = 0, cnt = ow_array_size(&as->constants); i < cnt; i++) {
 		struct ow_object *const obj = ow_array_at(&as->constants, i);
+		if (ow_smallint_check(obj)) {
+			if (v.type == OW_AS_CONST_INT && ow_smallint_from_ptr(obj) == v.i)
+				return i;
+			continue;
+		}
+		if (ow_flonum_check(obj)) {
+			if (v.type == OW_AS_CONST_FLT && ow_flonum_from_ptr(obj) == v.f)
+				return i;
+			continue;
+		}
 		if (ow_object_class(obj) != const_class)
 			continue;
 		switch (v.type) {
@@ -169,7 +180,7 @@ size_t ow_assembler_constant(struct ow_assembler *as, struct ow_assembler_consta
 		obj = ow_object_from(ow_int_obj_or_smallint(om, v.i));
 		break;
 	case OW_AS_CONST_FLT:
-		obj = ow_object_from(ow_float_obj_new(om, v.f));
+		obj = ow_float_obj_or_flonum(om, v.f);
 		break;
 	case OW_AS_CONST_STR:
 		obj = ow_object_from(ow_string_obj_new(om, v.s.p, v.s.n));
@@ -272,8 +283,293 @@ static enum ow_opcode _opcode_to_wide(enum ow_opcode opcode) {
 	return opcode_w;
 }
 
+/// Make a u16 operand from two u8 values.
+static union ow_operand _operand_pack2(uint8_t lo, uint8_t hi) {
+	return (union ow_operand){.u16 = (uint16_t)(lo | (unsigned int)hi << 8)};
+}
+
+/// Try to combine the leading instructions of `seq` (`n` of them, at least 1)
+/// into a superinstruction. If succeeded, store it to `*res` and return the number
+/// of instructions replaced; otherwise, return 0.
+static size_t _combine_instructions(
+		const struct instr_data *seq, size_t n, struct instr_data *res) {
+	const enum ow_opcode opc0 = seq[0].opcode;
+
+	if (opc0 == OW_OPC_LdLoc && n >= 2) {
+		const enum ow_opcode opc1 = seq[1].opcode;
+		const uint8_t loc0 = seq[0].operand.u8;
+
+		if (opc1 == OW_OPC_LdInt && n >= 4 &&
+				(seq[2].opcode == OW_OPC_Add || seq[2].opcode == OW_OPC_Sub) &&
+				seq[3].opcode == OW_OPC_StLoc && seq[3].operand.u8 == loc0) {
+			// The StLoc is kept. It is skipped unless the operator is called.
+			res->opcode = seq[2].opcode == OW_OPC_Add ? OW_OPC_IncLoc : OW_OPC_DecLoc;
+			res->operand = _operand_pack2(loc0, (uint8_t)seq[1].operand.i8);
+			return 3;
+		}
+
+		if (opc1 == OW_OPC_LdLoc) {
+			const uint8_t loc1 = seq[1].operand.u8;
+			res->operand = _operand_pack2(loc0, loc1);
+			if (n >= 3 && seq[2].opcode == OW_OPC_Add) {
+				res->opcode = OW_OPC_AddLoc2;
+				return 3;
+			}
+			if (n >= 3 && seq[2].opcode == OW_OPC_Sub) {
+				res->opcode = OW_OPC_SubLoc2;
+				return 3;
+			}
+			res->opcode = OW_OPC_LdLoc2;
+			return 2;
+		}
+
+		if (opc1 == OW_OPC_PrepMethY) {
+			res->opcode = OW_OPC_LdLocMethY;
+			res->operand = _operand_pack2(loc0, seq[1].operand.u8);
+			return 2;
+		}
+
+		return 0;
+	}
+
+	if (opc0 >= OW_OPC_CmpLt && opc0 <= OW_OPC_CmpNe && n >= 2 &&
+			seq[1].opcode == OW_OPC_JmpUnls && seq[1].operand_is_label) {
+		static_assert(OW_OPC_CmpNe - OW_OPC_CmpLt == 5, "");
+		static_assert(OW_OPC_JmpUnlsNe - OW_OPC_JmpUnlsLt == 5 * 2, "");
+		res->opcode = (uint8_t)(OW_OPC_JmpUnlsLt + (opc0 - OW_OPC_CmpLt) * 2);
+		res->operand_is_label = true;
+		res->operand = seq[1].operand;
+		return 2;
+	}
+
+	return 0;
+}
+
+/// Replace common instruction sequences with superinstructions.
+/// A sequence is kept as it is if any instruction except the first one is a jump target.
+static void _make_superinstructions(struct ow_assembler *as) {
+	const size_t instr_seq_len = instr_array_size(&as->instr_seq);
+	const size_t label_count = ow_array_size(&as->labels);
+	if (instr_seq_len < 2)
+		return;
+
+	bool *const is_jump_target = ow_malloc(instr_seq_len + 1);
+	memset(is_jump_target, 0, instr_seq_len + 1);
+	for (size_t i = 0; i < label_count; i++) {
+		const size_t lbl_instr_idx = (uintptr_t)ow_array_at(&as->labels, i);
+		if (lbl_instr_idx <= instr_seq_len)
+			is_jump_target[lbl_instr_idx] = true;
+	}
+
+	size_t *const index_map = ow_malloc(sizeof(size_t) * (instr_seq_len + 1));
+	struct instr_data *const seq = instr_array_ref(&as->instr_seq, 0);
+	size_t new_len = 0;
+	for (size_t i = 0; i < instr_seq_len; ) {
+		size_t n = 1;
+		while (i + n < instr_seq_len && n < 4 && !is_jump_target[i + n])
+			n++;
+
+		struct instr_data res = seq[i];
+		res.operand_is_label = false;
+		size_t replaced_n = _combine_instructions(seq + i, n, &res);
+		if (!replaced_n) {
+			res = seq[i];
+			replaced_n = 1;
+		}
+
+		for (size_t j = 0; j < replaced_n; j++)
+			index_map[i + j] = new_len;
+		seq[new_len++] = res;
+		i += replaced_n;
+	}
+	index_map[instr_seq_len] = new_len;
+
+	if (new_len != instr_seq_len) {
+		instr_array_drop(&as->instr_seq, instr_seq_len - new_len);
+		for (size_t i = 0; i < label_count; i++) {
+			const size_t lbl_instr_idx = (uintptr_t)ow_array_at(&as->labels, i);
+			if (lbl_instr_idx <= instr_seq_len)
+				ow_array_at(&as->labels, i) = (void *)(uintptr_t)index_map[lbl_instr_idx];
+		}
+	}
+
+	ow_free(index_map);
+	ow_free(is_jump_target);
+}
+
+/// Get number of values that an instruction pops from and pushes onto the stack.
+static void _instr_stack_effect(
+		const struct instr_data *instr, size_t *pop, size_t *push) {
+	const union ow_operand operand = instr->operand;
+	switch ((enum ow_opcode)instr->opcode) {
+	case OW_OPC_LdNil:
+	case OW_OPC_LdBool:
+	case OW_OPC_LdInt:
+	case OW_OPC_LdIntW:
+	case OW_OPC_LdFlt:
+	case OW_OPC_LdCnst:
+	case OW_OPC_LdCnstW:
+	case OW_OPC_LdSym:
+	case OW_OPC_LdSymW:
+	case OW_OPC_LdArg:
+	case OW_OPC_LdLoc:
+	case OW_OPC_LdLocW:
+	case OW_OPC_LdGlob:
+	case OW_OPC_LdGlobW:
+	case OW_OPC_LdGlobY:
+	case OW_OPC_LdGlobYW:
+	case OW_OPC_LdMod:
+	case OW_OPC_Dup:
+	case OW_OPC_AddLoc2:
+	case OW_OPC_SubLoc2:
+		*pop = 0, *push = 1;
+		return;
+	case OW_OPC_LdLoc2:
+	case OW_OPC_LdLocMethY:
+		*pop = 0, *push = 2;
+		return;
+	case OW_OPC_DupN:
+		*pop = 0, *push = operand.u8;
+		return;
+	case OW_OPC_Drop:
+	case OW_OPC_StArg:
+	case OW_OPC_StLoc:
+	case OW_OPC_StLocW:
+	case OW_OPC_StGlob:
+	case OW_OPC_StGlobW:
+	case OW_OPC_StGlobY:
+	case OW_OPC_StGlobYW:
+	case OW_OPC_JmpWhen:
+	case OW_OPC_JmpWhenW:
+	case OW_OPC_JmpUnls:
+	case OW_OPC_JmpUnlsW:
+	case OW_OPC_RetLoc:
+	case OW_OPC_Ret:
+		*pop = 1, *push = 0;
+		return;
+	case OW_OPC_DropN:
+		*pop = operand.u8, *push = 0;
+		return;
+	case OW_OPC_StAttrY:
+	case OW_OPC_StAttrYW:
+	case OW_OPC_JmpUnlsLt:
+	case OW_OPC_JmpUnlsLtW:
+	case OW_OPC_JmpUnlsLe:
+	case OW_OPC_JmpUnlsLeW:
+	case OW_OPC_JmpUnlsGt:
+	case OW_OPC_JmpUnlsGtW:
+	case OW_OPC_JmpUnlsGe:
+	case OW_OPC_JmpUnlsGeW:
+	case OW_OPC_JmpUnlsEq:
+	case OW_OPC_JmpUnlsEqW:
+	case OW_OPC_JmpUnlsNe:
+	case OW_OPC_JmpUnlsNeW:
+		*pop = 2, *push = 0;
+		return;
+	case OW_OPC_StElem:
+		*pop = 3, *push = 0;
+		return;
+	case OW_OPC_Neg:
+	case OW_OPC_Inv:
+	case OW_OPC_Not:
+	case OW_OPC_Test:
+	case OW_OPC_LdAttrY:
+	case OW_OPC_LdAttrYW:
+		*pop = 1, *push = 1;
+		return;
+	case OW_OPC_PrepMethY:
+	case OW_OPC_PrepMethYW:
+		*pop = 1, *push = 2;
+		return;
+	case OW_OPC_IncLoc:
+	case OW_OPC_DecLoc:
+		*pop = 0, *push = 1; // Result of the operator, if called, for the next StLoc.
+		return;
+	case OW_OPC_Call:
+		*pop = (operand.u8 & 0x7f) + 1u, *push = (operand.u8 & 0x80) ? 0 : 1;
+		return;
+	case OW_OPC_MkArr:
+	case OW_OPC_MkTup:
+	case OW_OPC_MkSet:
+		*pop = operand.u8, *push = 1;
+		return;
+	case OW_OPC_MkArrW:
+	case OW_OPC_MkTupW:
+	case OW_OPC_MkSetW:
+		*pop = operand.u16, *push = 1;
+		return;
+	case OW_OPC_MkMap:
+		*pop = operand.u8 * 2u, *push = 1;
+		return;
+	case OW_OPC_MkMapW:
+		*pop = operand.u16 * 2u, *push = 1;
+		return;
+	default:
+		if (instr->opcode >= OW_OPC_Add && instr->opcode <= OW_OPC_Xor)
+			*pop = 2, *push = 1;
+		else if (instr->opcode >= OW_OPC_Is && instr->opcode <= OW_OPC_CmpNe)
+			*pop = 2, *push = 1;
+		else if (instr->opcode >= OW_OPC_AddSmi && instr->opcode <= OW_OPC_CmpGeFlt)
+			*pop = 2, *push = 1;
+		else if (instr->opcode == OW_OPC_LdElem)
+			*pop = 2, *push = 1;
+		else
+			*pop = 0, *push = 0; // Nop, Swap, SwapN, Jmp, RetNil, etc.
+		return;
+	}
+}
+
+/// Compute the max number of temporary values on stack when running the code.
+/// The result can be larger than the real one but shall never be smaller.
+static size_t _max_stack_depth(struct ow_assembler *as) {
+	const size_t instr_seq_len = instr_array_size(&as->instr_seq);
+	// Stack depth before each instruction, including the depths that forward
+	// jumps bring to their targets.
+	size_t *const depth_at = ow_calloc(instr_seq_len + 1, sizeof(size_t));
+
+	size_t depth = 0, max_depth = 0;
+	for (size_t i = 0; i < instr_seq_len; i++) {
+		const struct instr_data *const instr = instr_array_ref(&as->instr_seq, i);
+		if (depth_at[i] > depth)
+			depth = depth_at[i];
+		depth_at[i] = depth;
+
+		size_t pop, push;
+		_instr_stack_effect(instr, &pop, &push);
+		depth = depth > pop ? depth - pop : 0;
+		depth += push;
+		if (depth > max_depth)
+			max_depth = depth;
+
+		if (instr->operand_is_label) {
+			const size_t lbl_instr_idx =
+				(uintptr_t)ow_array_at(&as->labels, instr->operand.u16);
+			assert(lbl_instr_idx <= instr_seq_len);
+			if (lbl_instr_idx > i) {
+				if (depth_at[lbl_instr_idx] < depth)
+					depth_at[lbl_instr_idx] = depth;
+			} else if (ow_unlikely(depth > depth_at[lbl_instr_idx])) {
+				// A loop leaves more values than it found, which the code
+				// generator never does. The depth would not be bounded.
+				abort(); // Unbalanced loop.
+			}
+		}
+
+		const enum ow_opcode opcode = (enum ow_opcode)instr->opcode;
+		if (opcode == OW_OPC_Jmp || opcode == OW_OPC_JmpW || opcode == OW_OPC_Ret ||
+				opcode == OW_OPC_RetNil || opcode == OW_OPC_RetLoc)
+			depth = 0; // The next instruction is reachable only by jumping.
+	}
+
+	ow_free(depth_at);
+	return max_depth;
+}
+
 struct ow_func_obj *ow_assembler_output(
 		struct ow_assembler *as, const struct ow_assembler_output_spec *spec) {
+	_make_superinstructions(as);
+	const size_t max_stack = _max_stack_depth(as);
+
 	const size_t instr_seq_len = instr_array_size(&as->instr_seq);
 	size_t *const addr_map = ow_malloc(sizeof(size_t) * (instr_seq_len + 1));
 
@@ -298,6 +594,8 @@ struct ow_func_obj *ow_assembler_output(
 					instr->operand.i8 = (int8_t)offset;
 					code_seq_len += 1 + 1;
 				} else if (offset >= INT16_MIN) {
+					instr->opcode = (uint8_t)_opcode_to_wide(
+						(enum ow_opcode)instr->opcode);
 					instr->operand.i16 = (int16_t)offset;
 					code_seq_len += 1 + 2;
 				} else {
@@ -367,11 +665,14 @@ struct ow_func_obj *ow_assembler_output(
 	assert((size_t)(code_seq_ptr - code_seq) <= code_seq_len);
 	code_seq_len = (size_t)(code_seq_ptr - code_seq);
 
+	struct ow_func_spec func_spec = spec->func_spec;
+	func_spec.max_stack = (unsigned int)max_stack;
+
 	struct ow_func_obj *const func = ow_func_obj_new(
 		as->machine, spec->module,
 		(struct ow_object **)ow_array_data(&as->constants), ow_array_size(&as->constants),
 		(struct ow_symbol_obj **)ow_array_data(&as->symbols), ow_array_size(&as->symbols),
-		code_seq, code_seq_len, spec->func_spec
+		code_seq, code_seq_len, func_spec
 	);
 
 	ow_free(code_seq);
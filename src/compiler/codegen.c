@@ -1392,7 +1392,7 @@ static void _scope_update_module_globals(
 		struct ow_sharedstr *const ss = ctx->names[i - orig_count];
 		struct ow_symbol_obj *const sym =
 			ow_symbol_obj_new(om, ow_sharedstr_data(ss), ow_sharedstr_size(ss));
-		const size_t idx = ow_module_obj_set_global_y(module, sym, nil);
+		const size_t idx = ow_module_obj_set_global_y(om, module, sym, nil);
 		ow_unused_var(idx);
 		assert(idx == i);
 	}
@@ -1420,13 +1420,13 @@ static void ow_codegen_emit_Module(
 
 	struct ow_func_obj *const func = code_stack_make_func_and_pop(
 		&codegen->code_stack, &(struct ow_assembler_output_spec){
-			codegen->module, (struct ow_func_spec){0, 0}});
+			codegen->module, (struct ow_func_spec){0, 0, 0}});
 	_scope_update_module_globals(scope, codegen->machine, codegen->module);
 	scope_stack_pop(&codegen->scope_stack);
 
 	ow_objmem_push_ngc(codegen->machine);
 	struct ow_symbol_obj *const func_name = codegen->machine->common_symbols->anon;
-	ow_module_obj_set_global_y(codegen->module, func_name, ow_object_from(func));
+	ow_module_obj_set_global_y(codegen->machine, codegen->module, func_name, ow_object_from(func));
 	ow_objmem_pop_ngc(codegen->machine);
 
 #if OW_DEBUG_CODEGEN
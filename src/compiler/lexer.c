@@ -45,7 +45,10 @@ static const struct ow_hashmap_funcs _ow_lexer_keywords_map_funcs = {
 ow_noinline static void _ow_lexer_keywords_map_fini(void) {
 	assert(_ow_lexer_keywords_map._size != 0);
 
+	const struct ow_allocator *const allocator = ow_malloc_get_allocator();
+	ow_malloc_set_allocator(NULL);
 	ow_hashmap_fini(&_ow_lexer_keywords_map);
+	ow_malloc_set_allocator(allocator);
 	_ow_lexer_keywords_map._size = 0;
 }
 
@@ -65,12 +68,16 @@ ow_noinline static void _ow_lexer_keywords_map_init(void) {
 	};
 	const size_t kw_count = sizeof kw_names / sizeof kw_names[0];
 
+	// The map is shared by all machines, so not with the allocator of any of them.
+	const struct ow_allocator *const allocator = ow_malloc_get_allocator();
+	ow_malloc_set_allocator(NULL);
 	ow_hashmap_init(&_ow_lexer_keywords_map, kw_count);
 	for (size_t i = 0; i < kw_count; i++) {
 		ow_hashmap_set(
 			&_ow_lexer_keywords_map, &_ow_lexer_keywords_map_funcs,
 			kw_names[i], (void *)(uintptr_t)kw_tokens[i]);
 	}
+	ow_malloc_set_allocator(allocator);
 	assert(ow_hashmap_size(&_ow_lexer_keywords_map) == kw_count);
 
 	atexit(_ow_lexer_keywords_map_fini);
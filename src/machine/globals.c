@@ -8,6 +8,7 @@
 #include <objects/memory.h>
 #include <objects/nilobj.h>
 #include <objects/object.h>
+#include <objects/shapeobj.h>
 #include <utilities/malloc.h>
 
 struct ow_machine_globals *ow_machine_globals_new(struct ow_machine *om) {
@@ -16,6 +17,7 @@ struct ow_machine_globals *ow_machine_globals_new(struct ow_machine *om) {
 	mg->value_nil = ow_object_from(_ow_nil_obj_new(om));
 	mg->value_true = ow_object_from(_ow_bool_obj_new(om, 1));
 	mg->value_false = ow_object_from(_ow_bool_obj_new(om, 0));
+	mg->empty_shape = ow_shape_obj_new(om);
 	mg->module_base = ow_module_manager_load(om->module_manager, "__base__", 0, NULL);
 	mg->module_sys = ow_module_manager_load(om->module_manager, "sys", 0, NULL);
 	ow_objmem_pop_ngc(om);
@@ -33,5 +35,6 @@ void _ow_machine_globals_gc_marker(
 	ow_objmem_object_gc_marker(om, ow_object_from(mg->value_nil));
 	ow_objmem_object_gc_marker(om, ow_object_from(mg->value_true));
 	ow_objmem_object_gc_marker(om, ow_object_from(mg->value_false));
+	ow_objmem_object_gc_marker(om, ow_object_from(mg->empty_shape));
 	ow_objmem_object_gc_marker(om, ow_object_from(mg->module_base));
 }
@@ -3,12 +3,14 @@
 struct ow_machine;
 struct ow_module_obj;
 struct ow_object;
+struct ow_shape_obj;
 
 /// Global data for a context.
 struct ow_machine_globals {
 	struct ow_object *value_nil;
 	struct ow_object *value_true;
 	struct ow_object *value_false;
+	struct ow_shape_obj *empty_shape;
 	struct ow_module_obj *module_base;
 	struct ow_module_obj *module_sys;
 };
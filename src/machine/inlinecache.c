@@ -0,0 +1,67 @@
+#include "inlinecache.h"
+
+#include <string.h>
+
+#include <objects/memory.h>
+#include <objects/object.h>
+#include <utilities/malloc.h>
+
+struct ow_inline_cache *ow_inline_cache_array_new(size_t count) {
+	return ow_calloc(count, sizeof(struct ow_inline_cache));
+}
+
+void ow_inline_cache_array_del(struct ow_inline_cache *array) {
+	ow_free(array);
+}
+
+void ow_inline_cache_update(
+		struct ow_inline_cache *ic, struct ow_class_obj *class_, intptr_t member) {
+	struct ow_inline_cache_entry *entry = NULL;
+	for (size_t i = 0; i < OW_INLINE_CACHE_WAYS; i++) {
+		struct ow_inline_cache_entry *const e = &ic->entries[i];
+		if (e->class_ == class_ || !e->class_) {
+			entry = e;
+			break;
+		}
+	}
+	if (ow_unlikely(!entry)) {
+		// All entries are in use. Evict the last one.
+		memmove(ic->entries + 1, ic->entries,
+			sizeof ic->entries[0] * (OW_INLINE_CACHE_WAYS - 1));
+		entry = &ic->entries[0];
+	}
+	entry->class_ = class_;
+	entry->class_version = ow_class_obj_pub_info(class_)->version;
+	entry->member = member;
+}
+
+void ow_inline_cache_shape_update(
+		struct ow_inline_cache *ic, struct ow_shape_obj *shape, size_t index) {
+	ic->shape.shape = shape;
+	ic->shape.index = index;
+}
+
+void ow_inline_cache_shape_update_add(
+		struct ow_inline_cache *ic, struct ow_shape_obj *from, struct ow_shape_obj *to) {
+	ic->shape.add_from = from;
+	ic->shape.add_to = to;
+}
+
+void ow_inline_cache_array_gc_marker(
+		struct ow_machine *om, const struct ow_inline_cache *array, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		for (size_t j = 0; j < OW_INLINE_CACHE_WAYS; j++) {
+			struct ow_class_obj *const class_ = array[i].entries[j].class_;
+			if (!class_)
+				break;
+			ow_objmem_object_gc_marker(om, ow_object_from(class_));
+		}
+		const struct ow_inline_cache_shape *const shape_ic = &array[i].shape;
+		if (shape_ic->shape)
+			ow_objmem_object_gc_marker(om, ow_object_from(shape_ic->shape));
+		if (shape_ic->add_from) {
+			ow_objmem_object_gc_marker(om, ow_object_from(shape_ic->add_from));
+			ow_objmem_object_gc_marker(om, ow_object_from(shape_ic->add_to));
+		}
+	}
+}
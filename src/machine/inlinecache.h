@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <objects/classobj.h>
+#include <objects/moduleobj.h>
+#include <objects/shapeobj.h>
+#include <utilities/attributes.h>
+
+struct ow_machine;
+
+/// Number of classes that an inline cache can remember.
+#define OW_INLINE_CACHE_WAYS 4
+
+/// Inline cache for looking up attributes, methods and global variables by name.
+/// The attribute and method part is polymorphic: it remembers up to
+/// `OW_INLINE_CACHE_WAYS` classes. An entry is valid only when the class version
+/// has not changed since it was filled. The global variable part remembers where
+/// the variable was found; see `ow_inline_cache_global_lookup()`. The shape part
+/// remembers a slot index in objects of a shape, and a transition that adds the
+/// attribute to objects of another shape.
+struct ow_inline_cache {
+	struct ow_inline_cache_entry {
+		struct ow_class_obj *class_; // NULL if unused
+		size_t class_version;
+		intptr_t member; // See `ow_class_obj_find_member()`.
+	} entries[OW_INLINE_CACHE_WAYS];
+	struct ow_inline_cache_global {
+		struct ow_module_obj *module; // NULL if unused
+		size_t index;
+		size_t version; // Globals version of the current module.
+	} global;
+	struct ow_inline_cache_shape {
+		struct ow_shape_obj *shape; // NULL if unused
+		size_t index;
+		struct ow_shape_obj *add_from; // NULL if unused
+		struct ow_shape_obj *add_to; // Transition of `add_from`.
+	} shape;
+};
+
+/// Create an array of empty inline caches.
+struct ow_inline_cache *ow_inline_cache_array_new(size_t count);
+/// Destroy an array of inline caches.
+void ow_inline_cache_array_del(struct ow_inline_cache *array);
+/// Look up the cache. Return the member index like `ow_class_obj_find_member()`,
+/// or 0 if missed.
+ow_static_forceinline intptr_t ow_inline_cache_lookup(
+	const struct ow_inline_cache *ic, const struct ow_class_obj *class_);
+/// Record a lookup result in the cache.
+void ow_inline_cache_update(
+	struct ow_inline_cache *ic, struct ow_class_obj *class_, intptr_t member);
+/// Look up the global variable part for a variable that is searched for in module
+/// `current` first. If hit, store the index and return the module where the
+/// variable is; otherwise, return NULL.
+ow_static_forceinline struct ow_module_obj *ow_inline_cache_global_lookup(
+	const struct ow_inline_cache *ic, const struct ow_module_obj *current,
+	size_t *index_out);
+/// Record where a global variable was found. A variable found in the current
+/// module stays valid forever, while one found in another module becomes
+/// invalid when a new variable is added to the current module.
+ow_static_forceinline void ow_inline_cache_global_update(
+	struct ow_inline_cache *ic, const struct ow_module_obj *current,
+	struct ow_module_obj *found_in, size_t index);
+/// Record the slot index of an attribute in objects of a shape.
+void ow_inline_cache_shape_update(
+	struct ow_inline_cache *ic, struct ow_shape_obj *shape, size_t index);
+/// Record the transition for adding the attribute to objects of shape `from`.
+void ow_inline_cache_shape_update_add(
+	struct ow_inline_cache *ic, struct ow_shape_obj *from, struct ow_shape_obj *to);
+/// Mark classes and shapes in an array of inline caches.
+void ow_inline_cache_array_gc_marker(
+	struct ow_machine *om, const struct ow_inline_cache *array, size_t count);
+
+ow_static_forceinline intptr_t ow_inline_cache_lookup(
+		const struct ow_inline_cache *ic, const struct ow_class_obj *class_) {
+	const size_t version = ow_class_obj_pub_info(class_)->version;
+	for (size_t i = 0; i < OW_INLINE_CACHE_WAYS; i++) {
+		const struct ow_inline_cache_entry *const entry = &ic->entries[i];
+		if (entry->class_ == class_) {
+			if (ow_likely(entry->class_version == version))
+				return entry->member;
+			return 0;
+		}
+	}
+	return 0;
+}
+
+ow_static_forceinline struct ow_module_obj *ow_inline_cache_global_lookup(
+		const struct ow_inline_cache *ic, const struct ow_module_obj *current,
+		size_t *index_out) {
+	struct ow_module_obj *const module = ic->global.module;
+	if (ow_likely(module == current ||
+			(module && ic->global.version == ow_module_obj_globals_version(current)))) {
+		*index_out = ic->global.index;
+		return module;
+	}
+	return NULL;
+}
+
+ow_static_forceinline void ow_inline_cache_global_update(
+		struct ow_inline_cache *ic, const struct ow_module_obj *current,
+		struct ow_module_obj *found_in, size_t index) {
+	ic->global.module = found_in;
+	ic->global.index = index;
+	ic->global.version = ow_module_obj_globals_version(current);
+}
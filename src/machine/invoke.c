@@ -5,10 +5,12 @@
 #include <stdlib.h>
 
 #include "globals.h"
+#include "inlinecache.h"
 #include "machine.h"
 #include "symbols.h"
 #include <bytecode/opcode.h>
 #include <bytecode/operand.h>
+#include <config/options.h>
 #include <machine/modmgr.h>
 #include <objects/arrayobj.h>
 #include <objects/cfuncobj.h>
@@ -22,7 +24,9 @@
 #include <objects/memory.h>
 #include <objects/moduleobj.h>
 #include <objects/object.h>
+#include <objects/recordobj.h>
 #include <objects/setobj.h>
+#include <objects/shapeobj.h>
 #include <objects/smallint.h>
 #include <objects/stringobj.h>
 #include <objects/symbolobj.h>
@@ -48,6 +52,57 @@ ow_nodiscard ow_forceinline static struct ow_exception_obj *invoke_impl_check_ar
 	}
 }
 
+/// Check whether an object is a float (a flonum or a `Float` object).
+ow_forceinline static bool invoke_impl_is_float(
+		const struct ow_builtin_classes *builtin_classes, struct ow_object *obj) {
+	if (ow_likely(ow_flonum_check(obj)))
+		return true;
+	return !ow_smallint_check(obj) && ow_object_class(obj) == builtin_classes->float_;
+}
+
+/// Check whether both objects are floats.
+ow_forceinline static bool invoke_impl_are_floats(
+		const struct ow_builtin_classes *builtin_classes,
+		struct ow_object *lhs, struct ow_object *rhs) {
+	return invoke_impl_is_float(builtin_classes, lhs) &&
+		invoke_impl_is_float(builtin_classes, rhs);
+}
+
+/// If both objects are numbers (small int or float) and at least one of them
+/// is a float, get their values as doubles and return true.
+ow_forceinline static bool invoke_impl_float_operands(
+		const struct ow_builtin_classes *builtin_classes,
+		struct ow_object *lhs, struct ow_object *rhs,
+		double *lhs_out, double *rhs_out) {
+	if (ow_smallint_check(lhs)) {
+		if (!invoke_impl_is_float(builtin_classes, rhs))
+			return false;
+		*lhs_out = (double)ow_smallint_from_ptr(lhs);
+	} else if (invoke_impl_is_float(builtin_classes, lhs)) {
+		*lhs_out = ow_float_obj_or_flonum_value(lhs);
+		if (ow_smallint_check(rhs)) {
+			*rhs_out = (double)ow_smallint_from_ptr(rhs);
+			return true;
+		}
+		if (!invoke_impl_is_float(builtin_classes, rhs))
+			return false;
+	} else {
+		return false;
+	}
+	*rhs_out = ow_float_obj_or_flonum_value(rhs);
+	return true;
+}
+
+/// Get the stack top below the callable object of the current frame, which is
+/// where the stack top shall be after leaving the frame. If the frame started a new
+/// stack segment, switch back to the previous one.
+ow_forceinline static struct ow_object **invoke_impl_frame_base(
+		struct ow_machine *om, const struct ow_callstack_frame_info *fi) {
+	if (ow_unlikely(fi->new_segment))
+		return ow_callstack_pop_segment(&om->callstack);
+	return fi->arg_list - 2;
+}
+
 /// Try to call `__find_attr__()` to get attribute.
 ow_nodiscard ow_noinline static int invoke_impl_do_find_attribute(
 		struct ow_machine *om, struct ow_object *obj, struct ow_class_obj *obj_class,
@@ -86,23 +141,94 @@ ow_nodiscard ow_noinline static int invoke_impl_do_find_method(
 	return -1;
 }
 
-/// Get method by name. If cannot find the method, make an error and return false.
-ow_nodiscard ow_noinline static bool invoke_impl_get_method_y(
-		struct ow_machine *om, struct ow_object *obj,
-		struct ow_symbol_obj *name, struct ow_object **result) {
-	struct ow_class_obj *obj_class;
-	if (ow_unlikely(ow_smallint_check(obj)))
-		obj_class = om->builtin_classes->int_;
-	else
-		obj_class = ow_object_class(obj);
-	const size_t index = ow_class_obj_find_method(obj_class, name);
-	if (ow_likely(index != (size_t)-1)) {
-		*result = ow_class_obj_get_method(obj_class, index);
+/// Get method of an operator from the slot of the class. Parameter `name` is
+/// the method name for `__find_meth__()`. If cannot find the method, make an
+/// error and return false.
+ow_nodiscard ow_forceinline static bool invoke_impl_get_op_method(
+		struct ow_machine *om, struct ow_object *obj, struct ow_class_obj *obj_class,
+		enum ow_class_op op, struct ow_symbol_obj *name, struct ow_object **result) {
+	struct ow_object *const method = ow_class_obj_op_method(obj_class, op);
+	if (ow_likely(method)) {
+		*result = method;
 		return true;
 	}
 	return invoke_impl_do_find_method(om, obj, obj_class, name, result) == 0;
 }
 
+/// Find global variable by the symbol at `index` in the current module and
+/// then in the base module, and fill the inline cache.
+ow_noinline static struct ow_object *invoke_impl_load_global_y(
+		struct ow_machine *om, struct ow_func_obj *func,
+		struct ow_inline_cache *ic, size_t index) {
+	struct ow_symbol_obj *const name = ow_func_obj_get_symbol(func, index);
+	assert(name);
+	struct ow_module_obj *module = func->module;
+	size_t global_index = ow_module_obj_find_global(module, name);
+	if (global_index == (size_t)-1) {
+		module = om->globals->module_base;
+		global_index = ow_module_obj_find_global(module, name);
+		if (ow_unlikely(global_index == (size_t)-1))
+			return om->globals->value_nil;
+	}
+	ow_inline_cache_global_update(ic, func->module, module, global_index);
+	return ow_module_obj_get_global(module, global_index);
+}
+
+/// Find an attribute of a record. If found, remember the slot index in the
+/// inline cache and return it; otherwise, return -1.
+ow_noinline static size_t invoke_impl_find_record_attr(
+		struct ow_machine *om, struct ow_func_obj *func, struct ow_inline_cache *ic,
+		struct ow_record_obj *record, struct ow_symbol_obj *name) {
+	struct ow_shape_obj *const shape = record->shape;
+	const size_t index = ow_shape_obj_find(shape, name);
+	if (index != (size_t)-1) {
+		ow_inline_cache_shape_update(ic, shape, index);
+		ow_objmem_write_barrier(om, ow_object_from(func), ow_object_from(shape));
+	}
+	return index;
+}
+
+/// Set an attribute of a record, adding it if not exists, and fill the inline cache.
+ow_noinline static void invoke_impl_store_record_attr(
+		struct ow_machine *om, struct ow_func_obj *func, struct ow_inline_cache *ic,
+		struct ow_record_obj *record, struct ow_symbol_obj *name, struct ow_object *val) {
+	const size_t index = invoke_impl_find_record_attr(om, func, ic, record, name);
+	if (index != (size_t)-1) {
+		ow_record_obj_set(om, record, index, val);
+		return;
+	}
+	struct ow_shape_obj *const shape = record->shape;
+	struct ow_shape_obj *const new_shape = ow_shape_obj_transition(om, shape, name);
+	ow_inline_cache_shape_update_add(ic, shape, new_shape);
+	ow_objmem_write_barrier_n(om, ow_object_from(func));
+	ow_record_obj_add(om, record, new_shape, val);
+}
+
+/// Get slot index of a record attribute with the help of the inline cache.
+/// If not exists, return -1.
+ow_forceinline static size_t invoke_impl_record_attr_index(
+		struct ow_machine *om, struct ow_func_obj *func, size_t symbol_index,
+		struct ow_record_obj *record, struct ow_symbol_obj *name) {
+	struct ow_inline_cache *const ic = ow_func_obj_inline_cache(func, symbol_index);
+	if (ow_likely(ic->shape.shape == record->shape))
+		return ic->shape.index;
+	return invoke_impl_find_record_attr(om, func, ic, record, name);
+}
+
+/// Number of stack slots that instructions may use temporarily (for example,
+/// to call an operator method) in addition to the max stack depth of a function.
+#define INVOKE_IMPL_STACK_EXTRA 4
+/// Number of free stack slots guaranteed for a native function.
+#define INVOKE_IMPL_NATIVE_STACK 32
+
+#if OW_BUILD_COMPUTED_GOTO && defined __GNUC__
+#	define INVOKE_IMPL_COMPUTED_GOTO 1
+#	pragma GCC diagnostic push
+#	pragma GCC diagnostic ignored "-Wpedantic" // Labels as values.
+#else
+#	define INVOKE_IMPL_COMPUTED_GOTO 0
+#endif
+
 #ifdef __GNUC__
 __attribute__((hot))
 #endif // __GNUC__
@@ -122,12 +248,29 @@ static int invoke_impl(
 #define STACK_ASSERT_NC()  \
 	assert(stack.sp == machine->callstack.regs.sp && stack.fp == machine->callstack.regs.fp)
 
+	// Objects may be allocated only after the stack has been committed; otherwise,
+	// the GC may not see the objects on top of the stack.
+#define MAKE_INT(VAL)      (ow_likely((VAL) >= OW_SMALLINT_MIN && (VAL) <= OW_SMALLINT_MAX) ? \
+	ow_smallint_to_ptr(VAL) : (STACK_COMMIT(), ow_object_from(_ow_int_obj_new(machine, (VAL)))))
+#define MAKE_FLOAT(VAL)    (STACK_COMMIT(), ow_float_obj_or_flonum(machine, (VAL)))
+
 	ip = NULL;
 	STACK_UPDATE();
 	current_func_obj = NULL;
 	current_module = NULL;
 	current_frame = machine->callstack.frame_info_list.current;
 
+#if INVOKE_IMPL_COMPUTED_GOTO
+	// Direct threading: each instruction jumps to the next one through this
+	// table, so that each dispatch site gets its own branch history.
+	static const void *const dispatch_table[UCHAR_MAX + 1] = {
+#define ELEM(NAME, CODE, OPERAND_TYPE) [ CODE ] = &&op_##NAME##_0 ,
+		OW_OPCODE_LIST
+#undef ELEM
+		[(size_t)_OW_OPC_COUNT ... UCHAR_MAX] = &&err_bad_opcode,
+	};
+#endif // INVOKE_IMPL_COMPUTED_GOTO
+
 	goto start;
 
 	while (1) {
@@ -148,8 +291,15 @@ static int invoke_impl(
 				void         *pointer;
 			} operand;
 
+#if INVOKE_IMPL_COMPUTED_GOTO
+#define OP_BEGIN(NAME)     case OW_OPC_##NAME : op_##NAME##_0 : {
+#define OP_END             } goto *dispatch_table[*ip++];
+#define OP_RESERVED(NAME)  op_##NAME##_0 :
+#else // !INVOKE_IMPL_COMPUTED_GOTO
 #define OP_BEGIN(NAME)     case OW_OPC_##NAME : {
 #define OP_END             } continue;
+#define OP_RESERVED(NAME)
+#endif // INVOKE_IMPL_COMPUTED_GOTO
 #define OPERAND_(TYPE, TO) { (TO) = *(_operand_type_##TYPE *)ip; }
 #define OPERAND(TYPE, TO)  { OPERAND_(TYPE, TO); ip += sizeof(_operand_type_##TYPE); }
 #define NO_OPERAND()       { }
@@ -178,13 +328,13 @@ static int invoke_impl(
 
 		OP_BEGIN(SwapN)
 			OPERAND(u8, operand.count)
-			if (ow_unlikely(!operand.count))
-				break;
-			struct ow_object *const top = stack.sp[0];
-			struct ow_object **const p_end = stack.sp - operand.count + 1;
-			for (struct ow_object **p = stack.sp; p > p_end; p--)
-				p[0] = p[-1];
-			*p_end = top;
+			if (ow_likely(operand.count)) {
+				struct ow_object *const top = stack.sp[0];
+				struct ow_object **const p_end = stack.sp - operand.count + 1;
+				for (struct ow_object **p = stack.sp; p > p_end; p--)
+					p[0] = p[-1];
+				*p_end = top;
+			}
 		OP_END
 
 		OP_BEGIN(Drop)
@@ -233,55 +383,159 @@ static int invoke_impl(
 
 		OP_BEGIN(LdFlt)
 			OPERAND(i8, operand.i8)
-			*++stack.sp =
-				ow_object_from(ow_float_obj_new(machine, (double)operand.i8));
+			struct ow_object *const obj = MAKE_FLOAT((double)operand.i8);
+			*++stack.sp = obj;
 		OP_END
 
+#define QUICKEN_TO(NAME) \
+	(((unsigned char *)ip)[-1] = (unsigned char)OW_OPC_##NAME)
+
+#define QUICKEN_SMI(NAME) \
+	if (ow_smallint_check(stack.sp[-1]) && ow_smallint_check(stack.sp[0])) { \
+		QUICKEN_TO(NAME##Smi); \
+		goto op_##NAME##Smi_1; \
+	} \
+// ^^^ QUICKEN_SMI() ^^^
+
+#define QUICKEN_FLT(NAME) \
+	if (invoke_impl_are_floats(builtin_classes, stack.sp[-1], stack.sp[0])) { \
+		QUICKEN_TO(NAME##Flt); \
+		goto op_##NAME##Flt_1; \
+	} \
+// ^^^ QUICKEN_FLT() ^^^
+
 #define IMPL_BIN_OP(OPERATOR, METH_NAME) \
 	struct ow_object *const lhs = stack.sp[-1]; \
 	struct ow_object *const rhs = stack.sp[0]; \
 	if (ow_smallint_check(lhs) && ow_smallint_check(rhs)) { \
 		const ow_smallint_t res = \
 			ow_smallint_from_ptr(lhs) OPERATOR ow_smallint_from_ptr(rhs); \
-		*--stack.sp = ow_int_obj_or_smallint(machine, res); \
+		stack.sp--; \
+		*stack.sp = MAKE_INT(res); \
 	} else { \
-		*stack.sp = lhs; \
-		*++stack.sp = rhs; \
-		STACK_COMMIT(); \
-		const bool ok = invoke_impl_get_method_y( \
-			machine, lhs, common_symbols-> METH_NAME , stack.sp - 2); \
-		STACK_ASSERT_NC(); \
-		if (ow_unlikely(!ok)) { \
-			stack.sp -= 2; \
-			goto raise_exc; \
-		} \
-		DO_CALL(2); \
+		IMPL_BIN_OP_SLOW(METH_NAME) \
 	} \
 // ^^^ IMPL_BIN_OP() ^^^
 
+#define IMPL_BIN_OP_SLOW(METH_NAME) \
+		struct ow_class_obj *const lhs_class = \
+			ow_builtin_classes_class_of(builtin_classes, lhs); \
+		const ow_class_op_native_t op_native = \
+			ow_class_obj_op_native(lhs_class, OW_CLASS_OP_##METH_NAME); \
+		if (op_native) { \
+			STACK_COMMIT(); \
+			struct ow_object *op_res; \
+			const int status = op_native(machine, stack.sp - 1, &op_res); \
+			STACK_ASSERT_NC(); \
+			*--stack.sp = op_res; \
+			if (ow_unlikely(status)) \
+				goto raise_exc; \
+		} else { \
+			*stack.sp = lhs; \
+			*++stack.sp = rhs; \
+			STACK_COMMIT(); \
+			const bool ok = invoke_impl_get_op_method( \
+				machine, lhs, lhs_class, OW_CLASS_OP_##METH_NAME, \
+				common_symbols-> METH_NAME , stack.sp - 2); \
+			STACK_ASSERT_NC(); \
+			if (ow_unlikely(!ok)) { \
+				stack.sp -= 2; \
+				goto raise_exc; \
+			} \
+			DO_CALL(2); \
+		} \
+// ^^^ IMPL_BIN_OP_SLOW() ^^^
+
+// Add to or subtract from a local variable: `loc = loc OPERATOR val`, where
+// operand is `loc | val << 8`. The instruction is followed by a `StLoc loc`.
+// Small ints and floats are updated in place and the `StLoc` is skipped;
+// otherwise, the operator is called and the `StLoc` stores the result.
+#define IMPL_INC_LOC(OPERATOR, METH_NAME) \
+	struct ow_object **const p = stack.fp + (operand.u16 & 0xff); \
+	const ow_smallint_t val = (int8_t)(uint8_t)(operand.u16 >> 8); \
+	if (ow_unlikely(p > stack.sp)) \
+		goto err_bad_operand; \
+	assert(ip[0] == OW_OPC_StLoc && ip[1] == (operand.u16 & 0xff)); \
+	struct ow_object *const lhs = *p; \
+	struct ow_object *const rhs = ow_smallint_to_ptr(val); \
+	double lhs_f, rhs_f; \
+	if (ow_likely(ow_smallint_check(lhs))) { \
+		const ow_smallint_t res = ow_smallint_from_ptr(lhs) OPERATOR val; \
+		*p = MAKE_INT(res); \
+		ip += 1 + sizeof(_operand_type_u8); /* Skip the StLoc. */ \
+	} else if (invoke_impl_float_operands(builtin_classes, lhs, rhs, &lhs_f, &rhs_f)) { \
+		*p = MAKE_FLOAT(lhs_f OPERATOR rhs_f); \
+		ip += 1 + sizeof(_operand_type_u8); \
+	} else { \
+		stack.sp += 2; \
+		stack.sp[-1] = lhs; \
+		stack.sp[0] = rhs; \
+		IMPL_BIN_OP_SLOW(METH_NAME) \
+	} \
+// ^^^ IMPL_INC_LOC() ^^^
+
+// Like `IMPL_BIN_OP()`, but for operators that accept floats. Operands that are
+// both small ints shall have been handled.
+#define IMPL_ARITH_OP(OPERATOR, METH_NAME) \
+	struct ow_object *const lhs = stack.sp[-1]; \
+	struct ow_object *const rhs = stack.sp[0]; \
+	double lhs_f, rhs_f; \
+	if (invoke_impl_float_operands(builtin_classes, lhs, rhs, &lhs_f, &rhs_f)) { \
+		stack.sp--; \
+		*stack.sp = MAKE_FLOAT(lhs_f OPERATOR rhs_f); \
+	} else { \
+		IMPL_BIN_OP_SLOW(METH_NAME) \
+	} \
+// ^^^ IMPL_ARITH_OP() ^^^
+
 		OP_BEGIN(Add)
 			NO_OPERAND()
-			IMPL_BIN_OP(+, add)
+		op_Add_1:;
+			QUICKEN_SMI(Add)
+			QUICKEN_FLT(Add)
+			IMPL_ARITH_OP(+, add)
 		OP_END
 
 		OP_BEGIN(Sub)
 			NO_OPERAND()
-			IMPL_BIN_OP(-, sub)
+		op_Sub_1:;
+			QUICKEN_SMI(Sub)
+			QUICKEN_FLT(Sub)
+			IMPL_ARITH_OP(-, sub)
 		OP_END
 
 		OP_BEGIN(Mul)
 			NO_OPERAND()
-			IMPL_BIN_OP(*, mul)
+		op_Mul_1:;
+			QUICKEN_SMI(Mul)
+			QUICKEN_FLT(Mul)
+			IMPL_ARITH_OP(*, mul)
 		OP_END
 
 		OP_BEGIN(Div)
 			NO_OPERAND()
-			IMPL_BIN_OP(/, div)
+		op_Div_1:;
+			QUICKEN_FLT(Div)
+			if (ow_smallint_check(stack.sp[-1]) && ow_smallint_check(stack.sp[0]) &&
+					ow_likely(stack.sp[0] != ow_smallint_to_ptr(0))) {
+				const ow_smallint_t res =
+					ow_smallint_from_ptr(stack.sp[-1]) / ow_smallint_from_ptr(stack.sp[0]);
+				stack.sp--;
+				*stack.sp = MAKE_INT(res);
+			} else {
+				IMPL_ARITH_OP(/, div)
+			}
 		OP_END
 
 		OP_BEGIN(Rem)
 			NO_OPERAND()
-			IMPL_BIN_OP(%, rem)
+			if (ow_unlikely(stack.sp[0] == ow_smallint_to_ptr(0))) {
+				struct ow_object *const lhs = stack.sp[-1];
+				struct ow_object *const rhs = stack.sp[0];
+				IMPL_BIN_OP_SLOW(rem)
+			} else {
+				IMPL_BIN_OP(%, rem)
+			}
 		OP_END
 
 		OP_BEGIN(Shl)
@@ -309,18 +563,17 @@ static int invoke_impl(
 			IMPL_BIN_OP(^, xor_)
 		OP_END
 
-#undef IMPL_BIN_OP
-
 #define IMPL_UN_OP(OPERATOR, METH_NAME) \
 	struct ow_object *const val = stack.sp[0]; \
 	if (ow_smallint_check(val)) { \
 		const ow_smallint_t res = OPERATOR ow_smallint_from_ptr(val); \
-		*stack.sp = ow_int_obj_or_smallint(machine, res); \
+		*stack.sp = MAKE_INT(res); \
 	} else { \
 		*++stack.sp = val; \
 		STACK_COMMIT(); \
-		const bool ok = invoke_impl_get_method_y( \
-			machine, val, common_symbols-> METH_NAME , stack.sp - 1); \
+		const bool ok = invoke_impl_get_op_method( \
+			machine, val, ow_builtin_classes_class_of(builtin_classes, val), \
+			OW_CLASS_OP_##METH_NAME, common_symbols-> METH_NAME , stack.sp - 1); \
 		STACK_ASSERT_NC(); \
 		if (ow_unlikely(!ok)) { \
 			stack.sp--; \
@@ -374,17 +627,7 @@ static int invoke_impl(
 				const ow_smallint_t res = lhs_v == rhs_v ? 0 : lhs_v < rhs_v ? -1 : 1;
 				*--stack.sp = ow_smallint_to_ptr(res);
 			} else {
-				*stack.sp = lhs;
-				*++stack.sp = rhs;
-				STACK_COMMIT();
-				const bool ok = invoke_impl_get_method_y(
-					machine, lhs, common_symbols->cmp, stack.sp - 2);
-				STACK_ASSERT_NC();
-				if (ow_unlikely(!ok)) {
-					stack.sp -= 2;
-					goto raise_exc;
-				}
-				DO_CALL(2);
+				IMPL_BIN_OP_SLOW(cmp)
 			}
 		OP_END
 
@@ -397,18 +640,43 @@ static int invoke_impl(
 		*--stack.sp = lhs_v OPERATOR rhs_v ? \
 			machine_globals->value_true : machine_globals->value_false; \
 	} else { \
-		*stack.sp = lhs; \
-		*++stack.sp = rhs; \
+		double lhs_f, rhs_f; \
+		if (invoke_impl_float_operands(builtin_classes, lhs, rhs, &lhs_f, &rhs_f)) { \
+			*--stack.sp = lhs_f OPERATOR rhs_f ? \
+				machine_globals->value_true : machine_globals->value_false; \
+		} else { \
+			IMPL_CMP_OP_SLOW(OPERATOR) \
+		} \
+	} \
+// ^^^ IMPL_CMP_OP^^^
+
+#define IMPL_CMP_OP_SLOW(OPERATOR) \
+		struct ow_class_obj *const lhs_class = \
+			ow_builtin_classes_class_of(builtin_classes, lhs); \
+		const ow_class_op_native_t op_native = \
+			ow_class_obj_op_native(lhs_class, OW_CLASS_OP_cmp); \
 		STACK_COMMIT(); \
-		const bool ok = invoke_impl_get_method_y( \
-			machine, lhs, common_symbols->cmp, stack.sp - 2); \
-		STACK_ASSERT_NC(); \
-		if (ow_unlikely(!ok)) { \
+		int status; \
+		if (op_native) { \
+			struct ow_object *op_res; \
+			status = op_native(machine, stack.sp - 1, &op_res); \
+			STACK_ASSERT_NC(); \
+			*--stack.sp = op_res; \
+		} else { \
+			*stack.sp = lhs; \
+			*++stack.sp = rhs; \
+			STACK_COMMIT(); \
+			const bool ok = invoke_impl_get_op_method( \
+				machine, lhs, lhs_class, OW_CLASS_OP_cmp, \
+				common_symbols->cmp, stack.sp - 2); \
+			STACK_ASSERT_NC(); \
+			if (ow_unlikely(!ok)) { \
+				stack.sp -= 2; \
+				goto raise_exc; \
+			} \
+			status = ow_machine_invoke(machine, 2, stack.sp - 2); \
 			stack.sp -= 2; \
-			goto raise_exc; \
 		} \
-		const int status = ow_machine_invoke(machine, 2, stack.sp - 2); \
-		stack.sp -= 2; \
 		if (ow_unlikely(status)) \
 			goto raise_exc; \
 		struct ow_object *const cmp_res_o = *stack.sp; \
@@ -419,40 +687,54 @@ static int invoke_impl(
 		} \
 		*stack.sp = (ow_smallint_from_ptr(cmp_res_o) OPERATOR 0) ? \
 			machine_globals->value_true : machine_globals->value_false; \
-	} \
-// ^^^ IMPL_CMP_OP^^^
+// ^^^ IMPL_CMP_OP_SLOW^^^
 
 		OP_BEGIN(CmpLt)
 			NO_OPERAND()
+		op_CmpLt_1:;
+			QUICKEN_SMI(CmpLt)
+			QUICKEN_FLT(CmpLt)
 			IMPL_CMP_OP(<)
 		OP_END
 
 		OP_BEGIN(CmpLe)
 			NO_OPERAND()
+		op_CmpLe_1:;
+			QUICKEN_SMI(CmpLe)
+			QUICKEN_FLT(CmpLe)
 			IMPL_CMP_OP(<=)
 		OP_END
 
 		OP_BEGIN(CmpGt)
 			NO_OPERAND()
+		op_CmpGt_1:;
+			QUICKEN_SMI(CmpGt)
+			QUICKEN_FLT(CmpGt)
 			IMPL_CMP_OP(>)
 		OP_END
 
 		OP_BEGIN(CmpGe)
 			NO_OPERAND()
+		op_CmpGe_1:;
+			QUICKEN_SMI(CmpGe)
+			QUICKEN_FLT(CmpGe)
 			IMPL_CMP_OP(>=)
 		OP_END
 
 		OP_BEGIN(CmpEq)
 			NO_OPERAND()
+		op_CmpEq_1:;
+			QUICKEN_SMI(CmpEq)
 			IMPL_CMP_OP(==)
 		OP_END
 
 		OP_BEGIN(CmpNe)
 			NO_OPERAND()
+		op_CmpNe_1:;
+			QUICKEN_SMI(CmpNe)
 			IMPL_CMP_OP(!=)
 		OP_END
 
-#undef IMPL_CMP_OP
 
 		OP_BEGIN(LdCnst)
 			OPERAND(u8, operand.index)
@@ -503,7 +785,7 @@ static int invoke_impl(
 		OP_BEGIN(LdLoc)
 			OPERAND(u8, operand.index)
 			struct ow_object **const p = stack.fp + operand.index;
-			if (ow_unlikely(p <= stack.sp))
+			if (ow_unlikely(p > stack.sp))
 				goto err_bad_operand;
 			*++stack.sp = *p;
 		OP_END
@@ -511,7 +793,7 @@ static int invoke_impl(
 		OP_BEGIN(LdLocW)
 			OPERAND(u16, operand.index)
 			struct ow_object **const p = stack.fp + operand.index;
-			if (ow_unlikely(p <= stack.sp))
+			if (ow_unlikely(p > stack.sp))
 				goto err_bad_operand;
 			*++stack.sp = *p;
 		OP_END
@@ -519,7 +801,7 @@ static int invoke_impl(
 		OP_BEGIN(StLoc)
 			OPERAND(u8, operand.index)
 			struct ow_object **const p = stack.fp + operand.index;
-			if (ow_unlikely(p < stack.sp))
+			if (ow_unlikely(p >= stack.sp))
 				goto err_bad_operand;
 			*p = *stack.sp--;
 		OP_END
@@ -527,7 +809,7 @@ static int invoke_impl(
 		OP_BEGIN(StLocW)
 			OPERAND(u16, operand.index)
 			struct ow_object **const p = stack.fp + operand.index;
-			if (ow_unlikely(p < stack.sp))
+			if (ow_unlikely(p >= stack.sp))
 				goto err_bad_operand;
 			*p = *stack.sp--;
 		OP_END
@@ -551,7 +833,7 @@ static int invoke_impl(
 			OPERAND(u8, operand.index)
 		op_StGlob_1:;
 			struct ow_object *const obj = *stack.sp--;
-			ow_module_obj_set_global(current_module, operand.index, obj);
+			ow_module_obj_set_global(machine, current_module, operand.index, obj);
 		OP_END
 
 		OP_BEGIN(StGlobW)
@@ -562,17 +844,18 @@ static int invoke_impl(
 		OP_BEGIN(LdGlobY)
 			OPERAND(u8, operand.index)
 		op_LdGlobY_1:;
-			struct ow_symbol_obj *name =
-				ow_func_obj_get_symbol(current_func_obj, operand.index);
-			if (ow_unlikely(!name))
+			if (ow_unlikely(operand.index >= ow_func_obj_symbol_count(current_func_obj)))
 				goto err_bad_operand;
-			struct ow_object *obj =
-				ow_module_obj_get_global_y(current_module, name);
-			if (!obj) {
-				obj = ow_module_obj_get_global_y(machine_globals->module_base, name);
-				if (ow_unlikely(!obj))
-					obj = machine_globals->value_nil;
-			}
+			struct ow_inline_cache *const ic =
+				ow_func_obj_inline_cache(current_func_obj, operand.index);
+			size_t global_index;
+			struct ow_module_obj *const module =
+				ow_inline_cache_global_lookup(ic, current_module, &global_index);
+			struct ow_object *obj;
+			if (ow_likely(module))
+				obj = ow_module_obj_get_global(module, global_index);
+			else
+				obj = invoke_impl_load_global_y(machine, current_func_obj, ic, operand.index);
 			*++stack.sp = obj;
 		OP_END
 
@@ -588,8 +871,15 @@ static int invoke_impl(
 				ow_func_obj_get_symbol(current_func_obj, operand.index);
 			if (ow_unlikely(!name))
 				goto err_bad_operand;
+			struct ow_inline_cache *const ic =
+				ow_func_obj_inline_cache(current_func_obj, operand.index);
 			struct ow_object *const obj = *stack.sp--;
-			ow_module_obj_set_global_y(current_module, name, obj);
+			if (ow_likely(ic->global.module == current_module)) {
+				ow_module_obj_set_global(machine, current_module, ic->global.index, obj);
+			} else {
+				operand.index = ow_module_obj_set_global_y(machine, current_module, name, obj);
+				ow_inline_cache_global_update(ic, current_module, current_module, operand.index);
+			}
 		OP_END
 
 		OP_BEGIN(StGlobYW)
@@ -605,21 +895,34 @@ static int invoke_impl(
 			if (ow_unlikely(!name))
 				goto err_bad_operand;
 			struct ow_object *const obj = *stack.sp;
-			struct ow_class_obj *obj_class;
-			if (ow_unlikely(ow_smallint_check(obj)))
-				obj_class = builtin_classes->int_;
-			else
-				obj_class = ow_object_class(obj);
+			struct ow_class_obj *const obj_class =
+				ow_builtin_classes_class_of(builtin_classes, obj);
 			struct ow_object *attr;
+			size_t record_index;
 			if (obj_class == builtin_classes->module) {
 				attr = ow_module_obj_get_global_y(
 					ow_object_cast(obj, struct ow_module_obj), name);
 				if (ow_unlikely(!attr))
 					attr = machine_globals->value_nil;
+			} else if (obj_class == builtin_classes->record && (record_index =
+					invoke_impl_record_attr_index(
+						machine, current_func_obj, operand.index,
+						ow_object_cast(obj, struct ow_record_obj), name)) != (size_t)-1) {
+				attr = ow_record_obj_get(ow_object_cast(obj, struct ow_record_obj), record_index);
 			} else {
-				operand.index = ow_class_obj_find_attribute(obj_class, name);
-				if (ow_likely(operand.index != (size_t)-1)) {
-					attr = ow_object_get_field(obj, operand.index);
+				struct ow_inline_cache *const ic =
+					ow_func_obj_inline_cache(current_func_obj, operand.index);
+				intptr_t member = ow_inline_cache_lookup(ic, obj_class);
+				if (ow_unlikely(!member)) {
+					member = ow_class_obj_find_member(obj_class, name);
+					if (member > 0) {
+						ow_inline_cache_update(ic, obj_class, member);
+						ow_objmem_write_barrier(
+							machine, ow_object_from(current_func_obj), ow_object_from(obj_class));
+					}
+				}
+				if (ow_likely(member > 0)) {
+					attr = ow_object_get_field(obj, (size_t)(member - 1));
 				} else {
 					STACK_COMMIT();
 					const int status = invoke_impl_do_find_attribute(
@@ -647,15 +950,26 @@ static int invoke_impl(
 			if (ow_unlikely(!name))
 				goto err_bad_operand;
 			struct ow_object *const obj = *stack.sp--;
-			struct ow_object *const attr = *stack.sp;
-			struct ow_class_obj *obj_class;
-			if (ow_unlikely(ow_smallint_check(obj)))
-				obj_class = builtin_classes->int_;
-			else
-				obj_class = ow_object_class(obj);
+			struct ow_object *const attr = *stack.sp--;
+			struct ow_class_obj *const obj_class =
+				ow_builtin_classes_class_of(builtin_classes, obj);
 			if (obj_class == builtin_classes->module) {
 				ow_module_obj_set_global_y(
-					ow_object_cast(obj, struct ow_module_obj), name, attr);
+					machine, ow_object_cast(obj, struct ow_module_obj), name, attr);
+			} else if (obj_class == builtin_classes->record) {
+				struct ow_record_obj *const record = ow_object_cast(obj, struct ow_record_obj);
+				struct ow_inline_cache *const ic =
+					ow_func_obj_inline_cache(current_func_obj, operand.index);
+				if (ow_likely(ic->shape.shape == record->shape)) {
+					ow_record_obj_set(machine, record, ic->shape.index, attr);
+				} else if (ic->shape.add_from == record->shape) {
+					ow_record_obj_add(machine, record, ic->shape.add_to, attr);
+				} else {
+					STACK_COMMIT();
+					invoke_impl_store_record_attr(
+						machine, current_func_obj, ic, record, name, attr);
+					STACK_ASSERT_NC();
+				}
 			} else {
 				goto err_not_implemented;
 			}
@@ -673,8 +987,9 @@ static int invoke_impl(
 			stack.sp[0] = stack.sp[-1];
 			stack.sp[-1] = obj;
 			STACK_COMMIT();
-			const bool ok = invoke_impl_get_method_y(
-				machine, obj, common_symbols->get_elem, stack.sp - 2);
+			const bool ok = invoke_impl_get_op_method(
+				machine, obj, ow_builtin_classes_class_of(builtin_classes, obj),
+				OW_CLASS_OP_get_elem, common_symbols->get_elem, stack.sp - 2);
 			STACK_ASSERT_NC();
 			if (ow_unlikely(!ok)) {
 				stack.sp -= 2;
@@ -689,8 +1004,9 @@ static int invoke_impl(
 			struct ow_object *const elem = stack.sp[-2];
 			*++stack.sp = elem;
 			STACK_COMMIT();
-			const bool ok = invoke_impl_get_method_y(
-				machine, obj, common_symbols->set_elem, stack.sp - 3);
+			const bool ok = invoke_impl_get_op_method(
+				machine, obj, ow_builtin_classes_class_of(builtin_classes, obj),
+				OW_CLASS_OP_set_elem, common_symbols->set_elem, stack.sp - 3);
 			STACK_ASSERT_NC();
 			if (ow_unlikely(!ok)) {
 				stack.sp -= 3;
@@ -702,11 +1018,15 @@ static int invoke_impl(
 		OP_BEGIN(Jmp)
 			OPERAND_(i8, operand.ptrdiff)
 			ip = ip - 1 + operand.ptrdiff;
+			if (ow_unlikely(machine->out_of_memory) && operand.ptrdiff < 0)
+				goto err_out_of_memory;
 		OP_END
 
 		OP_BEGIN(JmpW)
 			OPERAND_(i16, operand.ptrdiff)
 			ip = ip - 1 + operand.ptrdiff;
+			if (ow_unlikely(machine->out_of_memory) && operand.ptrdiff < 0)
+				goto err_out_of_memory;
 		OP_END
 
 		OP_BEGIN(JmpWhen)
@@ -733,6 +1053,7 @@ static int invoke_impl(
 
 		OP_BEGIN(JmpUnls)
 			OPERAND_(i8, operand.ptrdiff)
+		op_JmpUnls_1:;
 			struct ow_object *const cond = *stack.sp--;
 			if (cond == machine_globals->value_false)
 				ip = ip - 1 + operand.ptrdiff;
@@ -744,6 +1065,7 @@ static int invoke_impl(
 
 		OP_BEGIN(JmpUnlsW)
 			OPERAND_(i16, operand.ptrdiff)
+		op_JmpUnlsW_1:;
 			struct ow_object *const cond = *stack.sp--;
 			if (cond == machine_globals->value_false)
 				ip = ip - 1 + operand.ptrdiff;
@@ -784,12 +1106,9 @@ static int invoke_impl(
 		op_Ret_2:;
 			ip = current_frame->prev_ip;
 			stack.fp = current_frame->prev_fp;
-			if (current_frame->not_ret_val || ow_unlikely(!ip)) {
-				stack.sp = current_frame->arg_list - 2;
-			} else {
-				stack.sp = current_frame->arg_list - 1;
-				*stack.sp = operand.pointer;
-			}
+			stack.sp = invoke_impl_frame_base(machine, current_frame);
+			if (!(current_frame->not_ret_val || ow_unlikely(!ip)))
+				*++stack.sp = operand.pointer;
 
 			struct ow_callstack_frame_info_list *const frame_info_list =
 				&machine->callstack.frame_info_list;
@@ -831,9 +1150,31 @@ static int invoke_impl(
 
 			struct ow_callstack_frame_info_list *const frame_info_list =
 				&machine->callstack.frame_info_list;
-			ow_callstack_frame_info_list_enter(frame_info_list);
+			if (ow_unlikely(machine->out_of_memory)) {
+				machine->out_of_memory = false;
+				STACK_COMMIT();
+				operand.pointer = ow_object_from(ow_exception_format(
+					machine, NULL, "out of memory"));
+				goto op_Call_fail;
+			}
+			if (ow_unlikely(!ow_callstack_frame_info_list_enter(frame_info_list))) {
+				STACK_COMMIT();
+				operand.pointer = ow_object_from(ow_exception_format(
+					machine, NULL, "maximum call depth exceeded (%zu)",
+					ow_callstack_frame_info_list_max_depth(frame_info_list)));
+			op_Call_fail:
+				if (ow_unlikely(!ip)) {
+					stack.sp -= arg_count + 1;
+					STACK_COMMIT();
+					*_res_out = operand.pointer;
+					return -1;
+				}
+				*++stack.sp = operand.pointer;
+				goto raise_exc;
+			}
 			current_frame = frame_info_list->current;
 			current_frame->not_ret_val = no_ret_val;
+			current_frame->new_segment = false;
 			current_frame->arg_list = stack.sp - arg_count + 1;
 			current_frame->prev_fp = stack.fp;
 			current_frame->prev_ip = ip;
@@ -841,8 +1182,9 @@ static int invoke_impl(
 
 			struct ow_object *const callable_obj = *(stack.sp - arg_count);
 			struct ow_class_obj *callable_obj_class;
-			if (ow_unlikely(ow_smallint_check(callable_obj))) {
-				callable_obj_class = builtin_classes->int_;
+			if (ow_unlikely(ow_object_is_immediate(callable_obj))) {
+				callable_obj_class =
+					ow_builtin_classes_class_of(builtin_classes, callable_obj);
 				goto other_func_obj_type;
 			}
 			callable_obj_class = ow_object_class(callable_obj);
@@ -855,6 +1197,21 @@ static int invoke_impl(
 					*++stack.sp = operand.pointer;
 					goto raise_exc;
 				}
+				const size_t stack_need = func_obj->func_spec.local_cnt +
+					func_obj->func_spec.max_stack + INVOKE_IMPL_STACK_EXTRA;
+				// A guarded stack relies on its guard page here.
+				if (ow_unlikely(!ow_callstack_has_space(
+						&machine->callstack, stack.sp, stack_need)) &&
+						!ow_callstack_is_guarded(&machine->callstack)) {
+					STACK_COMMIT();
+					ow_callstack_push_segment(&machine->callstack, arg_count + 1, stack_need);
+					STACK_UPDATE();
+					current_frame->new_segment = true;
+					current_frame->arg_list = stack.sp - arg_count + 1;
+					stack.fp = stack.sp + 1;
+				}
+				for (unsigned int i = func_obj->func_spec.local_cnt; i; i--)
+					*++stack.sp = machine_globals->value_nil;
 				ip = func_obj->code;
 				current_func_obj = func_obj;
 				current_module = func_obj->module;
@@ -868,18 +1225,31 @@ static int invoke_impl(
 					goto raise_exc;
 				}
 				STACK_COMMIT();
+				if (ow_unlikely(!ow_callstack_has_space(
+						&machine->callstack, stack.sp, INVOKE_IMPL_NATIVE_STACK))) {
+					if (ow_callstack_is_guarded(&machine->callstack)) {
+						// Native code must not run into the guard page.
+						*++stack.sp = ow_object_from(
+							ow_exception_format(machine, NULL, "stack overflow"));
+						goto raise_exc;
+					}
+					ow_callstack_push_segment(
+						&machine->callstack, arg_count + 1, INVOKE_IMPL_NATIVE_STACK);
+					STACK_UPDATE();
+					current_frame->new_segment = true;
+					current_frame->arg_list = stack.sp - arg_count + 1;
+					stack.fp = stack.sp + 1;
+					STACK_COMMIT();
+				}
 				const int status = cfunc_obj->code(machine);
 				STACK_UPDATE();
 				struct ow_object *const ret_val =
 					status ? *stack.sp : machine_globals->value_nil;
 				assert(current_frame->prev_ip == ip);
 				stack.fp = current_frame->prev_fp;
-				if (current_frame->not_ret_val || ow_unlikely(!ip)) {
-					stack.sp = current_frame->arg_list - 2;
-				} else {
-					stack.sp = current_frame->arg_list - 1;
-					*stack.sp = ret_val;
-				}
+				stack.sp = invoke_impl_frame_base(machine, current_frame);
+				if (!(current_frame->not_ret_val || ow_unlikely(!ip)))
+					*++stack.sp = ret_val;
 				ow_callstack_frame_info_list_leave(frame_info_list);
 				if (ow_unlikely(!ip)) {
 					STACK_COMMIT();
@@ -894,13 +1264,17 @@ static int invoke_impl(
 			} else {
 			other_func_obj_type:;
 				STACK_COMMIT();
-				const bool ok = invoke_impl_get_method_y(
-					machine, callable_obj, common_symbols->call, stack.sp - arg_count);
+				const bool ok = invoke_impl_get_op_method(
+					machine, callable_obj, callable_obj_class,
+					OW_CLASS_OP_call, common_symbols->call, stack.sp - arg_count);
 				STACK_ASSERT_NC();
 				if (ow_unlikely(!ok)) {
 					stack.sp -= arg_count;
 					goto raise_exc;
 				}
+				stack.fp = current_frame->prev_fp;
+				ow_callstack_frame_info_list_leave(frame_info_list);
+				current_frame = frame_info_list->current;
 				goto op_Call_1;
 			}
 		OP_END
@@ -913,20 +1287,27 @@ static int invoke_impl(
 			if (ow_unlikely(!name))
 				goto err_bad_operand;
 			struct ow_object *const obj = *stack.sp;
-			struct ow_class_obj *obj_class;
-			if (ow_unlikely(ow_smallint_check(obj)))
-				obj_class = builtin_classes->int_;
-			else
-				obj_class = ow_object_class(obj);
-			operand.index = ow_class_obj_find_method(obj_class, name);
-			if (ow_likely(operand.index != (size_t)-1)) {
-				*stack.sp = ow_class_obj_get_method(obj_class, operand.index);
+			struct ow_class_obj *const obj_class =
+				ow_builtin_classes_class_of(builtin_classes, obj);
+			struct ow_inline_cache *const ic =
+				ow_func_obj_inline_cache(current_func_obj, operand.index);
+			intptr_t member = ow_inline_cache_lookup(ic, obj_class);
+			if (ow_unlikely(!member)) {
+				member = ow_class_obj_find_member(obj_class, name);
+				if (member < 0) {
+					ow_inline_cache_update(ic, obj_class, member);
+					ow_objmem_write_barrier(
+						machine, ow_object_from(current_func_obj), ow_object_from(obj_class));
+				}
+			}
+			if (ow_likely(member < 0)) {
+				*stack.sp = ow_class_obj_get_method(obj_class, (size_t)(-1 - member));
 				*++stack.sp = obj;
 			} else {
 				*++stack.sp = obj;
 				STACK_COMMIT();
 				const bool ok = invoke_impl_do_find_method(
-					machine, obj, obj_class, name, stack.sp - 1);
+					machine, obj, obj_class, name, stack.sp - 1) == 0;
 				STACK_ASSERT_NC();
 				if (ow_unlikely(!ok)) {
 					stack.sp--;
@@ -1013,7 +1394,7 @@ static int invoke_impl(
 			STACK_ASSERT_NC();
 			*stack.sp = ow_object_from(obj);
 			for (size_t i = 0; i < operand.index; i++)
-				ow_map_obj_set(machine, obj, data[i], data[i + 1]);
+				ow_map_obj_set(machine, obj, data[i * 2], data[i * 2 + 1]);
 			STACK_ASSERT_NC();
 			*data = ow_object_from(obj);
 			stack.sp = data;
@@ -1024,12 +1405,323 @@ static int invoke_impl(
 			goto op_MkMap_1;
 		OP_END
 
+		OP_BEGIN(LdLoc2)
+			OPERAND(u16, operand.u16)
+			struct ow_object **const p1 = stack.fp + (operand.u16 & 0xff);
+			struct ow_object **const p2 = stack.fp + (operand.u16 >> 8);
+			if (ow_unlikely(p1 > stack.sp || p2 > stack.sp))
+				goto err_bad_operand;
+			stack.sp[1] = *p1;
+			stack.sp[2] = *p2;
+			stack.sp += 2;
+		OP_END
+
+		OP_BEGIN(AddLoc2)
+			OPERAND(u16, operand.u16)
+			struct ow_object **const p1 = stack.fp + (operand.u16 & 0xff);
+			struct ow_object **const p2 = stack.fp + (operand.u16 >> 8);
+			if (ow_unlikely(p1 > stack.sp || p2 > stack.sp))
+				goto err_bad_operand;
+			stack.sp += 2;
+			stack.sp[-1] = *p1;
+			stack.sp[0] = *p2;
+			IMPL_BIN_OP(+, add)
+		OP_END
+
+		OP_BEGIN(SubLoc2)
+			OPERAND(u16, operand.u16)
+			struct ow_object **const p1 = stack.fp + (operand.u16 & 0xff);
+			struct ow_object **const p2 = stack.fp + (operand.u16 >> 8);
+			if (ow_unlikely(p1 > stack.sp || p2 > stack.sp))
+				goto err_bad_operand;
+			stack.sp += 2;
+			stack.sp[-1] = *p1;
+			stack.sp[0] = *p2;
+			IMPL_BIN_OP(-, sub)
+		OP_END
+
+		OP_BEGIN(IncLoc)
+			OPERAND(u16, operand.u16)
+			IMPL_INC_LOC(+, add)
+		OP_END
+
+		OP_BEGIN(DecLoc)
+			OPERAND(u16, operand.u16)
+			IMPL_INC_LOC(-, sub)
+		OP_END
+
+		OP_BEGIN(LdLocMethY)
+			OPERAND(u16, operand.u16)
+			struct ow_object **const p = stack.fp + (operand.u16 & 0xff);
+			if (ow_unlikely(p > stack.sp))
+				goto err_bad_operand;
+			*++stack.sp = *p;
+			operand.index = operand.u16 >> 8;
+			goto op_PrepMethY_1;
+		OP_END
+
+#define IMPL_JMP_UNLS_CMP_OP(OPERATOR, OPERAND_TYPE, JMP_UNLS_NAME) \
+	struct ow_object *const lhs = stack.sp[-1]; \
+	struct ow_object *const rhs = stack.sp[0]; \
+	double lhs_f, rhs_f; \
+	if (ow_smallint_check(lhs) && ow_smallint_check(rhs)) { \
+		stack.sp -= 2; \
+		if (ow_smallint_from_ptr(lhs) OPERATOR ow_smallint_from_ptr(rhs)) { \
+			ip += sizeof(_operand_type_##OPERAND_TYPE); \
+		} else { \
+			OPERAND_(OPERAND_TYPE, operand.ptrdiff) \
+			ip = ip - 1 + operand.ptrdiff; \
+		} \
+	} else if (invoke_impl_float_operands(builtin_classes, lhs, rhs, &lhs_f, &rhs_f)) { \
+		stack.sp -= 2; \
+		if (lhs_f OPERATOR rhs_f) { \
+			ip += sizeof(_operand_type_##OPERAND_TYPE); \
+		} else { \
+			OPERAND_(OPERAND_TYPE, operand.ptrdiff) \
+			ip = ip - 1 + operand.ptrdiff; \
+		} \
+	} else { \
+		IMPL_CMP_OP_SLOW(OPERATOR) \
+		OPERAND_(OPERAND_TYPE, operand.ptrdiff) \
+		goto op_##JMP_UNLS_NAME##_1; \
+	} \
+// ^^^ IMPL_JMP_UNLS_CMP_OP() ^^^
+
+		OP_BEGIN(JmpUnlsLt)
+			IMPL_JMP_UNLS_CMP_OP(<, i8, JmpUnls)
+		OP_END
+
+		OP_BEGIN(JmpUnlsLtW)
+			IMPL_JMP_UNLS_CMP_OP(<, i16, JmpUnlsW)
+		OP_END
+
+		OP_BEGIN(JmpUnlsLe)
+			IMPL_JMP_UNLS_CMP_OP(<=, i8, JmpUnls)
+		OP_END
+
+		OP_BEGIN(JmpUnlsLeW)
+			IMPL_JMP_UNLS_CMP_OP(<=, i16, JmpUnlsW)
+		OP_END
+
+		OP_BEGIN(JmpUnlsGt)
+			IMPL_JMP_UNLS_CMP_OP(>, i8, JmpUnls)
+		OP_END
+
+		OP_BEGIN(JmpUnlsGtW)
+			IMPL_JMP_UNLS_CMP_OP(>, i16, JmpUnlsW)
+		OP_END
+
+		OP_BEGIN(JmpUnlsGe)
+			IMPL_JMP_UNLS_CMP_OP(>=, i8, JmpUnls)
+		OP_END
+
+		OP_BEGIN(JmpUnlsGeW)
+			IMPL_JMP_UNLS_CMP_OP(>=, i16, JmpUnlsW)
+		OP_END
+
+		OP_BEGIN(JmpUnlsEq)
+			IMPL_JMP_UNLS_CMP_OP(==, i8, JmpUnls)
+		OP_END
+
+		OP_BEGIN(JmpUnlsEqW)
+			IMPL_JMP_UNLS_CMP_OP(==, i16, JmpUnlsW)
+		OP_END
+
+		OP_BEGIN(JmpUnlsNe)
+			IMPL_JMP_UNLS_CMP_OP(!=, i8, JmpUnls)
+		OP_END
+
+		OP_BEGIN(JmpUnlsNeW)
+			IMPL_JMP_UNLS_CMP_OP(!=, i16, JmpUnlsW)
+		OP_END
+
+#define IMPL_BIN_OP_SMI(OPERATOR, GENERIC_NAME) \
+	struct ow_object *const lhs = stack.sp[-1]; \
+	struct ow_object *const rhs = stack.sp[0]; \
+	if (ow_unlikely(!(ow_smallint_check(lhs) && ow_smallint_check(rhs)))) { \
+		QUICKEN_TO(GENERIC_NAME); \
+		goto op_##GENERIC_NAME##_1; \
+	} \
+	const ow_smallint_t res = \
+		ow_smallint_from_ptr(lhs) OPERATOR ow_smallint_from_ptr(rhs); \
+	stack.sp--; \
+	*stack.sp = MAKE_INT(res); \
+// ^^^ IMPL_BIN_OP_SMI() ^^^
+
+#define IMPL_CMP_OP_SMI(OPERATOR, GENERIC_NAME) \
+	struct ow_object *const lhs = stack.sp[-1]; \
+	struct ow_object *const rhs = stack.sp[0]; \
+	if (ow_unlikely(!(ow_smallint_check(lhs) && ow_smallint_check(rhs)))) { \
+		QUICKEN_TO(GENERIC_NAME); \
+		goto op_##GENERIC_NAME##_1; \
+	} \
+	*--stack.sp = ow_smallint_from_ptr(lhs) OPERATOR ow_smallint_from_ptr(rhs) ? \
+		machine_globals->value_true : machine_globals->value_false; \
+// ^^^ IMPL_CMP_OP_SMI() ^^^
+
+#define IMPL_BIN_OP_FLT(OPERATOR, GENERIC_NAME) \
+	struct ow_object *const lhs = stack.sp[-1]; \
+	struct ow_object *const rhs = stack.sp[0]; \
+	if (ow_unlikely(!invoke_impl_are_floats(builtin_classes, lhs, rhs))) { \
+		QUICKEN_TO(GENERIC_NAME); \
+		goto op_##GENERIC_NAME##_1; \
+	} \
+	const double res = \
+		ow_float_obj_or_flonum_value(lhs) OPERATOR \
+		ow_float_obj_or_flonum_value(rhs); \
+	stack.sp--; \
+	*stack.sp = MAKE_FLOAT(res); \
+// ^^^ IMPL_BIN_OP_FLT() ^^^
+
+#define IMPL_CMP_OP_FLT(OPERATOR, GENERIC_NAME) \
+	struct ow_object *const lhs = stack.sp[-1]; \
+	struct ow_object *const rhs = stack.sp[0]; \
+	if (ow_unlikely(!invoke_impl_are_floats(builtin_classes, lhs, rhs))) { \
+		QUICKEN_TO(GENERIC_NAME); \
+		goto op_##GENERIC_NAME##_1; \
+	} \
+	*--stack.sp = \
+		ow_float_obj_or_flonum_value(lhs) OPERATOR \
+		ow_float_obj_or_flonum_value(rhs) ? \
+		machine_globals->value_true : machine_globals->value_false; \
+// ^^^ IMPL_CMP_OP_FLT() ^^^
+
+		OP_BEGIN(AddSmi)
+			NO_OPERAND()
+		op_AddSmi_1:;
+			IMPL_BIN_OP_SMI(+, Add)
+		OP_END
+
+		OP_BEGIN(SubSmi)
+			NO_OPERAND()
+		op_SubSmi_1:;
+			IMPL_BIN_OP_SMI(-, Sub)
+		OP_END
+
+		OP_BEGIN(MulSmi)
+			NO_OPERAND()
+		op_MulSmi_1:;
+			IMPL_BIN_OP_SMI(*, Mul)
+		OP_END
+
+		OP_BEGIN(CmpLtSmi)
+			NO_OPERAND()
+		op_CmpLtSmi_1:;
+			IMPL_CMP_OP_SMI(<, CmpLt)
+		OP_END
+
+		OP_BEGIN(CmpLeSmi)
+			NO_OPERAND()
+		op_CmpLeSmi_1:;
+			IMPL_CMP_OP_SMI(<=, CmpLe)
+		OP_END
+
+		OP_BEGIN(CmpGtSmi)
+			NO_OPERAND()
+		op_CmpGtSmi_1:;
+			IMPL_CMP_OP_SMI(>, CmpGt)
+		OP_END
+
+		OP_BEGIN(CmpGeSmi)
+			NO_OPERAND()
+		op_CmpGeSmi_1:;
+			IMPL_CMP_OP_SMI(>=, CmpGe)
+		OP_END
+
+		OP_BEGIN(CmpEqSmi)
+			NO_OPERAND()
+		op_CmpEqSmi_1:;
+			IMPL_CMP_OP_SMI(==, CmpEq)
+		OP_END
+
+		OP_BEGIN(CmpNeSmi)
+			NO_OPERAND()
+		op_CmpNeSmi_1:;
+			IMPL_CMP_OP_SMI(!=, CmpNe)
+		OP_END
+
+		OP_BEGIN(AddFlt)
+			NO_OPERAND()
+		op_AddFlt_1:;
+			IMPL_BIN_OP_FLT(+, Add)
+		OP_END
+
+		OP_BEGIN(SubFlt)
+			NO_OPERAND()
+		op_SubFlt_1:;
+			IMPL_BIN_OP_FLT(-, Sub)
+		OP_END
+
+		OP_BEGIN(MulFlt)
+			NO_OPERAND()
+		op_MulFlt_1:;
+			IMPL_BIN_OP_FLT(*, Mul)
+		OP_END
+
+		OP_BEGIN(DivFlt)
+			NO_OPERAND()
+		op_DivFlt_1:;
+			IMPL_BIN_OP_FLT(/, Div)
+		OP_END
+
+		OP_BEGIN(CmpLtFlt)
+			NO_OPERAND()
+		op_CmpLtFlt_1:;
+			IMPL_CMP_OP_FLT(<, CmpLt)
+		OP_END
+
+		OP_BEGIN(CmpLeFlt)
+			NO_OPERAND()
+		op_CmpLeFlt_1:;
+			IMPL_CMP_OP_FLT(<=, CmpLe)
+		OP_END
+
+		OP_BEGIN(CmpGtFlt)
+			NO_OPERAND()
+		op_CmpGtFlt_1:;
+			IMPL_CMP_OP_FLT(>, CmpGt)
+		OP_END
+
+		OP_BEGIN(CmpGeFlt)
+			NO_OPERAND()
+		op_CmpGeFlt_1:;
+			IMPL_CMP_OP_FLT(>=, CmpGe)
+		OP_END
+
+#undef IMPL_BIN_OP_SMI
+#undef IMPL_CMP_OP_SMI
+#undef IMPL_BIN_OP_FLT
+#undef IMPL_CMP_OP_FLT
+#undef QUICKEN_TO
+#undef QUICKEN_SMI
+#undef QUICKEN_FLT
+
+#undef IMPL_JMP_UNLS_CMP_OP
+#undef IMPL_CMP_OP_SLOW
+#undef IMPL_CMP_OP
+#undef IMPL_ARITH_OP
+#undef IMPL_BIN_OP_SLOW
+#undef IMPL_BIN_OP
+
+		OP_RESERVED(_01)
+		OP_RESERVED(_03)
+		OP_RESERVED(_0f)
+		OP_RESERVED(_1e)
+		OP_RESERVED(_1f)
+		OP_RESERVED(_4b)
+		OP_RESERVED(_4c)
+		OP_RESERVED(_4d)
+
 #undef OP_BEGIN
 #undef OP_END
+#undef OP_RESERVED
 #undef OPERAND
 #undef NO_OPERAND
 
 		default:
+#if INVOKE_IMPL_COMPUTED_GOTO
+		err_bad_opcode:
+#endif // INVOKE_IMPL_COMPUTED_GOTO
 			ip--;
 			*++stack.sp = ow_object_from(ow_exception_format(
 				machine, NULL, "unrecognized opcode `%#04x' at %p", *ip, ip));
@@ -1057,9 +1749,17 @@ static int invoke_impl(
 				machine, NULL, "condition value is not a boolean object"));
 			goto raise_exc;
 
+		err_out_of_memory:
+			// Checked at backward jumps and calls, so that a loop cannot go on forever.
+			machine->out_of_memory = false;
+			STACK_COMMIT();
+			*++stack.sp = ow_object_from(ow_exception_format(
+				machine, NULL, "out of memory"));
+			goto raise_exc;
+
 		raise_exc:
 			operand.pointer = *stack.sp; // The exception to raise.
-			if (ow_unlikely(ow_smallint_check(operand.pointer) ||
+			if (ow_unlikely(ow_object_is_immediate(operand.pointer) ||
 					!ow_class_obj_is_base(builtin_classes->exception,
 						ow_object_class(operand.pointer)))) {
 				operand.pointer = ow_object_from(ow_exception_format(
@@ -1068,7 +1768,7 @@ static int invoke_impl(
 			}
 			while (1) {
 				ow_exception_obj_backtrace_append(
-					operand.pointer,
+					machine, operand.pointer,
 					&(const struct ow_exception_obj_frame_info){
 						.ip = ip,
 						.function = ow_object_from(current_func_obj),
@@ -1077,7 +1777,7 @@ static int invoke_impl(
 
 				ip = current_frame->prev_ip;
 				stack.fp = current_frame->prev_fp;
-				stack.sp = current_frame->arg_list - 2;
+				stack.sp = invoke_impl_frame_base(machine, current_frame);
 
 				struct ow_callstack_frame_info_list *const frame_info_list =
 					&machine->callstack.frame_info_list;
@@ -1102,20 +1802,72 @@ static int invoke_impl(
 #undef STACK_COMMIT
 #undef STACK_UPDATE
 #undef STACK_ASSERT_NC
+#undef MAKE_INT
+#undef MAKE_FLOAT
+}
+
+#if INVOKE_IMPL_COMPUTED_GOTO
+#	pragma GCC diagnostic pop
+#endif
+
+#if OW_CALLSTACK_GUARD
+
+/// Call `invoke_impl()` with a guarded stack. Turn stack overflow into an exception.
+ow_noinline static int invoke_guarded(
+		struct ow_machine *om, int argc, struct ow_object **res_out) {
+	struct ow_callstack *const callstack = &om->callstack;
+	struct ow_object **const sp = callstack->regs.sp - argc - 1;
+	struct ow_object **const fp = callstack->regs.fp;
+	struct ow_callstack_frame_info *const fi = callstack->frame_info_list.current;
+
+	struct ow_callstack_trap trap;
+	ow_callstack_trap_enter(&trap, callstack);
+	if (sigsetjmp(trap.env, 0)) {
+		callstack->regs.sp = sp;
+		callstack->regs.fp = fp;
+		while (callstack->frame_info_list.current != fi)
+			ow_callstack_frame_info_list_leave(&callstack->frame_info_list);
+		*res_out = ow_object_from(ow_exception_format(om, NULL, "stack overflow"));
+		return -1;
+	}
+	const int status = invoke_impl(om, argc, res_out);
+	ow_callstack_trap_leave(&trap);
+	return status;
 }
 
+#endif // OW_CALLSTACK_GUARD
+
 int ow_machine_invoke(
 		struct ow_machine *om, int argc, struct ow_object **res_out) {
+#if OW_CALLSTACK_GUARD
+	if (ow_unlikely(ow_callstack_is_guarded(&om->callstack)))
+		return invoke_guarded(om, argc, res_out);
+#endif // OW_CALLSTACK_GUARD
 	return invoke_impl(om, argc, res_out);
 }
 
 int ow_machine_call(
 		struct ow_machine *om, struct ow_object *func,
 		int argc, struct ow_object *argv[], struct ow_object **res_out) {
+	struct ow_callstack *const stack = &om->callstack;
+	// If current segment is full, push the callable object and arguments to a
+	// temporary one, which is popped after the call.
+	bool new_segment = false;
+	if (ow_unlikely(!ow_callstack_has_space(stack, stack->regs.sp, (size_t)argc + 1))) {
+		if (ow_callstack_is_guarded(stack)) {
+			*res_out = ow_object_from(ow_exception_format(om, NULL, "stack overflow"));
+			return -1;
+		}
+		ow_callstack_push_segment(stack, 0, (size_t)argc + 1);
+		new_segment = true;
+	}
 	ow_callstack_push(om->callstack, func);
 	for (int i = 0; i < argc; i++)
 		ow_callstack_push(om->callstack, argv[i]);
-	return ow_machine_invoke(om, argc, res_out);
+	const int status = ow_machine_invoke(om, argc, res_out);
+	if (ow_unlikely(new_segment))
+		stack->regs.sp = ow_callstack_pop_segment(stack);
+	return status;
 }
 
 int ow_machine_call_method(
@@ -1125,8 +1877,7 @@ int ow_machine_call_method(
 	assert(argv || om->callstack.regs.sp > om->callstack.regs.fp);
 	struct ow_object *const obj = argv ? argv[0] : om->callstack.regs.sp[1 - argc];
 	struct ow_class_obj *const obj_class =
-		ow_unlikely(ow_smallint_check(obj)) ?
-			om->builtin_classes->int_ : ow_object_class(obj);
+		ow_builtin_classes_class_of(om->builtin_classes, obj);
 	const size_t index = ow_class_obj_find_method(obj_class, method_name);
 	struct ow_object *method;
 	if (ow_likely(index != (size_t)-1)) {
@@ -1134,7 +1885,7 @@ int ow_machine_call_method(
 	} else {
 		ow_objmem_push_ngc(om);
 		const bool ok = invoke_impl_do_find_method(
-			om, obj, obj_class, method_name, &method);
+			om, obj, obj_class, method_name, &method) == 0;
 		ow_objmem_pop_ngc(om);
 		if (ow_unlikely(!ok)) {
 			ow_object_from(ow_exception_format(
@@ -1157,11 +1908,8 @@ int ow_machine_call_native(
 	if (argc > (UINT8_MAX >> 1))
 		argc = UINT8_MAX >> 1;
 	struct ow_cfunc_obj *const func_obj =
-		ow_cfunc_obj_new(om, mod, "", func, (struct ow_func_spec){0, (uint8_t)argc});
-	ow_callstack_push(om->callstack, ow_object_from(func_obj));
-	for (int i = 0; i < argc; i++)
-		ow_callstack_push(om->callstack, argv[i]);
-	return ow_machine_invoke(om, argc, res_out);
+		ow_cfunc_obj_new(om, mod, "", func, (struct ow_func_spec){0, (uint8_t)argc, 0});
+	return ow_machine_call(om, ow_object_from(func_obj), argc, argv, res_out);
 }
 
 int ow_machine_run(
@@ -1174,11 +1922,10 @@ int ow_machine_run(
 	struct ow_object *const init_func =
 		ow_module_obj_get_global_y(module, sym_anon);
 	if (init_func && init_func != nil) {
-		ow_callstack_push(om->callstack, init_func);
-		const int status = ow_machine_invoke(om, 0, res_out);
+		const int status = ow_machine_call(om, init_func, 0, NULL, res_out);
 		if (ow_unlikely(status))
 			return status;
-		ow_module_obj_set_global_y(module, sym_anon, nil);
+		ow_module_obj_set_global_y(om, module, sym_anon, nil);
 		if (!call_main)
 			return 0;
 	} else {
@@ -1191,8 +1938,7 @@ int ow_machine_run(
 	struct ow_object *const main_func =
 		ow_module_obj_get_global_y(module, sym_main);
 	if (main_func && main_func != nil) {
-		ow_callstack_push(om->callstack, main_func);
-		return ow_machine_invoke(om, 0, res_out);
+		return ow_machine_call(om, main_func, 0, NULL, res_out);
 	} else {
 		*res_out = nil;
 		return 0;
@@ -1,6 +1,7 @@
 #include "machine.h"
 
 #include <assert.h>
+#include <stdlib.h>
 
 #ifndef NDEBUG
 #	include <string.h>
@@ -14,6 +15,7 @@
 #include <objects/classes.h>
 #include <objects/memory.h>
 #include <objects/symbolobj.h>
+#include <utilities/hash.h>
 #include <utilities/malloc.h>
 
 static size_t stack_size(void) {
@@ -23,13 +25,25 @@ static size_t stack_size(void) {
 }
 
 struct ow_machine *ow_machine_new(void) {
-	struct ow_machine *const om = ow_malloc(sizeof(struct ow_machine));
+	ow_hash_init();
+
+	const struct ow_allocator allocator = ow_sysparam.allocator;
+	const struct ow_allocator *const allocator_p = allocator.allocate ? &allocator : NULL;
+	struct ow_machine *const om = ow_aligned_alloc(
+		allocator_p, _Alignof(struct ow_machine), sizeof(struct ow_machine));
+	if (ow_unlikely(!om))
+		abort(); // Out of memory.
 
 #ifndef NDEBUG
 	memset(om, 0, sizeof *om);
 #endif // NDEBUG
 
-	om->objmem_context = ow_objmem_context_new();
+	om->_allocator_data = allocator;
+	om->allocator = allocator_p ? &om->_allocator_data : NULL;
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
+
+	om->out_of_memory = false;
+	om->objmem_context = ow_objmem_context_new(om->allocator);
 	om->builtin_classes = _ow_builtin_classes_new(om);
 	om->symbol_pool = ow_symbol_pool_new();
 	_ow_builtin_classes_setup(om, om->builtin_classes);
@@ -37,7 +51,9 @@ struct ow_machine *ow_machine_new(void) {
 	om->module_manager = ow_module_manager_new(om);
 	om->common_symbols = ow_common_symbols_new(om);
 	om->globals = ow_machine_globals_new(om);
-	ow_callstack_init(&om->callstack, stack_size());
+	ow_callstack_init(
+		&om->callstack, stack_size(), ow_sysparam.stack_reserve,
+		ow_sysparam.max_call_depth);
 
 	if (ow_unlikely(ow_sysparam.verbose_memory))
 		ow_objmem_context_verbose(om->objmem_context, true);
@@ -50,11 +66,13 @@ struct ow_machine *ow_machine_new(void) {
 
 	assert(!ow_objmem_test_ngc(om));
 
+	ow_malloc_set_allocator(prev_allocator);
 	return om;
 }
 
 void ow_machine_del(struct ow_machine *om) {
 	assert(!ow_objmem_test_ngc(om));
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
 
 	// The following lines are trying to delete all objects to avoid memory leaks.
 	// But the operations are quite dangerous and are not allowed anywhere else.
@@ -62,49 +80,95 @@ void ow_machine_del(struct ow_machine *om) {
 	ow_callstack_clear(&om->callstack);
 	ow_module_manager_del(om->module_manager);
 	om->module_manager = NULL;
-	ow_objmem_gc(om, 0);
+	ow_objmem_gc(om, OW_OBJMEM_GC_FULL);
 
 	_ow_builtin_classes_cleanup(om, om->builtin_classes);
 	ow_common_symbols_del(om->common_symbols);
 	ow_machine_globals_del(om->globals);
 	om->common_symbols = NULL;
 	om->globals = NULL;
-	ow_objmem_gc(om, 0);
+	ow_objmem_gc(om, OW_OBJMEM_GC_FULL);
 
 	ow_symbol_pool_del(om->symbol_pool);
 	_ow_builtin_classes_del(om, om->builtin_classes, true);
 	ow_objmem_context_del(om->objmem_context);
 	ow_callstack_fini(&om->callstack);
 
-	ow_free(om);
+	// The allocator structure lives in the context, which is to be freed.
+	const struct ow_allocator *const restored_allocator =
+		prev_allocator == om->allocator ? NULL : prev_allocator;
+	const struct ow_allocator allocator = om->_allocator_data;
+	ow_aligned_free(
+		om->allocator ? &allocator : NULL,
+		om, _Alignof(struct ow_machine), sizeof(struct ow_machine));
+	ow_malloc_set_allocator(restored_allocator);
+}
+
+const struct ow_allocator *ow_machine_use_allocator(struct ow_machine *om) {
+	const struct ow_allocator *const prev_allocator = ow_malloc_get_allocator();
+	ow_malloc_set_allocator(om->allocator);
+	return prev_allocator;
+}
+
+void _ow_machine_stack_grow(struct ow_machine *om, size_t n) {
+	struct ow_callstack *const stack = &om->callstack;
+	struct ow_callstack_frame_info *const fi = stack->frame_info_list.current;
+	// The callable object, arguments and locals of the frame are kept together.
+	struct ow_object **const base = fi ? fi->arg_list - 1 : stack->_data;
+	const size_t keep = (size_t)(stack->regs.sp + 1 - base);
+	const size_t fp_offset = (size_t)(stack->regs.fp - base);
+
+	if (ow_callstack_is_guarded(stack)) {
+		// A guarded stack cannot grow. Use the headroom below the guard page.
+		if ((size_t)(stack->_segment->data_end - stack->regs.sp) > n)
+			return;
+		abort(); // Stack overflow in native code.
+	}
+
+	const struct ow_allocator *const prev_allocator = ow_machine_use_allocator(om);
+	if (base == stack->_data) {
+		// The frame is all that the segment holds.
+		ow_callstack_grow_segment(stack, n);
+	} else {
+		assert(fi);
+		ow_callstack_push_segment(stack, keep, n);
+		fi->new_segment = true;
+	}
+	ow_malloc_set_allocator(prev_allocator);
+
+	struct ow_object **const new_base = stack->regs.sp + 1 - keep;
+	stack->regs.fp = new_base + fp_offset;
+	if (fi)
+		fi->arg_list = new_base + 1;
 }
 
 void ow_machine_setjmp(struct ow_machine *om, struct ow_machine_jmpbuf *jb) {
-	jb->sp = om->callstack.regs.sp;
-	jb->fp = om->callstack.regs.fp;
-	jb->fi = om->callstack.frame_info_list.current;
+	struct ow_callstack_frame_info *const fi = om->callstack.frame_info_list.current;
+	jb->fi = fi;
+	if (fi) {
+		jb->sp = om->callstack.regs.sp - fi->arg_list;
+		jb->fp = om->callstack.regs.fp - fi->arg_list;
+	} else {
+		jb->sp = 0;
+		jb->fp = 0;
+	}
 }
 
 bool ow_machine_longjmp(struct ow_machine *om, struct ow_machine_jmpbuf *jb) {
-	if (!(
-		jb->sp && jb->fp && jb->fi &&
-		(struct ow_object **)jb->sp <= om->callstack.regs.sp &&
-		(struct ow_object **)jb->fp <= om->callstack.regs.fp &&
-		(struct ow_object **)jb->sp >= (struct ow_object **)jb->fp - 1
-	)) {
+	const struct ow_callstack_frame_info_list *const fi_list =
+		&om->callstack.frame_info_list;
+	struct ow_callstack_frame_info *const fi = jb->fi;
+	if (!(fi && fi_list->current && fi >= fi_list->_data && fi <= fi_list->current))
+		return false;
+	if (!(jb->sp >= jb->fp - 1 && jb->fp >= 0))
+		return false;
+	struct ow_object **const sp = fi->arg_list + jb->sp;
+	if (!ow_callstack_unwind_segments(&om->callstack, sp))
 		return false;
-	}
-	for (struct ow_callstack_frame_info *fi =
-			om->callstack.frame_info_list.current; ; fi = fi->_next) {
-		if (!fi)
-			return false;
-		if (fi == jb->fi)
-			break;
-	}
 
-	om->callstack.regs.sp = jb->sp;
-	om->callstack.regs.fp = jb->fp;
-	while (om->callstack.frame_info_list.current != jb->fi) {
+	om->callstack.regs.sp = sp;
+	om->callstack.regs.fp = fi->arg_list + jb->fp;
+	while (om->callstack.frame_info_list.current != fi) {
 		assert(om->callstack.frame_info_list.current);
 		ow_callstack_frame_info_list_leave(&om->callstack.frame_info_list);
 	}
@@ -121,5 +185,4 @@ void _om_machine_gc_marker(struct ow_machine *om) {
 	if (ow_likely(om->globals))
 		_ow_machine_globals_gc_marker(om, om->globals);
 	_ow_callstack_gc_marker(om, &om->callstack);
-	_ow_symbol_pool_gc_handler(om, om->symbol_pool); // Must be called at last.
 }
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <stddef.h>
+
 #include "stack.h"
 
+#include <ow.h>
+
 struct ow_builtin_classes;
 struct ow_machine_globals;
 struct ow_module_manager;
@@ -17,21 +21,45 @@ struct ow_machine {
 	struct ow_common_symbols *common_symbols;
 	struct ow_machine_globals *globals;
 	struct ow_callstack callstack;
+	_Bool out_of_memory; // Set when the heap exceeds the limit. To be raised as an exception.
+	const struct ow_allocator *allocator; // Allocator of all the memory, or NULL for the C library.
+	struct ow_allocator _allocator_data; // Copy of a custom allocator.
 };
 
 /// Jump buffer.
 struct ow_machine_jmpbuf {
-	void *sp, *fp, *fi;
+	void *fi;
+	ptrdiff_t sp, fp; // Relative to the argument list of the frame, which may be moved.
 };
 
-/// Create a context.
+/// Create a context. Memory is allocated with `ow_sysparam.allocator`.
+/// The current allocator of this thread is left unchanged.
 struct ow_machine *ow_machine_new(void);
 /// Destroy a context.
 void ow_machine_del(struct ow_machine *om);
 
+/// Make the allocator of the context the current one of this thread and return
+/// the previous one. Shall be called when entering the context from outside,
+/// and the previous allocator restored with `ow_malloc_set_allocator()` on leaving.
+const struct ow_allocator *ow_machine_use_allocator(struct ow_machine *om);
+
+/// Make sure that there is space for `n` more objects on stack, which is used by
+/// current native function or the host program. If current segment is full, the
+/// objects of current frame are moved to a new segment.
+/// A guarded stack cannot grow; its headroom is used instead, and the program is
+/// aborted if that is full too.
+ow_static_forceinline void ow_machine_stack_reserve(struct ow_machine *om, size_t n);
+
 /// Store context.
 void ow_machine_setjmp(struct ow_machine *om, struct ow_machine_jmpbuf *jb);
 /// Jump back to stored context.
 _Bool ow_machine_longjmp(struct ow_machine *om, struct ow_machine_jmpbuf *jb);
 
 void _om_machine_gc_marker(struct ow_machine *om);
+
+void _ow_machine_stack_grow(struct ow_machine *om, size_t n);
+
+ow_static_forceinline void ow_machine_stack_reserve(struct ow_machine *om, size_t n) {
+	if (ow_unlikely(!ow_callstack_has_space(&om->callstack, om->callstack.regs.sp, n)))
+		_ow_machine_stack_grow(om, n);
+}
@@ -108,7 +108,7 @@ bool ow_module_manager_add_path(
 		struct ow_array *const paths = ow_array_obj_data(mm->path_array);
 		for (size_t i = 0, n = ow_array_size(paths); i < n; i++) {
 			struct ow_object *const path_o = ow_array_at(paths, i);
-			if (ow_smallint_check(path_o) ||
+			if (ow_object_is_immediate(path_o) ||
 					ow_object_class(path_o) != mm->machine->builtin_classes->string)
 				continue;
 			const char *const str = ow_string_obj_flatten(
@@ -122,6 +122,8 @@ bool ow_module_manager_add_path(
 			struct ow_string_obj *const path_str_o =
 				ow_string_obj_new(mm->machine, path_str, (size_t)-1);
 			ow_array_append(paths, path_str_o);
+			ow_objmem_write_barrier(
+				mm->machine, ow_object_from(mm->path_array), ow_object_from(path_str_o));
 		}
 #if _IS_WINDOWS_
 		ow_free((void *)path_str);
@@ -165,7 +167,7 @@ struct ow_module_manager_locator ow_module_manager_search(
 	struct ow_array *const paths = ow_array_obj_data(mm->path_array);
 	for (size_t i = 0, n = ow_array_size(paths); i < n; i++) {
 		struct ow_object *const path_o = ow_array_at(paths, i);
-		if (ow_smallint_check(path_o) ||
+		if (ow_object_is_immediate(path_o) ||
 				ow_object_class(path_o) != mm->machine->builtin_classes->string)
 			continue;
 		const char *const str = ow_string_obj_flatten(
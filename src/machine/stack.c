@@ -1,77 +1,278 @@
 #include "stack.h"
 
 #include <assert.h>
+#include <string.h>
 
 #include <objects/memory.h>
 #include <utilities/attributes.h>
 #include <utilities/malloc.h>
 
+#if OW_CALLSTACK_GUARD
+#	include <pthread.h>
+#	include <signal.h>
+#	include <sys/mman.h>
+#	include <unistd.h>
+#	include <utilities/thread.h> // thread_local
+#endif // OW_CALLSTACK_GUARD
+
 #define CALLSTACK_MIN 64
 
+#define CALLSTACK_DEPTH_MIN 16
+
+/// Number of objects between `data_end` and the guard page of a guarded stack,
+/// which native functions may use.
+#define CALLSTACK_GUARD_HEADROOM 1024
+
 static void ow_callstack_frame_info_list_init(
-		struct ow_callstack_frame_info_list *list) {
+		struct ow_callstack_frame_info_list *list, size_t max_depth) {
+	list->_data = ow_malloc(sizeof(struct ow_callstack_frame_info) * max_depth);
+	list->_data_end = list->_data + max_depth;
+	list->_top = list->_data;
 	list->current = NULL;
-	list->_free_list = NULL;
 }
 
 static void ow_callstack_frame_info_list_fini(
 		struct ow_callstack_frame_info_list *list) {
-	struct ow_callstack_frame_info *const lists[2] = {list->current, list->_free_list};
-	for (size_t i = 0; i < 2; i++) {
-		for (struct ow_callstack_frame_info *fi = lists[i]; fi; ) {
-			struct ow_callstack_frame_info *const next_fi = fi->_next;
-			ow_free(fi);
-			fi = next_fi;
-		}
+	ow_free(list->_data);
+}
+
+static struct ow_callstack_segment *ow_callstack_segment_new(
+		struct ow_callstack_segment *prev, size_t n) {
+	struct ow_callstack_segment *const seg = ow_malloc(
+		sizeof(struct ow_callstack_segment) + sizeof(struct ow_object *) * n);
+	seg->prev = prev;
+	seg->next = NULL;
+	seg->prev_top = NULL;
+	seg->data_end = seg->data + n;
+	return seg;
+}
+
+/// Delete a segment and the unused ones after it.
+static void ow_callstack_segment_del_chain(struct ow_callstack_segment *seg) {
+	while (seg) {
+		struct ow_callstack_segment *const next = seg->next;
+		ow_free(seg);
+		seg = next;
 	}
 }
 
-void ow_callstack_frame_info_list_enter(
-		struct ow_callstack_frame_info_list *list) {
-	struct ow_callstack_frame_info *fi;
-	if (ow_likely(list->_free_list)) {
-		fi = list->_free_list;
-		list->_free_list = fi->_next;
+#if OW_CALLSTACK_GUARD
+
+/// Last registered trap of current thread.
+static thread_local struct ow_callstack_trap *current_trap = NULL;
+
+static struct sigaction prev_sigsegv_action;
+
+/// Page size, got when installing the signal handler, where `sysconf()` is not safe.
+static size_t guard_page_size;
+
+static void ow_callstack_sigsegv_handler(int sig, siginfo_t *info, void *context) {
+	const unsigned char *const addr = info->si_addr;
+	for (struct ow_callstack_trap *trap = current_trap; trap; trap = trap->prev) {
+		const unsigned char *const guard_page = trap->stack->_guard_page;
+		if (guard_page && addr >= guard_page && addr < guard_page + guard_page_size) {
+			current_trap = trap->prev;
+			siglongjmp(trap->env, 1);
+		}
+	}
+
+	// Not a stack overflow. Let the previous handler deal with it.
+	if (prev_sigsegv_action.sa_flags & SA_SIGINFO) {
+		prev_sigsegv_action.sa_sigaction(sig, info, context);
+	} else if (prev_sigsegv_action.sa_handler == SIG_DFL ||
+			prev_sigsegv_action.sa_handler == SIG_IGN) {
+		// Restore the default action. The fault happens again after returning.
+		sigaction(SIGSEGV, &(struct sigaction){.sa_handler = SIG_DFL}, NULL);
 	} else {
-		fi = ow_malloc(sizeof(struct ow_callstack_frame_info));
+		prev_sigsegv_action.sa_handler(sig);
 	}
-	fi->_next = list->current;
-	list->current = fi;
 }
 
-void ow_callstack_frame_info_list_leave(
-		struct ow_callstack_frame_info_list *list) {
-	assert(list->current);
-	struct ow_callstack_frame_info *const fi = list->current;
-	list->current = fi->_next;
-	fi->_next = list->_free_list;
-	list->_free_list = fi;
+static void ow_callstack_install_sigsegv_handler(void) {
+	guard_page_size = (size_t)sysconf(_SC_PAGESIZE);
+	struct sigaction action;
+	memset(&action, 0, sizeof action);
+	action.sa_sigaction = ow_callstack_sigsegv_handler;
+	// SA_NODEFER: the handler does not return normally, so the signal must not
+	// remain blocked after jumping out of it.
+	action.sa_flags = SA_SIGINFO | SA_NODEFER | SA_ONSTACK;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGSEGV, &action, &prev_sigsegv_action);
+}
+
+/// Create the only segment of a guarded stack, which holds `n` objects and the
+/// headroom. Return NULL on failure.
+static struct ow_callstack_segment *ow_callstack_segment_new_guarded(
+		struct ow_callstack *stack, size_t n) {
+	static pthread_once_t handler_installed = PTHREAD_ONCE_INIT;
+	pthread_once(&handler_installed, ow_callstack_install_sigsegv_handler);
+
+	const size_t pg_size = guard_page_size;
+	const size_t data_size = sizeof(struct ow_callstack_segment) +
+		sizeof(struct ow_object *) * (n + CALLSTACK_GUARD_HEADROOM);
+	const size_t mapping_size = (data_size + pg_size - 1) / pg_size * pg_size + pg_size;
+	// Pages are not committed until they are touched.
+	unsigned char *const mapping = mmap(
+		NULL, mapping_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (mapping == MAP_FAILED)
+		return NULL;
+	unsigned char *const guard_page = mapping + mapping_size - pg_size;
+	if (mprotect(guard_page, pg_size, PROT_NONE) != 0) {
+		munmap(mapping, mapping_size);
+		return NULL;
+	}
+
+	struct ow_callstack_segment *const seg = (struct ow_callstack_segment *)mapping;
+	seg->prev = NULL;
+	seg->next = NULL;
+	seg->prev_top = NULL;
+	seg->data_end = (struct ow_object **)guard_page;
+	stack->_guard_page = guard_page;
+	stack->_mapping_size = mapping_size;
+	return seg;
+}
+
+void ow_callstack_trap_enter(
+		struct ow_callstack_trap *trap, const struct ow_callstack *stack) {
+	assert(ow_callstack_is_guarded(stack));
+	trap->stack = stack;
+	trap->prev = current_trap;
+	current_trap = trap;
 }
 
-void ow_callstack_init(struct ow_callstack *stack, size_t n) {
+void ow_callstack_trap_leave(struct ow_callstack_trap *trap) {
+	assert(current_trap == trap);
+	current_trap = trap->prev;
+}
+
+#endif // OW_CALLSTACK_GUARD
+
+/// Make `seg` the current segment.
+static void ow_callstack_set_segment(
+		struct ow_callstack *stack, struct ow_callstack_segment *seg) {
+	stack->_segment = seg;
+	stack->_data = seg->data;
+	stack->data_end = seg->data_end;
+	if (ow_callstack_is_guarded(stack))
+		stack->data_end -= CALLSTACK_GUARD_HEADROOM;
+}
+
+void ow_callstack_init(
+		struct ow_callstack *stack, size_t n, size_t reserve, size_t max_depth) {
 	if (n < CALLSTACK_MIN)
 		n = CALLSTACK_MIN;
-	stack->_data = ow_malloc(sizeof(struct ow_object *) * n);
+	if (max_depth < CALLSTACK_DEPTH_MIN)
+		max_depth = CALLSTACK_DEPTH_MIN;
+	stack->_segment_size = n;
+	stack->_guard_page = NULL;
+	stack->_mapping_size = 0;
+	struct ow_callstack_segment *seg = NULL;
+#if OW_CALLSTACK_GUARD
+	if (reserve)
+		seg = ow_callstack_segment_new_guarded(stack, reserve);
+#else // !OW_CALLSTACK_GUARD
+	ow_unused_var(reserve);
+#endif // OW_CALLSTACK_GUARD
+	if (!seg)
+		seg = ow_callstack_segment_new(NULL, n);
+	ow_callstack_set_segment(stack, seg);
 	stack->regs.sp = stack->_data - 1;
 	stack->regs.fp = stack->_data;
-	stack->data_end = stack->_data + n;
-	ow_callstack_frame_info_list_init(&stack->frame_info_list);
+	ow_callstack_frame_info_list_init(&stack->frame_info_list, max_depth);
 }
 
 void ow_callstack_fini(struct ow_callstack *stack) {
 	ow_callstack_frame_info_list_fini(&stack->frame_info_list);
-	ow_free(stack->_data);
+	struct ow_callstack_segment *seg = stack->_segment;
+	while (seg->prev)
+		seg = seg->prev;
+#if OW_CALLSTACK_GUARD
+	if (ow_callstack_is_guarded(stack)) {
+		assert(!seg->next);
+		munmap(seg, stack->_mapping_size);
+		return;
+	}
+#endif // OW_CALLSTACK_GUARD
+	ow_callstack_segment_del_chain(seg);
 }
 
 void ow_callstack_clear(struct ow_callstack *stack) {
+	while (stack->_segment->prev)
+		ow_callstack_pop_segment(stack);
 	stack->regs.sp = stack->_data - 1;
 	stack->regs.fp = stack->_data;
 }
 
+void ow_callstack_push_segment(struct ow_callstack *stack, size_t keep, size_t n) {
+	struct ow_callstack_segment *const cur_seg = stack->_segment;
+	struct ow_object **const sp = stack->regs.sp;
+	assert((size_t)(sp + 1 - stack->_data) >= keep);
+	assert(!ow_callstack_is_guarded(stack));
+
+	struct ow_callstack_segment *seg = cur_seg->next;
+	if (!seg || (size_t)(seg->data_end - seg->data) < keep + n) {
+		size_t size = stack->_segment_size;
+		if (size < keep + n)
+			size = keep + n;
+		ow_callstack_segment_del_chain(seg);
+		seg = ow_callstack_segment_new(cur_seg, size);
+		cur_seg->next = seg;
+	}
+
+	struct ow_object **const moved = sp + 1 - keep;
+	seg->prev_top = moved - 1;
+	memcpy(seg->data, moved, sizeof(struct ow_object *) * keep);
+	ow_callstack_set_segment(stack, seg);
+	stack->regs.sp = seg->data + keep - 1;
+}
+
+void ow_callstack_grow_segment(struct ow_callstack *stack, size_t n) {
+	struct ow_callstack_segment *const old_seg = stack->_segment;
+	const size_t keep = (size_t)(stack->regs.sp + 1 - old_seg->data);
+	assert(!ow_callstack_is_guarded(stack));
+
+	size_t size = (size_t)(old_seg->data_end - old_seg->data) * 2;
+	if (size < keep + n)
+		size = keep + n;
+	struct ow_callstack_segment *const seg = ow_callstack_segment_new(old_seg->prev, size);
+	seg->prev_top = old_seg->prev_top;
+	memcpy(seg->data, old_seg->data, sizeof(struct ow_object *) * keep);
+	if (seg->prev)
+		seg->prev->next = seg;
+	ow_callstack_segment_del_chain(old_seg);
+	ow_callstack_set_segment(stack, seg);
+	stack->regs.sp = seg->data + keep - 1;
+}
+
+struct ow_object **ow_callstack_pop_segment(struct ow_callstack *stack) {
+	struct ow_callstack_segment *const seg = stack->_segment;
+	assert(seg->prev);
+	// Keep this segment for reuse, but not the ones after it.
+	ow_callstack_segment_del_chain(seg->next);
+	seg->next = NULL;
+	ow_callstack_set_segment(stack, seg->prev);
+	return seg->prev_top;
+}
+
+bool ow_callstack_unwind_segments(struct ow_callstack *stack, struct ow_object **sp) {
+	const struct ow_callstack_segment *seg = stack->_segment;
+	while (!(sp >= seg->data - 1 && sp < seg->data_end)) {
+		seg = seg->prev;
+		if (!seg)
+			return false;
+	}
+	while (stack->_segment != seg)
+		ow_callstack_pop_segment(stack);
+	return true;
+}
+
 void _ow_callstack_gc_marker(struct ow_machine *om, struct ow_callstack *stack) {
-	assert(stack->regs.sp < stack->data_end);
-	for (struct ow_object **p = stack->_data, **const p_end = stack->regs.sp;
-			p < p_end; p++) {
-		ow_objmem_object_gc_marker(om, *p);
+	struct ow_object **top = stack->regs.sp;
+	for (const struct ow_callstack_segment *seg = stack->_segment; seg; seg = seg->prev) {
+		assert(top < seg->data_end);
+		for (struct ow_object *const *p = seg->data; p <= top; p++)
+			ow_objmem_object_gc_marker(om, *p);
+		top = seg->prev_top;
 	}
 }
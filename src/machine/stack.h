@@ -1,30 +1,51 @@
 #pragma once
 
+#include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
 
+#include <utilities/attributes.h>
+
+#if defined(__linux__)
+#	define OW_CALLSTACK_GUARD 1
+#	include <setjmp.h>
+#else
+#	define OW_CALLSTACK_GUARD 0
+#endif
+
 struct ow_machine;
 struct ow_object;
 
 /// Information of a call stack frame.
 struct ow_callstack_frame_info {
 	bool not_ret_val;
+	bool new_segment; ///< The frame is at the beginning of a stack segment.
 	struct ow_object **arg_list;
 	struct ow_object **prev_fp;
 	const unsigned char *prev_ip;
-	struct ow_callstack_frame_info *_next;
 };
 
-/// A linked list of frame info.
+/// A stack of frame info, stored in a fixed-size array indexed by call depth.
 struct ow_callstack_frame_info_list {
-	struct ow_callstack_frame_info *current;
-	struct ow_callstack_frame_info *_free_list;
+	struct ow_callstack_frame_info *current; ///< Current frame, or NULL if no frames.
+	struct ow_callstack_frame_info *_top; ///< Next unused element.
+	struct ow_callstack_frame_info *_data;
+	struct ow_callstack_frame_info *_data_end;
 };
 
 /// Enter a new frame. All members of `list->current` must be filled after returns.
-void ow_callstack_frame_info_list_enter(struct ow_callstack_frame_info_list *list);
+/// If the max depth is reached, return false and do nothing.
+ow_static_forceinline bool ow_callstack_frame_info_list_enter(
+	struct ow_callstack_frame_info_list *list);
 /// Leave current frame.
-void ow_callstack_frame_info_list_leave(struct ow_callstack_frame_info_list *list);
+ow_static_forceinline void ow_callstack_frame_info_list_leave(
+	struct ow_callstack_frame_info_list *list);
+/// Get number of frames.
+ow_static_forceinline size_t ow_callstack_frame_info_list_depth(
+	const struct ow_callstack_frame_info_list *list);
+/// Get max number of frames.
+ow_static_forceinline size_t ow_callstack_frame_info_list_max_depth(
+	const struct ow_callstack_frame_info_list *list);
 
 /// Registers used in call stack.
 struct ow_callstack_regs {
@@ -32,20 +53,60 @@ struct ow_callstack_regs {
 	struct ow_object **fp; ///< Frame base.
 };
 
-/// The runtime call stack.
+/// A memory block of the call stack.
+struct ow_callstack_segment {
+	struct ow_callstack_segment *prev;
+	struct ow_callstack_segment *next; ///< An unused segment kept for reuse, or NULL.
+	struct ow_object **prev_top; ///< Stack top of the previous segment.
+	struct ow_object **data_end;
+	struct ow_object *data[];
+};
+
+/// The runtime call stack. It is made up of segments, which never move, so that
+/// pointers to objects on stack remain valid when the stack grows.
+/// A guarded stack is instead a single segment in a reserved virtual memory range
+/// that ends with an inaccessible guard page. It never grows. Interpreted functions
+/// rely on the guard page, writing to which is caught by a trap (see
+/// `ow_callstack_trap_enter()`); native code checks `data_end` instead, which is
+/// some headroom below the guard page.
 struct ow_callstack {
 	struct ow_callstack_regs regs;
 	struct ow_callstack_frame_info_list frame_info_list;
-	struct ow_object **data_end;
-	struct ow_object **_data;
+	struct ow_object **data_end; ///< End of current segment, or the headroom of a guarded stack.
+	struct ow_object **_data; ///< Beginning of current segment.
+	struct ow_callstack_segment *_segment; ///< Current segment.
+	size_t _segment_size;
+	void *_guard_page; ///< Guard page of a guarded stack, or NULL.
+	size_t _mapping_size; ///< Size of the reserved memory of a guarded stack.
 };
-/// Create a call stack.
 
-void ow_callstack_init(struct ow_callstack *stack, size_t n);
+/// Create a call stack whose segments hold `n` objects by default and
+/// that holds at most `max_depth` frames. If `reserve` is not 0 and the platform
+/// supports it, create a guarded stack that holds `reserve` objects instead.
+void ow_callstack_init(
+	struct ow_callstack *stack, size_t n, size_t reserve, size_t max_depth);
 /// Destroy a call stack.
 void ow_callstack_fini(struct ow_callstack *stack);
 /// Clear stack.
 void ow_callstack_clear(struct ow_callstack *stack);
+/// Check whether the stack is a guarded one.
+ow_static_forceinline bool ow_callstack_is_guarded(const struct ow_callstack *stack);
+/// Check whether there is space for `n` more objects in current segment.
+/// For a guarded stack, the headroom below the guard page is not counted.
+ow_static_forceinline bool ow_callstack_has_space(
+	const struct ow_callstack *stack, struct ow_object **sp, size_t n);
+/// Switch to a new segment that has space for at least `n` more objects, and move
+/// the top `keep` objects to it. Only `regs.sp` is updated.
+void ow_callstack_push_segment(struct ow_callstack *stack, size_t keep, size_t n);
+/// Replace current segment with a larger one that has space for at least `n` more
+/// objects, moving all the objects in it. Only `regs.sp` is updated.
+void ow_callstack_grow_segment(struct ow_callstack *stack, size_t n);
+/// Switch back to previous segment, discarding everything in current segment.
+/// Return stack top of the previous segment, excluding the objects that were
+/// moved by `ow_callstack_push_segment()`. Registers are not updated.
+struct ow_object **ow_callstack_pop_segment(struct ow_callstack *stack);
+/// Pop segments until the one that contains `sp`. Return false if not found.
+bool ow_callstack_unwind_segments(struct ow_callstack *stack, struct ow_object **sp);
 /// Push object to stack.
 #define ow_callstack_push(stack, object)  (*++(stack).regs.sp = (object))
 /// Pop top object on stack.
@@ -54,3 +115,60 @@ void ow_callstack_clear(struct ow_callstack *stack);
 #define ow_callstack_top(stack)  (*(stack).regs.sp)
 
 void _ow_callstack_gc_marker(struct ow_machine *om, struct ow_callstack *stack);
+
+#if OW_CALLSTACK_GUARD
+
+/// A catch point for overflow of a guarded stack.
+struct ow_callstack_trap {
+	sigjmp_buf env;
+	const struct ow_callstack *stack;
+	struct ow_callstack_trap *prev;
+};
+
+/// Register a trap for the current thread. Then call `sigsetjmp(trap->env, 0)`,
+/// which returns non-zero when the guard page of the stack is written to. In that
+/// case, the trap and the ones registered after it have been removed, and the
+/// stack registers and frames must be restored by the caller.
+void ow_callstack_trap_enter(
+	struct ow_callstack_trap *trap, const struct ow_callstack *stack);
+/// Remove the trap, which must be the last registered one.
+void ow_callstack_trap_leave(struct ow_callstack_trap *trap);
+
+#endif // OW_CALLSTACK_GUARD
+
+ow_static_forceinline bool ow_callstack_frame_info_list_enter(
+		struct ow_callstack_frame_info_list *list) {
+	struct ow_callstack_frame_info *const fi = list->_top;
+	if (ow_unlikely(fi == list->_data_end))
+		return false;
+	list->current = fi;
+	list->_top = fi + 1;
+	return true;
+}
+
+ow_static_forceinline void ow_callstack_frame_info_list_leave(
+		struct ow_callstack_frame_info_list *list) {
+	struct ow_callstack_frame_info *const fi = list->current;
+	assert(fi && fi + 1 == list->_top);
+	list->_top = fi;
+	list->current = ow_likely(fi != list->_data) ? fi - 1 : NULL;
+}
+
+ow_static_forceinline size_t ow_callstack_frame_info_list_depth(
+		const struct ow_callstack_frame_info_list *list) {
+	return (size_t)(list->_top - list->_data);
+}
+
+ow_static_forceinline size_t ow_callstack_frame_info_list_max_depth(
+		const struct ow_callstack_frame_info_list *list) {
+	return (size_t)(list->_data_end - list->_data);
+}
+
+ow_static_forceinline bool ow_callstack_is_guarded(const struct ow_callstack *stack) {
+	return stack->_guard_page != NULL;
+}
+
+ow_static_forceinline bool ow_callstack_has_space(
+		const struct ow_callstack *stack, struct ow_object **sp, size_t n) {
+	return (size_t)(stack->data_end - sp) > n;
+}
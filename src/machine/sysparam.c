@@ -11,6 +11,15 @@ volatile struct ow_sysparam ow_sysparam = {
 	.verbose_parser   = false,
 	.verbose_codegen  = false,
 	.stack_size       = 4000 / sizeof(void *),
+	.stack_reserve    = 0,
+	.max_call_depth   = 1000,
+	.gc_mark_budget   = 0,
+	.gc_mark_threads  = 1,
+	.gc_compact_threshold = 0,
+	.gc_cpu_goal      = 0,
+	.gc_heap_goal     = 0,
+	.heap_limit       = 0,
+	.allocator        = {NULL, NULL, NULL, NULL},
 	.default_paths    = NULL,
 };
 
@@ -19,6 +28,9 @@ void ow_sysparam_set_string(size_t off, const char *str, size_t len) {
 	assert(off < sizeof(struct ow_sysparam) - sizeof(char *));
 	assert(len != (size_t)-1);
 
+	// Not with the allocator of a machine, which may be destroyed before the string.
+	const struct ow_allocator *const allocator = ow_malloc_get_allocator();
+	ow_malloc_set_allocator(NULL);
 	char *const s = ow_malloc(len + 1);
 	memcpy(s, str, len);
 	s[len] = '\0';
@@ -29,4 +41,5 @@ void ow_sysparam_set_string(size_t off, const char *str, size_t len) {
 	*val_ptr = s;
 	if (old_s)
 		ow_free(old_s);
+	ow_malloc_set_allocator(allocator);
 }
@@ -3,6 +3,8 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include <ow.h>
+
 /// Global parameters.
 struct ow_sysparam {
 	bool verbose_memory;
@@ -10,6 +12,15 @@ struct ow_sysparam {
 	bool verbose_parser;
 	bool verbose_codegen;
 	size_t stack_size; // Number of objects.
+	size_t stack_reserve; // Number of objects in a guarded stack, or 0.
+	size_t max_call_depth; // Max number of nested calls.
+	size_t gc_mark_budget; // Number of objects to mark in a slice of incremental GC, or 0.
+	size_t gc_mark_threads; // Number of threads for marking in full GCs.
+	size_t gc_compact_threshold; // Fragmentation (percentage) to trigger compaction, or 0.
+	size_t gc_cpu_goal; // Target of time spent in GC (percentage), or 0.
+	size_t gc_heap_goal; // Soft limit of heap size (bytes), or 0.
+	size_t heap_limit; // Hard limit of heap size (bytes), or 0 for the default.
+	struct ow_allocator allocator; // Allocator for new machines; all NULL for the C library.
 	char *default_paths; // Default module paths.
 };
 
@@ -9,6 +9,7 @@
 #include <objects/floatobj.h>
 #include <objects/intobj.h>
 #include <objects/object.h>
+#include <objects/recordobj.h>
 #include <objects/stringobj.h>
 #include <objects/symbolobj.h>
 
@@ -17,6 +18,8 @@ static int func_print(struct ow_machine *om) {
 	struct ow_object *const obj = om->callstack.regs.fp[-1];
 	if (ow_smallint_check(obj)) {
 		fprintf(fp, "%ji", (intmax_t)ow_smallint_from_ptr(obj));
+	} else if (ow_flonum_check(obj)) {
+		fprintf(fp, "%f", ow_flonum_from_ptr(obj));
 	} else {
 		struct ow_class_obj *const obj_cls = ow_object_class(obj);
 		if (obj_cls == om->builtin_classes->int_) {
@@ -40,8 +43,14 @@ static int func_print(struct ow_machine *om) {
 	return 0;
 }
 
+static int func_record(struct ow_machine *om) {
+	*++om->callstack.regs.sp = ow_object_from(ow_record_obj_new(om));
+	return 1;
+}
+
 static const struct ow_native_func_def functions[] = {
 	{"print", func_print, 1},
+	{"record", func_record, 0},
 	{NULL, NULL, 0},
 };
 
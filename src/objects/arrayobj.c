@@ -26,7 +26,8 @@ static void ow_array_obj_gc_marker(struct ow_machine *om, struct ow_object *obj)
 	assert(ow_class_obj_is_base(om->builtin_classes->array, ow_object_class(obj)));
 	struct ow_array_obj *const self = ow_object_cast(obj, struct ow_array_obj);
 	for (size_t i = 0, n = ow_array_size(&self->array); i < n; i++)
-		ow_objmem_object_gc_marker(om, ow_array_at(&self->array, i));
+		ow_objmem_object_gc_slot_marker(
+			om, (struct ow_object **)&ow_array_at(&self->array, i));
 }
 
 struct ow_array_obj *ow_array_obj_new(
@@ -54,4 +55,5 @@ OW_BICLS_CLASS_DEF_EX(array) = {
 	.finalizer = ow_array_obj_finalizer,
 	.gc_marker = ow_array_obj_gc_marker,
 	.extended  = false,
+	.concurrent_finalizer = true,
 };
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "object.h"
+#include <utilities/attributes.h>
+
 struct ow_class_obj;
 struct ow_machine;
 
@@ -19,7 +22,9 @@ struct ow_machine;
 	ELEM(map)         \
 	ELEM(module)      \
 	ELEM(nil)         \
+	ELEM(record)      \
 	ELEM(set)         \
+	ELEM(shape)       \
 	ELEM(string)      \
 	ELEM(symbol)      \
 	ELEM(tuple)       \
@@ -44,3 +49,13 @@ void _ow_builtin_classes_del(
 	struct ow_machine *om, struct ow_builtin_classes * bic, _Bool finalize_classes);
 
 void _ow_builtin_classes_gc_marker(struct ow_machine *om, struct ow_builtin_classes * bic);
+
+/// Get class of any object, including immediate values.
+ow_static_forceinline struct ow_class_obj *ow_builtin_classes_class_of(
+		const struct ow_builtin_classes *bic, const struct ow_object *obj) {
+	if (ow_unlikely(ow_smallint_check(obj)))
+		return bic->int_;
+	if (ow_unlikely(ow_flonum_check(obj)))
+		return bic->float_;
+	return ow_object_class(obj);
+}
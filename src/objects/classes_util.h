@@ -11,3 +11,14 @@
 
 #define OW_BICLS_CLASS_DEF_EX(CLASS) \
 	const struct ow_native_class_def_ex OW_BICLS_CLASS_DEF_EX_NAME(CLASS)
+
+/// Define a method function `NAME` that calls operator function `OP_FUNC`
+/// (see `ow_class_op_native_t`) with `ARGC` arguments.
+#define OW_BICLS_OP_METHOD(NAME, OP_FUNC, ARGC) \
+	static int NAME(struct ow_machine *om) { \
+		struct ow_object *res; \
+		const int status = OP_FUNC(om, om->callstack.regs.fp - (ARGC), &res); \
+		*++om->callstack.regs.sp = res; \
+		return status ? -1 : 1; \
+	} \
+// ^^^ OW_BICLS_OP_METHOD() ^^^
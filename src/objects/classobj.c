@@ -23,11 +23,39 @@ struct ow_class_obj {
 	struct ow_hashmap attrs_and_methods_map; // { name, (field_index + 1) or (-1 - method_index) }
 	struct ow_hashmap statics_map; // { name, static_member_object }
 	struct ow_array methods;
+	size_t op_method_indices[OW_CLASS_OP_COUNT]; // Indices of `pub_info.op_methods`, or -1.
 	void (*finalizer2)(struct ow_machine *, void *);
 };
 
+static void ow_class_obj_clear_op_slots(struct ow_class_obj *self) {
+	for (size_t i = 0; i < OW_CLASS_OP_COUNT; i++) {
+		self->pub_info.op_methods[i] = NULL;
+		self->pub_info.op_natives[i] = NULL;
+		self->op_method_indices[i] = (size_t)-1;
+	}
+}
+
+/// Get the operator that a method name stands for. If not an operator, return -1.
+static int ow_class_obj_op_of_name(const struct ow_symbol_obj *name) {
+	static const char *const op_names[OW_CLASS_OP_COUNT] = {
+#define ELEM(NAME, STRING) [ OW_CLASS_OP_##NAME ] = STRING ,
+		OW_CLASS_OP_LIST
+#undef ELEM
+	};
+	const char *const name_str = ow_symbol_obj_data(name);
+	const size_t name_len = ow_symbol_obj_size(name);
+	if (name_len > sizeof "__hash__" - 1)
+		return -1;
+	for (int i = 0; i < OW_CLASS_OP_COUNT; i++) {
+		if (strlen(op_names[i]) == name_len && !memcmp(op_names[i], name_str, name_len))
+			return i;
+	}
+	return -1;
+}
+
 static void ow_class_obj_init(struct ow_class_obj *self) {
 	memset(&self->pub_info, 0, sizeof self->pub_info);
+	ow_class_obj_clear_op_slots(self);
 	ow_hashmap_init(&self->attrs_and_methods_map, 0);
 	ow_hashmap_init(&self->statics_map, 0);
 	ow_array_init(&self->methods, 0);
@@ -77,6 +105,7 @@ static void ow_class_obj_gc_marker(struct ow_machine *om, struct ow_object *obj)
 	ow_hashmap_foreach(&self->statics_map, _statics_map_gc_walker, om);
 	for (size_t i = 0, n = ow_array_size(&self->methods); i < n; i++)
 		ow_objmem_object_gc_marker(om, ow_array_at(&self->methods, i));
+	// Objects in `pub_info.op_methods` are all in `methods`.
 }
 
 struct ow_class_obj *ow_class_obj_new(struct ow_machine *om) {
@@ -84,6 +113,8 @@ struct ow_class_obj *ow_class_obj_new(struct ow_machine *om) {
 		ow_objmem_allocate(om, om->builtin_classes->class_, 0),
 		struct ow_class_obj);
 	ow_class_obj_init(obj);
+	// The class of classes has no finalizer yet when creating builtin classes.
+	ow_objmem_object_enable_finalizer(ow_object_from(obj));
 	return obj;
 }
 
@@ -109,6 +140,7 @@ void ow_class_obj_load_native_def(
 		self->pub_info.finalizer = NULL;
 		self->finalizer2 = NULL;
 	}
+	self->pub_info.concurrent_finalizer = false;
 	self->pub_info.gc_marker = NULL;
 
 	const size_t field_count =
@@ -135,7 +167,15 @@ void ow_class_obj_load_native_def(
 			&self->attrs_and_methods_map, &ow_symbol_obj_hashmap_funcs,
 			&super->attrs_and_methods_map);
 		ow_array_extend(&self->methods, &super->methods);
+		if (super != self) {
+			for (size_t i = 0; i < OW_CLASS_OP_COUNT; i++) {
+				self->pub_info.op_methods[i] = super->pub_info.op_methods[i];
+				self->pub_info.op_natives[i] = super->pub_info.op_natives[i];
+				self->op_method_indices[i] = super->op_method_indices[i];
+			}
+		}
 	}
+	ow_objmem_write_barrier_n(om, ow_object_from(self));
 
 	ow_objmem_push_ngc(om);
 
@@ -143,10 +183,10 @@ void ow_class_obj_load_native_def(
 		const ow_native_func_def_t method_def = def->methods[i];
 		struct ow_cfunc_obj *const func_obj = ow_cfunc_obj_new(
 			om, func_mod, method_def.name, method_def.func,
-			(struct ow_func_spec){method_def.argc, 0});
+			(struct ow_func_spec){method_def.argc, 0, 0});
 		struct ow_symbol_obj *const name_obj =
 			ow_symbol_obj_new(om, method_def.name, (size_t)-1);
-		ow_class_obj_set_method_y(self, name_obj, ow_object_from(func_obj));
+		ow_class_obj_set_method_y(om, self, name_obj, ow_object_from(func_obj));
 	}
 
 	ow_objmem_pop_ngc(om);
@@ -156,11 +196,12 @@ void ow_class_obj_load_native_def(
 		self->pub_info.native_field_count +
 		ow_hashmap_size(&self->attrs_and_methods_map) - ow_array_size(&self->methods);
 	self->pub_info.has_extra_fields = false;
+	self->pub_info.version++;
 
 	if (ow_unlikely(self->methods._cap - self->methods._len > self->methods._len / 8))
 		ow_array_shrink(&self->methods);
-	if (ow_unlikely(self->attrs_and_methods_map._size
-			> self->attrs_and_methods_map._bucket_count + 4))
+	if (ow_unlikely(self->attrs_and_methods_map._growth_left
+			> self->attrs_and_methods_map._size / 4 + 4))
 		ow_hashmap_shrink(&self->attrs_and_methods_map);
 }
 
@@ -173,7 +214,16 @@ void ow_class_obj_load_native_def_ex(
 	self->finalizer2 = NULL;
 	self->pub_info.has_extra_fields = def->extended;
 	self->pub_info.finalizer = def->finalizer;
+	self->pub_info.concurrent_finalizer = def->concurrent_finalizer;
 	self->pub_info.gc_marker = def->gc_marker;
+	if (def->op_natives) {
+		for (size_t i = 0; i < OW_CLASS_OP_COUNT; i++) {
+			if (!def->op_natives[i])
+				continue;
+			assert(self->pub_info.op_methods[i]); // The method must also be defined.
+			self->pub_info.op_natives[i] = def->op_natives[i];
+		}
+	}
 }
 
 void ow_class_obj_clear(struct ow_machine *om, struct ow_class_obj *self) {
@@ -187,7 +237,9 @@ void ow_class_obj_clear(struct ow_machine *om, struct ow_class_obj *self) {
 	ow_hashmap_clear(&self->attrs_and_methods_map);
 	ow_hashmap_clear(&self->statics_map);
 	ow_array_clear(&self->methods);
+	ow_class_obj_clear_op_slots(self);
 //	self->finalizer2 = NULL;
+	self->pub_info.version++;
 }
 
 size_t ow_class_obj_find_attribute(
@@ -208,6 +260,12 @@ size_t ow_class_obj_find_method(
 	return (size_t)(-1 - index);
 }
 
+intptr_t ow_class_obj_find_member(
+		const struct ow_class_obj *self, const struct ow_symbol_obj *name) {
+	return (intptr_t)ow_hashmap_get(
+		&self->attrs_and_methods_map, &ow_symbol_obj_hashmap_funcs, name);
+}
+
 struct ow_object *ow_class_obj_get_method(
 		const struct ow_class_obj *self, size_t index) {
 	if (ow_unlikely(index >= ow_array_size(&self->methods)))
@@ -216,15 +274,24 @@ struct ow_object *ow_class_obj_get_method(
 }
 
 bool ow_class_obj_set_method(
-		struct ow_class_obj *self, size_t index, struct ow_object *method) {
+		struct ow_machine *om, struct ow_class_obj *self,
+		size_t index, struct ow_object *method) {
 	if (ow_unlikely(index >= ow_array_size(&self->methods)))
 		return false;
 	ow_array_at(&self->methods, index) = method;
+	for (size_t i = 0; i < OW_CLASS_OP_COUNT; i++) {
+		if (self->op_method_indices[i] == index) {
+			self->pub_info.op_methods[i] = method;
+			self->pub_info.op_natives[i] = NULL;
+		}
+	}
+	ow_objmem_write_barrier(om, ow_object_from(self), method);
+	self->pub_info.version++;
 	return true;
 }
 
 size_t ow_class_obj_set_method_y(
-		struct ow_class_obj *self,
+		struct ow_machine *om, struct ow_class_obj *self,
 		const struct ow_symbol_obj *name, struct ow_object *method) {
 	size_t index = ow_class_obj_find_method(self, name);
 	if (index == (size_t)-1) {
@@ -233,9 +300,18 @@ size_t ow_class_obj_set_method_y(
 		ow_hashmap_set(
 			&self->attrs_and_methods_map, &ow_symbol_obj_hashmap_funcs,
 			name, (void *)(-1 - (intptr_t)index));
+		ow_objmem_write_barrier_n(om, ow_object_from(self));
 	} else {
 		ow_array_at(&self->methods, index) = method;
+		ow_objmem_write_barrier(om, ow_object_from(self), method);
 	}
+	const int op = ow_class_obj_op_of_name(name);
+	if (op >= 0) {
+		self->pub_info.op_methods[op] = method;
+		self->pub_info.op_natives[op] = NULL;
+		self->op_method_indices[op] = index;
+	}
+	self->pub_info.version++;
 	return index;
 }
 
@@ -245,9 +321,10 @@ struct ow_object *ow_class_obj_get_static(
 }
 
 void ow_class_obj_set_static(
-		struct ow_class_obj *self,
+		struct ow_machine *om, struct ow_class_obj *self,
 		const struct ow_symbol_obj *name, struct ow_object *val) {
 	ow_hashmap_set(&self->statics_map, &ow_symbol_obj_hashmap_funcs, name, val);
+	ow_objmem_write_barrier_n(om, ow_object_from(self));
 }
 
 static const struct ow_native_func_def class_methods[] = {
@@ -2,6 +2,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "object_util.h"
 #include <utilities/attributes.h>
@@ -16,6 +17,45 @@ struct ow_symbol_obj;
 /// Class object.
 struct ow_class_obj;
 
+/// Operators whose methods are kept in slots of classes, so that they can be
+/// found without looking up the method names. Elements are `ELEM(NAME, STRING)`,
+/// where `NAME` is the same as that of the common symbol.
+#define OW_CLASS_OP_LIST \
+	ELEM(add , "+"  ) \
+	ELEM(sub , "-"  ) \
+	ELEM(mul , "*"  ) \
+	ELEM(div , "/"  ) \
+	ELEM(rem , "%"  ) \
+	ELEM(shl , "<<" ) \
+	ELEM(shr , ">>" ) \
+	ELEM(and_, "&"  ) \
+	ELEM(or_ , "|"  ) \
+	ELEM(xor_, "^"  ) \
+	ELEM(neg , "-." ) \
+	ELEM(inv , "~"  ) \
+	ELEM(cmp , "<=>") \
+	ELEM(call, "()" ) \
+	ELEM(get_elem, "[]") \
+	ELEM(set_elem, "[]=") \
+	ELEM(hash, "__hash__") \
+// ^^^ OW_CLASS_OP_LIST ^^^
+
+/// Operator slot index.
+enum ow_class_op {
+#define ELEM(NAME, STRING) OW_CLASS_OP_##NAME ,
+	OW_CLASS_OP_LIST
+#undef ELEM
+	OW_CLASS_OP_COUNT
+};
+
+/// Native implementation of an operator, which is called without a frame.
+/// Arguments are `argv[0]` (self) to `argv[n - 1]`, where `n` is the fixed
+/// number of operands of the operator, and may be invalid after allocating
+/// objects. On success, store the result in `*res_out` and return 0; otherwise,
+/// store an exception and return -1. It must behave the same as the method.
+typedef int (*ow_class_op_native_t)(
+	struct ow_machine *om, struct ow_object *argv[], struct ow_object **res_out);
+
 /// Create an empty class.
 struct ow_class_obj *ow_class_obj_new(struct ow_machine *om);
 /// Initialize class object from a native definition. The class must be empty.
@@ -46,21 +86,34 @@ size_t ow_class_obj_find_attribute(
 /// Get method index by name. If not exists, return -1.
 size_t ow_class_obj_find_method(
 	const struct ow_class_obj *self, const struct ow_symbol_obj *name);
+/// Find attribute or method by name. Return `(attribute_index + 1)` for an
+/// attribute, `(-1 - method_index)` for a method, or 0 if not exists.
+intptr_t ow_class_obj_find_member(
+	const struct ow_class_obj *self, const struct ow_symbol_obj *name);
 /// Get method by index. If not exists, return NULL.
 struct ow_object *ow_class_obj_get_method(
 	const struct ow_class_obj *self, size_t index);
 /// Set method by index. If not exists, return false.
 bool ow_class_obj_set_method(
-	struct ow_class_obj *self, size_t index, struct ow_object *method);
+	struct ow_machine *om, struct ow_class_obj *self,
+	size_t index, struct ow_object *method);
 /// Set or add method by name. Return its index.
 size_t ow_class_obj_set_method_y(
-	struct ow_class_obj *self, const struct ow_symbol_obj *name, struct ow_object *method);
+	struct ow_machine *om, struct ow_class_obj *self,
+	const struct ow_symbol_obj *name, struct ow_object *method);
+/// Get method of an operator. If not exists, return NULL.
+ow_static_forceinline struct ow_object *ow_class_obj_op_method(
+	const struct ow_class_obj *self, enum ow_class_op op);
+/// Get native implementation of an operator. If not exists, return NULL.
+ow_static_forceinline ow_class_op_native_t ow_class_obj_op_native(
+	const struct ow_class_obj *self, enum ow_class_op op);
 /// Get static attribute by name. If not exists, return NULL.
 struct ow_object *ow_class_obj_get_static(
 	const struct ow_class_obj *self, const struct ow_symbol_obj *name);
 /// Set or add static attribute by name.
 void ow_class_obj_set_static(
-	struct ow_class_obj *self, const struct ow_symbol_obj *name, struct ow_object *val);
+	struct ow_machine *om, struct ow_class_obj *self,
+	const struct ow_symbol_obj *name, struct ow_object *val);
 /// Test if `derived_class` is derived from `self` or if both are the same.
 ow_static_inline bool ow_class_obj_is_base(
 	struct ow_class_obj *self, struct ow_class_obj *derived_class);
@@ -72,7 +125,11 @@ struct ow_class_obj_pub_info {
 	struct ow_class_obj *super_class; // optional
 	struct ow_symbol_obj *class_name; // optional
 	void (*finalizer)(struct ow_machine *, struct ow_object *); // optional
+	bool concurrent_finalizer; // Whether the finalizer can run on any thread, reading nothing but the object.
 	void (*gc_marker)(struct ow_machine *, struct ow_object *); // optional
+	size_t version; // Changed whenever attributes or methods are modified.
+	struct ow_object *op_methods[OW_CLASS_OP_COUNT]; // Methods of operators, or NULL.
+	ow_class_op_native_t op_natives[OW_CLASS_OP_COUNT]; // Native versions of `op_methods`, or NULL.
 };
 
 void _ow_class_obj_fini(struct ow_class_obj *self);
@@ -98,6 +155,16 @@ ow_static_forceinline size_t ow_class_obj_attribute_count(
 	return ow_class_obj_pub_info(self)->basic_field_count;
 }
 
+ow_static_forceinline struct ow_object *ow_class_obj_op_method(
+		const struct ow_class_obj *self, enum ow_class_op op) {
+	return ow_class_obj_pub_info(self)->op_methods[op];
+}
+
+ow_static_forceinline ow_class_op_native_t ow_class_obj_op_native(
+		const struct ow_class_obj *self, enum ow_class_op op) {
+	return ow_class_obj_pub_info(self)->op_natives[op];
+}
+
 ow_static_inline bool ow_class_obj_is_base(
 		struct ow_class_obj *self, struct ow_class_obj *derived_class) {
 	while (1) {
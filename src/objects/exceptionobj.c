@@ -95,9 +95,10 @@ struct ow_object *ow_exception_obj_data(const struct ow_exception_obj *self) {
 }
 
 void ow_exception_obj_backtrace_append(
-		struct ow_exception_obj *self,
+		struct ow_machine *om, struct ow_exception_obj *self,
 		const struct ow_exception_obj_frame_info *info) {
 	ow_xarray_append(&self->backtrace, struct ow_exception_obj_frame_info, *info);
+	ow_objmem_write_barrier(om, ow_object_from(self), info->function);
 }
 
 const struct ow_exception_obj_frame_info *ow_exception_obj_backtrace(
@@ -118,7 +119,7 @@ void ow_exception_obj_print(
 		snprintf(buffer, sizeof buffer, "Exception `%s': ", ow_symbol_obj_data(name_sym));
 		ow_iostream_puts(stream, buffer);
 
-		if (!ow_smallint_check(self->data) &&
+		if (!ow_object_is_immediate(self->data) &&
 				ow_object_class(self->data) == om->builtin_classes->string) {
 			struct ow_string_obj *const str_o =
 				ow_object_cast(self->data, struct ow_string_obj);
@@ -163,4 +164,5 @@ OW_BICLS_CLASS_DEF_EX(exception) = {
 	.finalizer = ow_exception_obj_finalizer,
 	.gc_marker = ow_exception_obj_gc_marker,
 	.extended  = false,
+	.concurrent_finalizer = true,
 };
@@ -30,7 +30,7 @@ struct ow_exception_obj *ow_exception_vformat(
 struct ow_object *ow_exception_obj_data(const struct ow_exception_obj *self);
 /// Append a frame info.
 void ow_exception_obj_backtrace_append(
-	struct ow_exception_obj *self,
+	struct ow_machine *om, struct ow_exception_obj *self,
 	const struct ow_exception_obj_frame_info *info);
 /// Get a vector of frame info.
 const struct ow_exception_obj_frame_info *ow_exception_obj_backtrace(
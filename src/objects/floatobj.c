@@ -2,12 +2,16 @@
 
 #include <assert.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "classes.h"
 #include "classes_util.h"
+#include "exceptionobj.h"
+#include "intobj.h"
 #include "memory.h"
 #include "natives.h"
 #include "object_util.h"
+#include "smallint.h"
 #include <machine/machine.h>
 
 struct ow_float_obj {
@@ -15,19 +19,143 @@ struct ow_float_obj {
 	double value;
 };
 
-struct ow_float_obj *ow_float_obj_new(struct ow_machine *om, double val) {
+struct ow_float_obj *_ow_float_obj_new(struct ow_machine *om, double val) {
 	struct ow_float_obj *const obj = ow_object_cast(
 		ow_objmem_allocate(om, om->builtin_classes->float_, 0),
 		struct ow_float_obj);
 	obj->value = val;
-	assert(ow_float_obj_value(obj) == val);
+	assert(ow_float_obj_value(obj) == val || val != val); // NaN never equals itself.
 	return obj;
 }
 
+bool ow_float_obj_number_value(
+		struct ow_machine *om, struct ow_object *obj, double *val_out) {
+	if (ow_smallint_check(obj)) {
+		*val_out = (double)ow_smallint_from_ptr(obj);
+		return true;
+	}
+	if (ow_flonum_check(obj)) {
+		*val_out = ow_flonum_from_ptr(obj);
+		return true;
+	}
+	struct ow_class_obj *const obj_class = ow_object_class(obj);
+	if (obj_class == om->builtin_classes->float_) {
+		*val_out = ow_float_obj_value(ow_object_cast(obj, struct ow_float_obj));
+		return true;
+	}
+	if (obj_class == om->builtin_classes->int_) {
+		*val_out = (double)ow_int_obj_value(ow_object_cast(obj, struct ow_int_obj));
+		return true;
+	}
+	return false;
+}
+
+/// Get value of the `self` argument, which must be a Float.
+static double float_self_value(struct ow_machine *om, int argc) {
+	struct ow_object *const self = om->callstack.regs.fp[-argc];
+	assert(ow_flonum_check(self) || ow_object_class(self) == om->builtin_classes->float_);
+	ow_unused_var(om);
+	return ow_float_obj_or_flonum_value(self);
+}
+
+/// Get value of the argument next to `self`. If it is not a number,
+/// push an exception and return false.
+static bool float_other_value(struct ow_machine *om, double *val_out) {
+	struct ow_object *const other = om->callstack.regs.fp[-1];
+	if (ow_likely(ow_float_obj_number_value(om, other, val_out)))
+		return true;
+	*++om->callstack.regs.sp = ow_object_from(
+		ow_exception_format(om, NULL, "the operand is not a number"));
+	return false;
+}
+
+/// Push a float.
+static void float_push(struct ow_machine *om, double val) {
+	struct ow_object *const obj = ow_float_obj_or_flonum(om, val);
+	*++om->callstack.regs.sp = obj;
+}
+
+#define FLOAT_BIN_OP_FUNC(NAME, OPERATOR) \
+	static int float_##NAME(struct ow_machine *om) { \
+		const double lhs = float_self_value(om, 2); \
+		double rhs; \
+		if (ow_unlikely(!float_other_value(om, &rhs))) \
+			return -1; \
+		float_push(om, lhs OPERATOR rhs); \
+		return 1; \
+	} \
+// ^^^ FLOAT_BIN_OP_FUNC() ^^^
+
+//# Float.+(other :: Int|Float) :: Float
+FLOAT_BIN_OP_FUNC(add, +)
+//# Float.-(other :: Int|Float) :: Float
+FLOAT_BIN_OP_FUNC(sub, -)
+//# Float.*(other :: Int|Float) :: Float
+FLOAT_BIN_OP_FUNC(mul, *)
+//# Float./(other :: Int|Float) :: Float
+FLOAT_BIN_OP_FUNC(div, /)
+
+#undef FLOAT_BIN_OP_FUNC
+
+//# Float.<=>(other :: Int|Float) :: Int
+//# Compare with another number. Return -1 if less, 0 if equal, or 1 otherwise.
+static int float_cmp_op(
+		struct ow_machine *om, struct ow_object *argv[], struct ow_object **res_out) {
+	const double lhs = ow_float_obj_or_flonum_value(argv[0]);
+	double rhs;
+	if (ow_unlikely(!ow_float_obj_number_value(om, argv[1], &rhs))) {
+		*res_out = ow_object_from(
+			ow_exception_format(om, NULL, "the operand is not a number"));
+		return -1;
+	}
+	const int res = lhs < rhs ? -1 : lhs == rhs ? 0 : 1;
+	*res_out = ow_smallint_to_ptr(res);
+	return 0;
+}
+
+OW_BICLS_OP_METHOD(float_cmp, float_cmp_op, 2)
+
+//# Float.-.() :: Float
+static int float_neg(struct ow_machine *om) {
+	float_push(om, -float_self_value(om, 1));
+	return 1;
+}
+
+//# Float.to_int() :: Int
+//# Convert to integer by truncating the fractional part.
+static int float_to_int(struct ow_machine *om) {
+	const double val = float_self_value(om, 1);
+	if (ow_unlikely(!(val >= -0x1p63 && val < 0x1p63))) {
+		*++om->callstack.regs.sp = ow_object_from(ow_exception_format(
+			om, NULL, "cannot convert %f to Int", val));
+		return -1;
+	}
+	*++om->callstack.regs.sp = ow_int_obj_or_smallint(om, (int64_t)val);
+	return 1;
+}
+
+//# Float.to_float() :: Float
+static int float_to_float(struct ow_machine *om) {
+	*++om->callstack.regs.sp = om->callstack.regs.fp[-1];
+	return 1;
+}
+
 static const struct ow_native_func_def float_methods[] = {
+	{"+"       , float_add     , 2},
+	{"-"       , float_sub     , 2},
+	{"*"       , float_mul     , 2},
+	{"/"       , float_div     , 2},
+	{"<=>"     , float_cmp     , 2},
+	{"-."      , float_neg     , 1},
+	{"to_int"  , float_to_int  , 1},
+	{"to_float", float_to_float, 1},
 	{NULL, NULL, 0},
 };
 
+static const ow_class_op_native_t float_op_natives[OW_CLASS_OP_COUNT] = {
+	[OW_CLASS_OP_cmp] = float_cmp_op,
+};
+
 OW_BICLS_CLASS_DEF_EX(float_) = {
 	.name      = "Float",
 	.data_size = OW_OBJ_STRUCT_DATA_SIZE(struct ow_float_obj),
@@ -35,4 +163,5 @@ OW_BICLS_CLASS_DEF_EX(float_) = {
 	.finalizer = NULL,
 	.gc_marker = NULL,
 	.extended  = false,
+	.op_natives = float_op_natives,
 };
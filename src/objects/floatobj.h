@@ -1,18 +1,44 @@
 #pragma once
 
+#include <stdbool.h>
+
+#include "flonum.h"
+#include "object.h"
 #include "object_util.h"
 #include <utilities/attributes.h>
 
 struct ow_machine;
+struct ow_object;
 
 /// Floating-point object.
 struct ow_float_obj;
 
+/// Make a flonum or create a float object.
+ow_static_forceinline struct ow_object *ow_float_obj_or_flonum(struct ow_machine *om, double val);
 /// Create a float object.
-struct ow_float_obj *ow_float_obj_new(struct ow_machine *om, double val);
+struct ow_float_obj *_ow_float_obj_new(struct ow_machine *om, double val);
 /// Get float value.
 ow_static_forceinline double ow_float_obj_value(const struct ow_float_obj *self);
+/// Get value of a float object or a flonum.
+ow_static_forceinline double ow_float_obj_or_flonum_value(const struct ow_object *obj);
+/// Get value of an Int or Float object (or a flonum) as a double. Return false if it is neither.
+bool ow_float_obj_number_value(
+	struct ow_machine *om, struct ow_object *obj, double *val_out);
+
+ow_static_forceinline struct ow_object *ow_float_obj_or_flonum(
+		struct ow_machine *om, double val) {
+	struct ow_object *const ptr = ow_flonum_try_to_ptr(val);
+	if (ow_likely(ptr))
+		return ptr;
+	return ow_object_from(_ow_float_obj_new(om, val));
+}
 
 ow_static_forceinline double ow_float_obj_value(const struct ow_float_obj *self) {
 	return *(const double *)((const unsigned char *)self + OW_OBJECT_SIZE);
 }
+
+ow_static_forceinline double ow_float_obj_or_flonum_value(const struct ow_object *obj) {
+	if (ow_likely(ow_flonum_check(obj)))
+		return ow_flonum_from_ptr(obj);
+	return ow_float_obj_value(ow_object_cast(obj, const struct ow_float_obj));
+}
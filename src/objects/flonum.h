@@ -0,0 +1,79 @@
+#pragma once
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <config/options.h>
+#include <utilities/attributes.h>
+
+struct ow_object;
+
+/// Flonum is a floating-point number that is hold in a pointer. Only available
+/// on 64-bit platforms. A double whose exponent is in a limited range (roughly
+/// 1e-77 to 1e+77 in magnitude) or is positive zero is stored as a flonum;
+/// other values need float objects. The low two bits of a flonum pointer are
+/// `0b10`, which distinguishes it from small ints and aligned object pointers.
+#if OW_BUILD_FLONUM && UINTPTR_MAX == UINT64_MAX
+#	define OW_FLONUM_ENABLED 1
+#else
+#	define OW_FLONUM_ENABLED 0
+#endif
+
+#if OW_FLONUM_ENABLED
+
+/// Flonum pointer for `+0.0`, which cannot be encoded as others.
+#define _OW_FLONUM_ZERO ((uintptr_t)0x8000000000000002)
+
+/// Check whether an object pointer is a flonum.
+ow_static_forceinline bool ow_flonum_check(const struct ow_object *obj_ptr) {
+	return ((uintptr_t)obj_ptr & 3) == 2;
+}
+
+/// Try to convert double to object pointer. If not representable, return NULL.
+ow_static_forceinline struct ow_object *ow_flonum_try_to_ptr(double val) {
+	uint64_t bits;
+	memcpy(&bits, &val, sizeof bits);
+	const unsigned int exp_top = (unsigned int)(bits >> 60) & 7;
+	if (ow_likely((exp_top == 3 || exp_top == 4) && bits != 0x3000000000000000)) {
+		bits = (bits << 3) | (bits >> 61); // rotate left by 3.
+		return (struct ow_object *)(uintptr_t)((bits & ~(uint64_t)1) | 2);
+	}
+	if (bits == 0)
+		return (struct ow_object *)_OW_FLONUM_ZERO;
+	return NULL;
+}
+
+/// Convert object pointer to double.
+ow_static_forceinline double ow_flonum_from_ptr(const struct ow_object *ptr) {
+	assert(ow_flonum_check(ptr));
+	const uint64_t p = (uintptr_t)ptr;
+	if (ow_unlikely(p == _OW_FLONUM_ZERO))
+		return 0.0;
+	uint64_t bits = (2 - (p >> 63)) | (p & ~(uint64_t)3);
+	bits = (bits >> 3) | (bits << 61); // rotate right by 3.
+	double val;
+	memcpy(&val, &bits, sizeof val);
+	return val;
+}
+
+#else // !OW_FLONUM_ENABLED
+
+ow_static_forceinline bool ow_flonum_check(const struct ow_object *obj_ptr) {
+	ow_unused_var(obj_ptr);
+	return false;
+}
+
+ow_static_forceinline struct ow_object *ow_flonum_try_to_ptr(double val) {
+	ow_unused_var(val);
+	return NULL;
+}
+
+ow_static_forceinline double ow_flonum_from_ptr(const struct ow_object *ptr) {
+	ow_unused_var(ptr);
+	assert(0);
+	return 0.0;
+}
+
+#endif // OW_FLONUM_ENABLED
@@ -36,6 +36,8 @@ static void ow_func_obj_finalizer(struct ow_machine *om, struct ow_object *obj)
 		ow_free((void *)self->constants);
 	if (ow_likely(self->symbols != empty_ow_func_obj_symbols))
 		ow_free((void *)self->symbols);
+	if (self->inline_caches)
+		ow_inline_cache_array_del(self->inline_caches);
 }
 
 static void ow_func_obj_gc_marker(struct ow_machine *om, struct ow_object *obj) {
@@ -48,6 +50,8 @@ static void ow_func_obj_gc_marker(struct ow_machine *om, struct ow_object *obj)
 		ow_objmem_object_gc_marker(om, self->constants->data[i]);
 	for (size_t i = 0, n = self->symbols->size; i < n; i++)
 		ow_objmem_object_gc_marker(om, ow_object_from(self->symbols->data[i]));
+	if (self->inline_caches)
+		ow_inline_cache_array_gc_marker(om, self->inline_caches, self->symbols->size);
 }
 
 struct ow_func_obj *ow_func_obj_new(
@@ -79,6 +83,7 @@ struct ow_func_obj *ow_func_obj_new(
 	} else {
 		obj->symbols = empty_ow_func_obj_symbols;
 	}
+	obj->inline_caches = NULL;
 	obj->code_size = code_size;
 	memcpy(obj->code, code, code_size);
 	return obj;
@@ -96,6 +101,15 @@ struct ow_symbol_obj *ow_func_obj_get_symbol(struct ow_func_obj *self, size_t in
 	return self->symbols->data[index];
 }
 
+size_t ow_func_obj_symbol_count(const struct ow_func_obj *self) {
+	return self->symbols->size;
+}
+
+void _ow_func_obj_make_inline_caches(struct ow_func_obj *self) {
+	assert(!self->inline_caches);
+	self->inline_caches = ow_inline_cache_array_new(self->symbols->size);
+}
+
 const unsigned char *ow_func_obj_code(
 		const struct ow_func_obj *self, size_t *size_out) {
 	if (size_out)
@@ -114,4 +128,5 @@ OW_BICLS_CLASS_DEF_EX(func) = {
 	.finalizer = ow_func_obj_finalizer,
 	.gc_marker = ow_func_obj_gc_marker,
 	.extended  = true,
+	.concurrent_finalizer = true,
 };
@@ -4,6 +4,7 @@
 
 #include "funcspec.h"
 #include "object.h"
+#include <machine/inlinecache.h>
 #include <utilities/attributes.h>
 
 struct ow_machine;
@@ -21,6 +22,7 @@ struct ow_func_obj {
 	struct ow_module_obj *module;
 	const struct ow_func_obj_constants *constants;
 	const struct ow_func_obj_symbols *symbols;
+	struct ow_inline_cache *inline_caches; // One for each symbol. Created on demand.
 	size_t code_size;
 	unsigned char code[];
 };
@@ -36,3 +38,17 @@ struct ow_func_obj *ow_func_obj_new(
 struct ow_object *ow_func_obj_get_constant(struct ow_func_obj *self, size_t index);
 /// Get symbols by index. If the index is out of range, return NULL.
 struct ow_symbol_obj *ow_func_obj_get_symbol(struct ow_func_obj *self, size_t index);
+/// Get number of symbols.
+size_t ow_func_obj_symbol_count(const struct ow_func_obj *self);
+/// Get the inline cache for the symbol at the index, which must be valid.
+ow_static_forceinline struct ow_inline_cache *ow_func_obj_inline_cache(
+	struct ow_func_obj *self, size_t index);
+
+void _ow_func_obj_make_inline_caches(struct ow_func_obj *self);
+
+ow_static_forceinline struct ow_inline_cache *ow_func_obj_inline_cache(
+		struct ow_func_obj *self, size_t index) {
+	if (ow_unlikely(!self->inline_caches))
+		_ow_func_obj_make_inline_caches(self);
+	return self->inline_caches + index;
+}
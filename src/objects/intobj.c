@@ -5,6 +5,8 @@
 
 #include "classes.h"
 #include "classes_util.h"
+#include "exceptionobj.h"
+#include "floatobj.h"
 #include "memory.h"
 #include "natives.h"
 #include "object_util.h"
@@ -24,10 +26,159 @@ struct ow_int_obj *_ow_int_obj_new(struct ow_machine *om, int64_t val) {
 	return obj;
 }
 
+/// Get value of an Int object or a small int.
+static int64_t int_value(struct ow_object *obj) {
+	if (ow_smallint_check(obj))
+		return ow_smallint_from_ptr(obj);
+	return ow_int_obj_value(ow_object_cast(obj, struct ow_int_obj));
+}
+
+/// Check whether an object is an Int object or a small int.
+static bool int_check(struct ow_machine *om, struct ow_object *obj) {
+	if (ow_smallint_check(obj))
+		return true;
+	return !ow_flonum_check(obj) && ow_object_class(obj) == om->builtin_classes->int_;
+}
+
+/// Push an exception and return -1.
+static int int_error(struct ow_machine *om, const char *msg) {
+	*++om->callstack.regs.sp =
+		ow_object_from(ow_exception_format(om, NULL, "%s", msg));
+	return -1;
+}
+
+/// Push an integer.
+static void int_push(struct ow_machine *om, int64_t val) {
+	struct ow_object *const obj = ow_int_obj_or_smallint(om, val);
+	*++om->callstack.regs.sp = obj;
+}
+
+/// Push a float.
+static void int_push_float(struct ow_machine *om, double val) {
+	struct ow_object *const obj = ow_float_obj_or_flonum(om, val);
+	*++om->callstack.regs.sp = obj;
+}
+
+// Integer operations wrap around on overflow.
+#define INT_BIN_OP_FUNC(NAME, OPERATOR) \
+	static int int_##NAME(struct ow_machine *om) { \
+		struct ow_object *const self = om->callstack.regs.fp[-2]; \
+		struct ow_object *const other = om->callstack.regs.fp[-1]; \
+		if (ow_likely(int_check(om, other))) { \
+			int_push(om, (int64_t) \
+				((uint64_t)int_value(self) OPERATOR (uint64_t)int_value(other))); \
+			return 1; \
+		} \
+		double other_val; \
+		if (ow_unlikely(!ow_float_obj_number_value(om, other, &other_val))) \
+			return int_error(om, "the operand is not a number"); \
+		int_push_float(om, (double)int_value(self) OPERATOR other_val); \
+		return 1; \
+	} \
+// ^^^ INT_BIN_OP_FUNC() ^^^
+
+//# Int.+(other :: Int|Float) :: Int|Float
+INT_BIN_OP_FUNC(add, +)
+//# Int.-(other :: Int|Float) :: Int|Float
+INT_BIN_OP_FUNC(sub, -)
+//# Int.*(other :: Int|Float) :: Int|Float
+INT_BIN_OP_FUNC(mul, *)
+
+#undef INT_BIN_OP_FUNC
+
+//# Int./(other :: Int|Float) :: Int|Float
+//# Integer division truncates towards zero.
+static int int_div(struct ow_machine *om) {
+	struct ow_object *const self = om->callstack.regs.fp[-2];
+	struct ow_object *const other = om->callstack.regs.fp[-1];
+	if (ow_likely(int_check(om, other))) {
+		const int64_t lhs = int_value(self), rhs = int_value(other);
+		if (ow_unlikely(rhs == 0))
+			return int_error(om, "division by zero");
+		int_push(om, ow_unlikely(rhs == -1) ? (int64_t)(0 - (uint64_t)lhs) : lhs / rhs);
+		return 1;
+	}
+	double other_val;
+	if (ow_unlikely(!ow_float_obj_number_value(om, other, &other_val)))
+		return int_error(om, "the operand is not a number");
+	int_push_float(om, (double)int_value(self) / other_val);
+	return 1;
+}
+
+//# Int.%(other :: Int) :: Int
+static int int_rem(struct ow_machine *om) {
+	struct ow_object *const self = om->callstack.regs.fp[-2];
+	struct ow_object *const other = om->callstack.regs.fp[-1];
+	if (ow_unlikely(!int_check(om, other)))
+		return int_error(om, "the operand is not an integer");
+	const int64_t lhs = int_value(self), rhs = int_value(other);
+	if (ow_unlikely(rhs == 0))
+		return int_error(om, "division by zero");
+	int_push(om, ow_unlikely(rhs == -1) ? 0 : lhs % rhs);
+	return 1;
+}
+
+//# Int.<=>(other :: Int|Float) :: Int
+//# Compare with another number. Return -1 if less, 0 if equal, or 1 otherwise.
+static int int_cmp_op(
+		struct ow_machine *om, struct ow_object *argv[], struct ow_object **res_out) {
+	struct ow_object *const self = argv[0];
+	struct ow_object *const other = argv[1];
+	int res;
+	if (ow_likely(int_check(om, other))) {
+		const int64_t lhs = int_value(self), rhs = int_value(other);
+		res = lhs < rhs ? -1 : lhs == rhs ? 0 : 1;
+	} else {
+		double other_val;
+		if (ow_unlikely(!ow_float_obj_number_value(om, other, &other_val))) {
+			*res_out = ow_object_from(
+				ow_exception_format(om, NULL, "the operand is not a number"));
+			return -1;
+		}
+		const double lhs = (double)int_value(self);
+		res = lhs < other_val ? -1 : lhs == other_val ? 0 : 1;
+	}
+	*res_out = ow_smallint_to_ptr(res);
+	return 0;
+}
+
+OW_BICLS_OP_METHOD(int_cmp, int_cmp_op, 2)
+
+//# Int.-.() :: Int
+static int int_neg(struct ow_machine *om) {
+	int_push(om, (int64_t)(0 - (uint64_t)int_value(om->callstack.regs.fp[-1])));
+	return 1;
+}
+
+//# Int.to_int() :: Int
+static int int_to_int(struct ow_machine *om) {
+	*++om->callstack.regs.sp = om->callstack.regs.fp[-1];
+	return 1;
+}
+
+//# Int.to_float() :: Float
+static int int_to_float(struct ow_machine *om) {
+	int_push_float(om, (double)int_value(om->callstack.regs.fp[-1]));
+	return 1;
+}
+
 static const struct ow_native_func_def int_methods[] = {
+	{"+"       , int_add     , 2},
+	{"-"       , int_sub     , 2},
+	{"*"       , int_mul     , 2},
+	{"/"       , int_div     , 2},
+	{"%"       , int_rem     , 2},
+	{"<=>"     , int_cmp     , 2},
+	{"-."      , int_neg     , 1},
+	{"to_int"  , int_to_int  , 1},
+	{"to_float", int_to_float, 1},
 	{NULL, NULL, 0},
 };
 
+static const ow_class_op_native_t int_op_natives[OW_CLASS_OP_COUNT] = {
+	[OW_CLASS_OP_cmp] = int_cmp_op,
+};
+
 OW_BICLS_CLASS_DEF_EX(int_) = {
 	.name      = "Int",
 	.data_size = OW_OBJ_STRUCT_DATA_SIZE(struct ow_int_obj),
@@ -35,4 +186,5 @@ OW_BICLS_CLASS_DEF_EX(int_) = {
 	.finalizer = NULL,
 	.gc_marker = NULL,
 	.extended  = false,
+	.op_natives = int_op_natives,
 };
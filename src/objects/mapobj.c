@@ -9,17 +9,18 @@
 #include "object_util.h"
 #include <machine/machine.h>
 #include <utilities/hashmap.h>
+#include <utilities/ordmap.h>
 
 struct ow_map_obj {
 	OW_OBJECT_HEAD
-	struct ow_hashmap map;
+	struct ow_ordmap map;
 };
 
 static void ow_map_obj_finalizer(struct ow_machine *om, struct ow_object *obj) {
 	ow_unused_var(om);
 	assert(ow_class_obj_is_base(om->builtin_classes->map, ow_object_class(obj)));
 	struct ow_map_obj *const self = ow_object_cast(obj, struct ow_map_obj);
-	ow_hashmap_fini(&self->map);
+	ow_ordmap_fini(&self->map);
 }
 
 static int _ow_map_obj_gc_marker_walker(void *arg, const void *key, void *val) {
@@ -33,39 +34,41 @@ static void ow_map_obj_gc_marker(struct ow_machine *om, struct ow_object *obj) {
 	ow_unused_var(om);
 	assert(ow_class_obj_is_base(om->builtin_classes->map, ow_object_class(obj)));
 	struct ow_map_obj *const self = ow_object_cast(obj, struct ow_map_obj);
-	ow_hashmap_foreach(&self->map, _ow_map_obj_gc_marker_walker, om);
+	ow_ordmap_foreach(&self->map, _ow_map_obj_gc_marker_walker, om);
 }
 
 struct ow_map_obj *ow_map_obj_new(struct ow_machine *om) {
 	struct ow_map_obj *const obj = ow_object_cast(
 		ow_objmem_allocate(om, om->builtin_classes->map, 0),
 		struct ow_map_obj);
-	ow_hashmap_init(&obj->map, 0);
+	ow_ordmap_init(&obj->map, 0);
 	return obj;
 }
 
 size_t ow_map_obj_length(const struct ow_map_obj *self) {
-	return ow_hashmap_size(&self->map);
+	return ow_ordmap_size(&self->map);
 }
 
 void ow_map_obj_set(
 		struct ow_machine *om, struct ow_map_obj *self,
 		struct ow_object *key, struct ow_object *val) {
 	struct ow_hashmap_funcs mf = OW_OBJECT_HASHMAP_FUNCS_INIT(om);
-	ow_hashmap_set(&self->map, &mf, key, val);
+	ow_ordmap_set(&self->map, &mf, key, val);
+	ow_objmem_write_barrier(om, ow_object_from(self), key);
+	ow_objmem_write_barrier(om, ow_object_from(self), val);
 }
 
 struct ow_object *ow_map_obj_get(
 		struct ow_machine *om, struct ow_map_obj *self, struct ow_object *key) {
 	struct ow_hashmap_funcs mf = OW_OBJECT_HASHMAP_FUNCS_INIT(om);
-	return ow_hashmap_get(&self->map, &mf, key);
+	return ow_ordmap_get(&self->map, &mf, key);
 }
 
 int ow_map_obj_foreach(
 		const struct ow_map_obj *self,
 		int (*walker)(void *arg, struct ow_object *key, struct ow_object *val),
 		void *arg) {
-	return ow_hashmap_foreach(&self->map, (ow_hashmap_walker_t)walker, arg);
+	return ow_ordmap_foreach(&self->map, (ow_hashmap_walker_t)walker, arg);
 }
 
 static const struct ow_native_func_def map_methods[] = {
@@ -79,4 +82,5 @@ OW_BICLS_CLASS_DEF_EX(map) = {
 	.finalizer = ow_map_obj_finalizer,
 	.gc_marker = ow_map_obj_gc_marker,
 	.extended  = false,
+	.concurrent_finalizer = true,
 };
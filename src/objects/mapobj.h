@@ -5,7 +5,7 @@
 struct ow_machine;
 struct ow_object;
 
-/// Map object.
+/// Map object. Elements are kept in insertion order.
 struct ow_map_obj;
 
 /// Create an empty map object.
@@ -19,7 +19,7 @@ void ow_map_obj_set(
 /// Get value by key. Return `NULL` if the key does not exist.
 struct ow_object *ow_map_obj_get(
 	struct ow_machine *om, struct ow_map_obj *self, struct ow_object *key);
-/// Visit each key-value pair.
+/// Visit each key-value pair in insertion order.
 int ow_map_obj_foreach(
 	const struct ow_map_obj *self,
 	int (*walker)(void *arg, struct ow_object *key, struct ow_object *val), void *arg);
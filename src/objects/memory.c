@@ -3,52 +3,39 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
+#include "classes.h"
 #include "classobj.h"
 #include "natives.h"
+#include "objalloc.h"
 #include "object.h"
 #include "object_util.h"
 #include "smallint.h"
+#include "symbolobj.h"
 #include <machine/machine.h>
+#include <machine/sysparam.h>
+#include <utilities/array.h>
 #include <utilities/malloc.h>
+#include <utilities/thread.h>
 
 #include <config/options.h>
 
 #if OW_DEBUG_MEMORY
 #	include <stdio.h>
-#	include <time.h>
 #endif // OW_DEBUG_MEMORY
 
 #define DEFAULT_GC_THRESHOLD (sizeof(void *) * 1024 * 1024 / 4)
+#define DEFAULT_NURSERY_SIZE (sizeof(void *) * 1024 * 1024 / 8)
+#define GC_SLICE_INTERVAL    (sizeof(void *) * 1024 * 2) // Allocation between marking slices.
 #define DEFAULT_ALLOCATE_MAX (sizeof(void *) * 8 * 1024 * 1024)
-
-struct object_linked_list {
-	OW_OBJECT_HEAD
-};
-
-ow_forceinline static void object_linked_list_init(struct object_linked_list *list) {
-	ow_object_meta_set_next(&list->_meta, NULL);
-}
-
-ow_forceinline static bool object_linked_list_empty(struct object_linked_list *list) {
-	return ow_object_meta_get_next(&list->_meta);
-}
-
-ow_forceinline static struct ow_object *object_linked_list_first(
-		struct object_linked_list *list) {
-	return ow_object_meta_get_next(&list->_meta);
-}
-
-ow_forceinline static struct ow_object *object_linked_list_pre_first(
-		struct object_linked_list *list) {
-	return (struct ow_object *)list;
-}
-
-ow_forceinline static void object_linked_list_add(
-		struct object_linked_list *list, struct ow_object *obj) {
-	ow_object_meta_set_next(&obj->_meta, ow_object_meta_get_next(&list->_meta));
-	ow_object_meta_set_next(&list->_meta, obj);
-}
+#define MIN_NURSERY_SIZE     (sizeof(void *) * 1024 * 16)
+#define MAX_NURSERY_SIZE     (DEFAULT_NURSERY_SIZE * 16)
+#define MARK_STACK_SEGMENT_SIZE  4096 // Number of slots in a mark stack segment.
+#define MARK_STACK_SEGMENT_MAX   1024 // Max number of mark stack segments.
+#define MARK_PACKET_SIZE         256 // Max number of objects in a mark packet.
+#define MARK_SHARE_INTERVAL      64 // Number of objects to mark between checks for idle workers.
 
 struct gc_root_list_node {
 	struct gc_root_list_node *next;
@@ -111,15 +98,207 @@ static void gc_root_list_mark(struct gc_root_list *list, struct ow_machine *om)
 	}
 }
 
+/// A segment of the mark stack.
+struct mark_stack_segment {
+	struct mark_stack_segment *prev;
+	struct ow_object *slots[MARK_STACK_SEGMENT_SIZE];
+};
+
+/// Stack of marked objects whose children are to be marked. It grows by segments,
+/// so that no copying is needed. If no more segment can be allocated, the object
+/// to push is dropped (it has been marked) and `overflowed` is set; children of
+/// such objects are found later by scanning all the marked objects in the heap.
+struct mark_stack {
+	struct _ow_objmem_marker marker; // See `_ow_objmem_marker()`.
+	struct mark_stack_segment *segment; // Current segment, or NULL.
+	struct mark_stack_segment *spare; // A free segment, to avoid thrashing at boundaries.
+	size_t segment_count; // Number of segments, not including the spare one.
+	bool overflowed;
+};
+
+static void mark_stack_init(struct mark_stack *stack) {
+	stack->marker.top = NULL;
+	stack->marker.limit = NULL;
+	stack->marker.parallel = false;
+	stack->marker.compacting = false;
+	stack->segment = NULL;
+	stack->spare = NULL;
+	stack->segment_count = 0;
+	stack->overflowed = false;
+}
+
+static void mark_stack_fini(struct mark_stack *stack) {
+	for (struct mark_stack_segment *seg = stack->segment; seg; ) {
+		struct mark_stack_segment *const prev = seg->prev;
+		ow_free(seg);
+		seg = prev;
+	}
+	if (stack->spare)
+		ow_free(stack->spare);
+}
+
+/// Push an object when the current segment is full.
+static void mark_stack_push_slow(struct mark_stack *stack, struct ow_object *obj) {
+	assert(stack->marker.top == stack->marker.limit);
+	struct mark_stack_segment *seg;
+	if (stack->spare) {
+		seg = stack->spare;
+		stack->spare = NULL;
+	} else if (ow_likely(stack->segment_count < MARK_STACK_SEGMENT_MAX)) {
+		seg = ow_malloc(sizeof(struct mark_stack_segment));
+		if (ow_unlikely(!seg)) {
+			stack->overflowed = true;
+			return;
+		}
+	} else {
+		stack->overflowed = true;
+		return;
+	}
+	seg->prev = stack->segment;
+	stack->segment = seg;
+	stack->segment_count++;
+	seg->slots[0] = obj;
+	stack->marker.top = seg->slots + 1;
+	stack->marker.limit = seg->slots + MARK_STACK_SEGMENT_SIZE;
+}
+
+/// Push a marked object.
+ow_forceinline static void mark_stack_push(struct mark_stack *stack, struct ow_object *obj) {
+	if (ow_likely(stack->marker.top != stack->marker.limit))
+		*stack->marker.top++ = obj;
+	else
+		mark_stack_push_slow(stack, obj);
+}
+
+/// Pop an object. Return NULL if the stack is empty.
+ow_forceinline static struct ow_object *mark_stack_pop(struct mark_stack *stack) {
+	struct mark_stack_segment *const seg = stack->segment;
+	if (ow_likely(seg && stack->marker.top != seg->slots))
+		return *--stack->marker.top;
+	if (!seg || !seg->prev)
+		return NULL;
+	// Move to previous segment, keeping current one as the spare.
+	stack->segment = seg->prev;
+	stack->segment_count--;
+	if (stack->spare)
+		ow_free(stack->spare);
+	stack->spare = seg;
+	stack->marker.top = stack->segment->slots + MARK_STACK_SEGMENT_SIZE - 1;
+	stack->marker.limit = stack->segment->slots + MARK_STACK_SEGMENT_SIZE;
+	return *stack->marker.top;
+}
+
+/// Statistics for deciding when to do next GC. Times are in seconds.
+struct gc_pacer {
+	double pause_start; // When current pause started.
+	double resume_time; // When the mutator resumed last time.
+	double pause_time; // Pause time of current GC so far, including marking slices.
+	double mutator_time; // Mutator time since last GC.
+	double full_mutator_time; // Mutator time since last full GC.
+	double alloc_rate; // Bytes allocated per second.
+	double promote_rate; // Growth of old objects in bytes per second.
+	double minor_pause; // Pause time of a minor GC.
+	double full_pause; // Pause time of a full GC.
+	size_t full_alive_size; // Size of alive objects after last full GC.
+};
+
+static double gc_clock(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void gc_pacer_init(struct gc_pacer *pacer) {
+	memset(pacer, 0, sizeof *pacer);
+	pacer->resume_time = gc_clock();
+}
+
+/// Add a measured value to a moving average.
+static void gc_pacer_sample(double *average, double value) {
+	*average = *average > 0 ? (*average + value) / 2 : value;
+}
+
+static void gc_pacer_pause_begin(struct gc_pacer *pacer) {
+	const double now = gc_clock();
+	pacer->pause_start = now;
+	pacer->mutator_time += now - pacer->resume_time;
+}
+
+static void gc_pacer_pause_end(struct gc_pacer *pacer) {
+	const double now = gc_clock();
+	pacer->pause_time += now - pacer->pause_start;
+	pacer->pause_start = now;
+	pacer->resume_time = now;
+}
+
+/// Objects are either young (allocated since last GC) or old (survived a GC).
+/// Marks are kept after a GC, so old objects are the marked ones. A minor GC
+/// marks from the roots and the remembered set, and stops at old objects; a full
+/// GC clears the marks first. Old objects that may refer to young ones are put
+/// into the remembered set by the write barrier.
+///
+/// After marking, unmarked objects are finalized and reclaimed by a sweeper thread
+/// if there are other processors, while the allocating thread sweeps blocks itself
+/// when it cannot wait. The sweeper is stopped when next GC starts; blocks that are
+/// still unswept stay unswept through a minor GC, but a full GC finishes sweeping
+/// before clearing the marks.
+/// Finalizers that are not concurrent ones (see `ow_class_obj_pub_info`) are
+/// deferred to the first GC that finds sweeping finished, or to the end of a
+/// `OW_OBJMEM_GC_FULL` GC, so that dead classes outlive their dead instances.
+///
+/// A full GC compacts blocks if their fragmentation measured by last full GC exceeds
+/// `compact_threshold`. Objects that are referenced by the roots or through
+/// `ow_objmem_object_gc_marker()` are pinned while marking. After marking, other
+/// objects in sparse blocks are moved into denser ones, leaving forwarding addresses,
+/// and references to them are updated by marking all the objects again, where
+/// `ow_objmem_object_gc_slot_marker()` updates the slots. A compacting GC is neither
+/// incremental nor parallel.
+///
+/// A full GC can also be incremental. Marking then proceeds in slices of
+/// `mark_budget` objects while allocating, and the write barrier marks unmarked
+/// objects stored into marked ones (Dijkstra-style). Finally, the roots and the
+/// remembered set are scanned again in a short stop-the-world phase, which marks
+/// the rest of the reachable objects, including new ones that are only referenced
+/// by the roots. No minor GC or lazy sweeping happens in the meantime.
+///
+/// The pacer measures allocation rate, growth of old objects and pause times, and
+/// sizes the nursery and the full GC threshold so that GC takes about `cpu_goal`
+/// percent of the time, which is split evenly between minor and full GCs. Without
+/// such a goal, the threshold is twice the alive size. Either is reduced to meet
+/// `heap_goal`. When the heap still exceeds `allocate_max` after a full GC,
+/// allocation goes on in a reserve, and the interpreter raises an out-of-memory
+/// exception at next safe point (see `struct ow_machine`).
 struct ow_objmem_context {
 	size_t no_gc_count;
-	size_t gc_threshold;
-	size_t allocate_max;
+	struct mark_stack mark_stack;
+	size_t gc_threshold; // Size of old objects to trigger a full GC.
+	size_t nursery_size; // Size of young objects to trigger a GC.
+	size_t gc_trigger; // Size of young objects to trigger a GC or a marking slice.
+	size_t mark_budget; // Number of objects to mark in a slice; 0 to disable incremental GC.
+	size_t mark_threads; // Number of threads for marking in full GCs.
+	size_t compact_threshold; // Fragmentation (percentage) to trigger compaction; 0 to disable.
+	bool compact_pending; // Next full GC compacts.
+	bool updating_refs; // Compaction is updating references.
+	size_t cpu_goal; // Target of time spent in GC (percentage); 0 to disable.
+	size_t heap_goal; // Soft limit of heap size; 0 to disable.
+	size_t allocate_max; // Hard limit of heap size.
 	size_t allocated_size;
-	struct object_linked_list allocated_objects;
+	size_t young_size;
+	bool marking; // Incremental marking in progress.
+	bool sweep_in_background; // Not worth it without another processor.
+	bool sweeper_running;
+	atomic_bool sweeper_stop;
+	ow_thrd_t sweeper;
 	struct gc_root_list gc_root_list;
+	struct ow_array remembered_set;
+	struct ow_array finalize_queue; // Dead objects whose finalizers are deferred.
+	ow_mtx_t finalize_queue_lock;
+	struct ow_objalloc objects;
+	struct gc_pacer pacer;
 #if OW_DEBUG_MEMORY
 	bool verbose;
+	size_t slice_count;
+	size_t moved_count;
 #endif // OW_DEBUG_MEMORY
 };
 
@@ -127,27 +306,57 @@ static_assert(
 	offsetof(struct ow_machine, objmem_context) == 0 &&
 	offsetof(struct ow_objmem_context, no_gc_count) == 0,
 	"_ow_objmem_ngc_count()");
+static_assert(
+	offsetof(struct ow_objmem_context, mark_stack) == sizeof(size_t) &&
+	offsetof(struct mark_stack, marker) == 0,
+	"_ow_objmem_marker()");
 
-struct ow_objmem_context *ow_objmem_context_new(void) {
+struct ow_objmem_context *ow_objmem_context_new(const struct ow_allocator *allocator) {
 	struct ow_objmem_context *const ctx = ow_malloc(sizeof(struct ow_objmem_context));
 	ctx->no_gc_count = 0;
 	ctx->gc_threshold = DEFAULT_GC_THRESHOLD;
-	ctx->allocate_max = DEFAULT_ALLOCATE_MAX;
+	ctx->nursery_size = DEFAULT_NURSERY_SIZE;
+	ctx->gc_trigger = ctx->nursery_size;
+	ctx->mark_budget = ow_sysparam.gc_mark_budget;
+	ctx->mark_threads = ow_sysparam.gc_mark_threads;
+	ctx->compact_threshold = ow_sysparam.gc_compact_threshold;
+	ctx->compact_pending = false;
+	ctx->updating_refs = false;
+	ctx->cpu_goal = ow_sysparam.gc_cpu_goal;
+	ctx->heap_goal = ow_sysparam.gc_heap_goal;
+	ctx->allocate_max =
+		ow_sysparam.heap_limit ? ow_sysparam.heap_limit : DEFAULT_ALLOCATE_MAX;
 	ctx->allocated_size = 0;
-	object_linked_list_init(&ctx->allocated_objects);
+	ctx->young_size = 0;
+	ctx->marking = false;
+	ctx->sweep_in_background = ow_thrd_hardware_concurrency() > 1;
+	ctx->sweeper_running = false;
+	ctx->sweeper_stop = false;
 	gc_root_list_init(&ctx->gc_root_list);
+	ow_array_init(&ctx->remembered_set, 0);
+	ow_array_init(&ctx->finalize_queue, 0);
+	ow_mtx_init(&ctx->finalize_queue_lock, ow_mtx_plain);
+	mark_stack_init(&ctx->mark_stack);
+	ow_objalloc_init(&ctx->objects, allocator);
+	gc_pacer_init(&ctx->pacer);
 #if OW_DEBUG_MEMORY
 	ctx->verbose = false;
+	ctx->slice_count = 0;
+	ctx->moved_count = 0;
 #endif // OW_DEBUG_MEMORY
 	return ctx;
 }
 
 void ow_objmem_context_del(struct ow_objmem_context *ctx) {
-	for (struct ow_object *obj = object_linked_list_first(&ctx->allocated_objects); obj; ) {
-		struct ow_object *const next_obj = ow_object_meta_get_next(&obj->_meta);
-		ow_free(obj); // Not safe!!!
-		obj = next_obj;
+	if (ctx->sweeper_running) {
+		atomic_store_explicit(&ctx->sweeper_stop, true, memory_order_relaxed);
+		ow_thrd_join(ctx->sweeper, NULL);
 	}
+	ow_objalloc_fini(&ctx->objects); // Not safe!!!
+	mark_stack_fini(&ctx->mark_stack);
+	ow_mtx_destroy(&ctx->finalize_queue_lock);
+	ow_array_fini(&ctx->finalize_queue);
+	ow_array_fini(&ctx->remembered_set);
 	gc_root_list_fini(&ctx->gc_root_list);
 	ow_free(ctx);
 }
@@ -155,9 +364,9 @@ void ow_objmem_context_del(struct ow_objmem_context *ctx) {
 void ow_objmem_context_verbose(struct ow_objmem_context *ctx, bool status) {
 	ow_unused_var(ctx);
 	ow_unused_var(status);
-#if OW_DEBUG_PARSER
+#if OW_DEBUG_MEMORY
 	ctx->verbose = status;
-#endif // OW_DEBUG_PARSER
+#endif // OW_DEBUG_MEMORY
 }
 
 void ow_objmem_add_gc_root(
@@ -172,25 +381,52 @@ bool ow_objmem_remove_gc_root(struct ow_machine *om, void *root) {
 	return gc_root_list_remove(&ctx->gc_root_list, root);
 }
 
+/// Called when the heap exceeds the limit even after a full GC. Objects can still be
+/// allocated in a reserve until the interpreter raises an exception.
+ow_noinline static void gc_out_of_memory(struct ow_machine *om) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+	const size_t limit = ctx->allocate_max + ctx->allocate_max / 8;
+	if (ow_unlikely(ctx->allocated_size >= limit))
+		abort(); // Out of memory.
+	om->out_of_memory = true;
+	// Check again before the reserve is used up.
+	const size_t rest = limit - ctx->allocated_size;
+	if (ctx->young_size + rest < ctx->gc_trigger)
+		ctx->gc_trigger = ctx->young_size + rest;
+}
+
 struct ow_object *ow_objmem_allocate(
 		struct ow_machine *om, struct ow_class_obj *obj_class,
 		size_t extra_field_count) {
 	struct ow_objmem_context *const ctx = om->objmem_context;
 	struct ow_object *obj;
 
-	if (ow_unlikely(ctx->allocated_size >= ctx->gc_threshold)) {
-		ow_objmem_gc(om, 0);
-		if (ow_unlikely(ctx->allocated_size >= ctx->allocate_max))
-			abort(); // Out of memory.
+	if (ow_unlikely(ctx->young_size >= ctx->gc_trigger)) {
+		ow_objmem_gc(om, OW_OBJMEM_GC_INCREMENTAL);
+		if (ow_unlikely(ctx->allocated_size >= ctx->allocate_max)) {
+			ow_objmem_gc(om, OW_OBJMEM_GC_FULL);
+			if (ow_unlikely(ctx->allocated_size >= ctx->allocate_max))
+				gc_out_of_memory(om);
+		}
 	}
 
 #define OBJ_ALLOC(OBJ_FLD_CNT) \
 	do { \
 		const size_t obj_size = OW_OBJECT_SIZE + (OBJ_FLD_CNT) * sizeof(void *); \
-		obj = ow_malloc(obj_size); \
-		ctx->allocated_size += obj_size; \
 		static_assert(sizeof obj->_meta == sizeof(uint64_t), ""); \
-		*(uint64_t *)&obj->_meta = UINT64_C(0); \
+		if (ow_likely(obj_size <= OW_OBJALLOC_SMALL_MAX)) { \
+			size_t cell_size; \
+			obj = ow_objalloc_allocate(&ctx->objects, obj_size, &cell_size); \
+			ctx->allocated_size += cell_size; \
+			ctx->young_size += cell_size; \
+			*(uint64_t *)&obj->_meta = UINT64_C(0); \
+		} else { \
+			obj = ow_objalloc_allocate_large(&ctx->objects, obj_size); \
+			ctx->allocated_size += obj_size; \
+			ctx->young_size += obj_size; \
+			*(uint64_t *)&obj->_meta = UINT64_C(0); \
+			ow_object_meta_set_flag(&obj->_meta, OW_OBJMETA_FLAG_LARGE); \
+		} \
 	} while (false) \
 // ^^^ OBJ_ALLOC() ^^^
 
@@ -209,97 +445,587 @@ struct ow_object *ow_objmem_allocate(
 #undef OBJ_ALLOC
 
 	obj->_class = obj_class;
-	object_linked_list_add(&ctx->allocated_objects, obj);
+	if (ow_unlikely(ow_class_obj_pub_info(obj_class)->finalizer))
+		ow_objmem_object_enable_finalizer(obj);
 
-	assert(!ow_smallint_check(obj));
+	assert(!ow_object_is_immediate(obj));
 	return obj;
 }
 
-ow_forceinline static size_t delete_obj(struct ow_machine *om, struct ow_object *obj) {
-	size_t obj_field_count;
-	if (ow_unlikely(ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_EXTENDED)))
-		obj_field_count = (uintptr_t)ow_object_get_field(obj, 0);
-	else
-		obj_field_count = ow_class_obj_pub_info(obj->_class)->basic_field_count;
-	const size_t obj_size = OW_OBJECT_SIZE + obj_field_count * sizeof(void *);
+/// Finalize a dead object, which may happen on the sweeper thread. Return false if
+/// the finalization is deferred. See `ow_objalloc_collect()`.
+static bool finalize_obj(void *ctx, void *ptr) {
+	struct ow_machine *const om = ctx;
+	struct ow_object *const obj = ptr;
+	const struct ow_class_obj_pub_info *const info = ow_class_obj_pub_info(obj->_class);
+	if (ow_unlikely(!info->finalizer))
+		return true;
+	if (ow_likely(info->concurrent_finalizer)) {
+		info->finalizer(om, obj);
+		return true;
+	}
+	if (ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_FINALIZING))
+		return false; // Already queued, and swept again.
+	ow_object_meta_set_flag(&obj->_meta, OW_OBJMETA_FLAG_FINALIZING);
+	struct ow_objmem_context *const omc = om->objmem_context;
+	ow_mtx_lock(&omc->finalize_queue_lock);
+	ow_array_append(&omc->finalize_queue, obj);
+	ow_mtx_unlock(&omc->finalize_queue_lock);
+	return false;
+}
 
-	void (*const finalizer)(struct ow_machine *,struct ow_object *) =
-	ow_class_obj_pub_info(obj->_class)->finalizer;
-	if (ow_unlikely(finalizer))
-		finalizer(om, obj);
-	ow_free(obj);
+static int gc_sweeper_main(void *arg) {
+	struct ow_objmem_context *const ctx = arg;
+	ow_malloc_set_allocator(ctx->objects.allocator);
+	while (!atomic_load_explicit(&ctx->sweeper_stop, memory_order_relaxed)) {
+		if (!ow_objalloc_sweep_block(&ctx->objects))
+			break;
+	}
+	return 0;
+}
+
+/// Run deferred finalizers. Sweeping must have been finished.
+static void gc_run_finalize_queue(struct ow_machine *om) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+	assert(!ow_objalloc_sweeping(&ctx->objects));
+	if (ow_likely(!ow_array_size(&ctx->finalize_queue)))
+		return;
 
-	return obj_size;
+	// Classes are finalized last, as finalizers of their instances may read them.
+	struct ow_class_obj *const class_class = om->builtin_classes->class_;
+	for (int pass = 0; pass < 2; pass++) {
+		for (size_t i = 0, n = ow_array_size(&ctx->finalize_queue); i < n; i++) {
+			struct ow_object *const obj = ow_array_at(&ctx->finalize_queue, i);
+			if ((ow_object_class(obj) == class_class) != (pass == 1))
+				continue;
+			ow_class_obj_pub_info(ow_object_class(obj))->finalizer(om, obj);
+			ow_objalloc_clear_finalizable(
+				obj, ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_LARGE));
+		}
+	}
+	ow_array_clear(&ctx->finalize_queue);
 }
 
-int ow_objmem_gc(struct ow_machine *om, int flags) {
-	ow_unused_var(flags);
+/// Stop the sweeper, and take the blocks it has swept. Run deferred finalizers
+/// if sweeping has been finished.
+static void gc_stop_sweeper(struct ow_machine *om) {
 	struct ow_objmem_context *const ctx = om->objmem_context;
+	assert(ctx->no_gc_count);
+	if (ctx->sweeper_running) {
+		atomic_store_explicit(&ctx->sweeper_stop, true, memory_order_relaxed);
+		ow_thrd_join(ctx->sweeper, NULL);
+		ctx->sweeper_running = false;
+	}
+	ow_objalloc_take_swept(&ctx->objects);
+	if (!ow_objalloc_sweeping(&ctx->objects))
+		gc_run_finalize_queue(om);
+}
 
-	if (ow_unlikely(ctx->no_gc_count
-			|| !object_linked_list_empty(&ctx->allocated_objects)))
-		return -1;
-	ctx->no_gc_count = 1;
+/// Stop the sweeper, sweep the rest of the blocks, and run deferred finalizers.
+static void gc_finish_sweeping(struct ow_machine *om) {
+	gc_stop_sweeper(om);
+	if (ow_objalloc_sweeping(&om->objmem_context->objects)) {
+		ow_objalloc_finish_sweep(&om->objmem_context->objects);
+		gc_run_finalize_queue(om);
+	}
+}
 
-#if OW_DEBUG_MEMORY
-	struct timespec ts0;
-	timespec_get(&ts0, TIME_UTC);
-#endif // OW_DEBUG_MEMORY
+static void gc_rescan_marked_obj(void *ctx, void *ptr) {
+	struct ow_machine *const om = ctx;
+	struct mark_stack *const mark_stack = &om->objmem_context->mark_stack;
+	_ow_objmem_object_gc_mark_children_obj(om, ptr);
+	for (struct ow_object *obj; (obj = mark_stack_pop(mark_stack)); )
+		_ow_objmem_object_gc_mark_children_obj(om, obj);
+}
 
-	gc_root_list_mark(&ctx->gc_root_list, om);
-	_om_machine_gc_marker(om); // Must be called last.
+/// Pop objects from the mark stack and mark their children, until the stack is
+/// empty or `budget` objects have been processed. Return whether it is empty.
+/// If the stack has overflowed, scan all the marked objects when it gets empty.
+static bool gc_drain_mark_stack(struct ow_machine *om, size_t budget) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+	struct mark_stack *const mark_stack = &ctx->mark_stack;
+	while (true) {
+		for (; budget; budget--) {
+			struct ow_object *const obj = mark_stack_pop(mark_stack);
+			if (ow_unlikely(!obj))
+				break;
+			_ow_objmem_object_gc_mark_children_obj(om, obj);
+		}
+		if (!budget)
+			return false;
+		if (ow_likely(!mark_stack->overflowed))
+			return true;
+		// Some marked objects were not pushed. Their children are unmarked.
+		mark_stack->overflowed = false;
+		ow_objalloc_foreach_marked(&ctx->objects, gc_rescan_marked_obj, om);
+	}
+}
 
-	size_t freed_size = 0;
+/// Objects taken from a mark stack, which other workers can steal.
+struct mark_packet {
+	struct mark_packet *next;
+	size_t count;
+	struct ow_object *objects[MARK_PACKET_SIZE];
+};
 
-	for (struct ow_object *prev_obj = object_linked_list_pre_first(&ctx->allocated_objects); ; ) {
-		struct ow_object *obj = ow_object_meta_get_next(&prev_obj->_meta);
-	re_process_obj:
-		if (ow_unlikely(!obj))
-			break;
+struct gc_parallel_mark;
+
+/// A thread doing parallel marking. It marks with a copy of the machine, whose
+/// `objmem_context` points to the worker, so that `ow_objmem_object_gc_marker()`
+/// pushes objects to the mark stack of the worker.
+struct gc_mark_worker {
+	size_t no_gc_count; // Always 1. See `_ow_objmem_ngc_count()`.
+	struct mark_stack mark_stack; // See `_ow_objmem_marker()`.
+	struct ow_machine machine;
+	struct gc_parallel_mark *pm;
+	ow_mtx_t packets_lock;
+	struct mark_packet *packets; // Packets that can be stolen, protected by `packets_lock`.
+	atomic_uint packet_count;
+	ow_thrd_t thread;
+};
+
+static_assert(
+	offsetof(struct gc_mark_worker, no_gc_count) == 0 &&
+	offsetof(struct gc_mark_worker, mark_stack) ==
+		offsetof(struct ow_objmem_context, mark_stack),
+	"_ow_objmem_marker()");
 
-		if (ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_MARKED)) {
-			ow_object_meta_clear_flag(&obj->_meta, OW_OBJMETA_FLAG_MARKED);
-			prev_obj = obj;
+/// Parallel marking. Each worker marks objects from its own mark stack. When a
+/// worker runs out of objects, it becomes idle and steals a packet from another
+/// worker; busy workers move objects from their stacks into packets when
+/// they find idle ones. Marking is done when all the workers are idle and there
+/// are no packets left.
+struct gc_parallel_mark {
+	size_t worker_count;
+	atomic_uint idle_count;
+	struct gc_mark_worker workers[];
+};
+
+/// Move some objects from the bottom of the current segment into a packet,
+/// where older objects are likely to have more objects to mark behind them.
+static void gc_mark_worker_share(struct gc_mark_worker *w) {
+	if (atomic_load(&w->packet_count))
+		return;
+	struct mark_stack *const stack = &w->mark_stack;
+	struct ow_object **const slots = stack->segment->slots;
+	const size_t n = (size_t)(stack->marker.top - slots);
+	const size_t k = n / 2 < MARK_PACKET_SIZE ? n / 2 : MARK_PACKET_SIZE;
+	if (!k)
+		return;
+	struct mark_packet *const packet = ow_malloc(sizeof(struct mark_packet));
+	if (ow_unlikely(!packet))
+		return;
+	packet->count = k;
+	memcpy(packet->objects, slots, k * sizeof(struct ow_object *));
+	memmove(slots, slots + k, (n - k) * sizeof(struct ow_object *));
+	stack->marker.top -= k;
+
+	ow_mtx_lock(&w->packets_lock);
+	packet->next = w->packets;
+	w->packets = packet;
+	atomic_fetch_add(&w->packet_count, 1);
+	ow_mtx_unlock(&w->packets_lock);
+}
+
+/// Become idle and wait for a packet from any worker. Return false if all the
+/// workers are idle and there is nothing to steal.
+static bool gc_mark_worker_steal(struct gc_mark_worker *w) {
+	struct gc_parallel_mark *const pm = w->pm;
+	const size_t worker_count = pm->worker_count;
+	const size_t self_index = (size_t)(w - pm->workers);
+	atomic_fetch_add(&pm->idle_count, 1);
+	for (size_t round = 0; ; round++) {
+		for (size_t i = 0; i < worker_count; i++) {
+			struct gc_mark_worker *const victim =
+				&pm->workers[(self_index + i) % worker_count];
+			if (!atomic_load(&victim->packet_count))
+				continue;
+			// Leave idle state before taking the packet, so that no one can see all
+			// the workers idle while this one holds objects to mark.
+			atomic_fetch_sub(&pm->idle_count, 1);
+			ow_mtx_lock(&victim->packets_lock);
+			struct mark_packet *const packet = victim->packets;
+			if (packet) {
+				victim->packets = packet->next;
+				atomic_fetch_sub(&victim->packet_count, 1);
+			}
+			ow_mtx_unlock(&victim->packets_lock);
+			if (packet) {
+				for (size_t j = 0; j < packet->count; j++)
+					mark_stack_push(&w->mark_stack, packet->objects[j]);
+				ow_free(packet);
+				return true;
+			}
+			atomic_fetch_add(&pm->idle_count, 1);
+		}
+		if (atomic_load(&pm->idle_count) == worker_count)
+			return false;
+		if (round < 64) {
+			ow_thrd_yield();
 		} else {
-			struct ow_object *const next_obj = ow_object_meta_get_next(&obj->_meta);
-			freed_size += delete_obj(om, obj);
-			ow_object_meta_set_next(&prev_obj->_meta, next_obj);
-			obj = next_obj;
-			goto re_process_obj;
+			const struct timespec duration = {0, 20000};
+			ow_thrd_sleep(&duration, NULL);
 		}
 	}
+}
 
-	assert(ctx->no_gc_count == 1);
-	ctx->no_gc_count = 0;
+static int gc_mark_worker_main(void *arg) {
+	struct gc_mark_worker *const w = arg;
+	struct ow_machine *const om = &w->machine;
+	struct gc_parallel_mark *const pm = w->pm;
+	ow_malloc_set_allocator(om->allocator);
+	do {
+		size_t n = 0;
+		for (struct ow_object *obj; (obj = mark_stack_pop(&w->mark_stack)); ) {
+			_ow_objmem_object_gc_mark_children_obj(om, obj);
+			if (ow_unlikely(++n % MARK_SHARE_INTERVAL == 0) && atomic_load(&pm->idle_count))
+				gc_mark_worker_share(w);
+		}
+	} while (gc_mark_worker_steal(w));
+	return 0;
+}
+
+/// Mark objects in the mark stack and their children with `thread_count` threads,
+/// including the current one. Objects that were not pushed because of mark stack
+/// overflow are left to `gc_drain_mark_stack()`.
+static void gc_drain_mark_stack_parallel(struct ow_machine *om, size_t thread_count) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+	struct gc_parallel_mark *const pm = ow_malloc(
+		sizeof(struct gc_parallel_mark) + sizeof(struct gc_mark_worker) * thread_count);
+	pm->worker_count = thread_count;
+	atomic_store(&pm->idle_count, 0);
+	for (size_t i = 0; i < thread_count; i++) {
+		struct gc_mark_worker *const w = &pm->workers[i];
+		w->no_gc_count = 1;
+		mark_stack_init(&w->mark_stack);
+		w->machine = *om;
+		w->machine.objmem_context = (struct ow_objmem_context *)w;
+		w->pm = pm;
+		ow_mtx_init(&w->packets_lock, ow_mtx_plain);
+		w->packets = NULL;
+		atomic_store(&w->packet_count, 0);
+	}
+	// The current thread is worker 0, which starts with the existing mark stack.
+	pm->workers[0].mark_stack = ctx->mark_stack;
+	pm->workers[0].mark_stack.marker.parallel = true;
+	for (size_t i = 1; i < thread_count; i++) {
+		struct gc_mark_worker *const w = &pm->workers[i];
+		w->mark_stack.marker.parallel = true;
+		if (ow_thrd_create(&w->thread, gc_mark_worker_main, w) != ow_thrd_success) {
+			w->pm = NULL; // Not started. It has nothing to do and is always idle.
+			atomic_fetch_add(&pm->idle_count, 1);
+		}
+	}
+
+	gc_mark_worker_main(&pm->workers[0]);
+
+	ctx->mark_stack = pm->workers[0].mark_stack;
+	ctx->mark_stack.marker.parallel = false;
+	for (size_t i = 0; i < thread_count; i++) {
+		struct gc_mark_worker *const w = &pm->workers[i];
+		if (i && w->pm)
+			ow_thrd_join(w->thread, NULL);
+		assert(!w->packets);
+		ow_mtx_destroy(&w->packets_lock);
+		if (w->mark_stack.overflowed)
+			ctx->mark_stack.overflowed = true;
+		if (i)
+			mark_stack_fini(&w->mark_stack);
+	}
+	ow_free(pm);
+}
+
+/// Push objects in the remembered set to the mark stack and clear the set.
+/// If `rescan` is false, just clear it.
+static void gc_flush_remembered_set(struct ow_machine *om, bool rescan) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+	for (size_t i = 0, n = ow_array_size(&ctx->remembered_set); i < n; i++) {
+		struct ow_object *const obj = ow_array_at(&ctx->remembered_set, i);
+		ow_object_meta_clear_flag(&obj->_meta, OW_OBJMETA_FLAG_REMEMBERED);
+		if (rescan) {
+			assert(ow_objmem_object_is_marked(obj));
+			mark_stack_push(&ctx->mark_stack, obj);
+		}
+	}
+	ow_array_clear(&ctx->remembered_set);
+}
+
+static void gc_mark_roots(struct ow_machine *om) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+	gc_root_list_mark(&ctx->gc_root_list, om);
+	_om_machine_gc_marker(om);
+}
+
+static bool gc_obj_movable(void *ctx, void *ptr) {
+	struct ow_machine *const om = ctx;
+	const struct ow_object *const obj = ptr;
+	if (ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_PINNED))
+		return false;
+	// The symbol pool refers to symbols without marking them. Classes and modules
+	// are often referenced by native data.
+	const struct ow_class_obj *const obj_class = obj->_class;
+	const struct ow_builtin_classes *const bc = om->builtin_classes;
+	return obj_class != bc->symbol && obj_class != bc->class_ && obj_class != bc->module;
+}
+
+static void gc_forward_obj(void *ctx, void *from, void *to) {
+	ow_unused_var(ctx);
+	struct ow_object *const obj = from;
+	ow_object_meta_set_flag(&obj->_meta, OW_OBJMETA_FLAG_FORWARDED);
+	obj->_class = to;
+}
+
+static void gc_update_obj_refs(void *ctx, void *ptr) {
+	struct ow_machine *const om = ctx;
+	struct ow_object *const obj = ptr;
+	ow_object_meta_clear_flag(&obj->_meta, OW_OBJMETA_FLAG_PINNED);
+	_ow_objmem_object_gc_mark_children_obj(om, obj);
+}
+
+/// Move unpinned objects out of sparse blocks, and update references to them.
+/// Marking must have been finished.
+static void gc_compact(struct ow_machine *om) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+	assert(ctx->mark_stack.marker.compacting && !ctx->updating_refs);
+	const size_t moved_count = ow_objalloc_evacuate(
+		&ctx->objects, finalize_obj, gc_obj_movable, gc_forward_obj, om);
+	// Visit all the marked objects even if nothing was moved, to clear the pins.
+	ctx->updating_refs = true;
+	ow_objalloc_foreach_marked(&ctx->objects, gc_update_obj_refs, om);
+	ctx->updating_refs = false;
+	ctx->mark_stack.marker.compacting = false;
+	ow_objalloc_finish_evacuation(&ctx->objects);
+	ctx->compact_pending = false;
+#if OW_DEBUG_MEMORY
+	ctx->moved_count = moved_count;
+#else // !OW_DEBUG_MEMORY
+	ow_unused_var(moved_count);
+#endif // OW_DEBUG_MEMORY
+}
+
+/// Update the statistics after a GC, and decide the nursery size and the full GC
+/// threshold. `young_size` and `old_size` are sizes before the GC.
+static void gc_pace(
+		struct ow_objmem_context *ctx, bool full_gc,
+		size_t young_size, size_t old_size, size_t alive_size) {
+	struct gc_pacer *const pacer = &ctx->pacer;
+
+	if (pacer->mutator_time > 0)
+		gc_pacer_sample(&pacer->alloc_rate, (double)young_size / pacer->mutator_time);
+	pacer->full_mutator_time += pacer->mutator_time;
+	if (full_gc) {
+		gc_pacer_sample(&pacer->full_pause, pacer->pause_time);
+		if (pacer->full_mutator_time > 0 && old_size > pacer->full_alive_size) {
+			gc_pacer_sample(&pacer->promote_rate,
+				(double)(old_size - pacer->full_alive_size) / pacer->full_mutator_time);
+		}
+		pacer->full_alive_size = alive_size;
+		pacer->full_mutator_time = 0;
+	} else {
+		gc_pacer_sample(&pacer->minor_pause, pacer->pause_time);
+	}
+	pacer->pause_time = 0;
+	pacer->mutator_time = 0;
+
+	// A GC is needed every `pause * (1 - goal) / goal` seconds of mutator time,
+	// with half of the goal for minor GCs and the other half for full GCs.
+	const double goal_ratio =
+		ctx->cpu_goal ? (200.0 - (double)ctx->cpu_goal) / (double)ctx->cpu_goal : 0;
+
+	size_t nursery_size = DEFAULT_NURSERY_SIZE;
+	if (ctx->cpu_goal && pacer->minor_pause > 0 && pacer->alloc_rate > 0) {
+		const double n = pacer->alloc_rate * pacer->minor_pause * goal_ratio;
+		nursery_size =
+			n < (double)MIN_NURSERY_SIZE ? MIN_NURSERY_SIZE :
+			n > (double)MAX_NURSERY_SIZE ? MAX_NURSERY_SIZE : (size_t)n;
+	}
+	if (ctx->heap_goal) {
+		const size_t n = ctx->heap_goal > alive_size ? (ctx->heap_goal - alive_size) / 2 : 0;
+		if (n < nursery_size)
+			nursery_size = n > MIN_NURSERY_SIZE ? n : MIN_NURSERY_SIZE;
+	}
+	ctx->nursery_size = nursery_size;
+
+	if (!full_gc)
+		return;
+	size_t headroom = alive_size;
+	if (ctx->cpu_goal && pacer->promote_rate > 0) {
+		const double n = pacer->promote_rate * pacer->full_pause * goal_ratio;
+		headroom = n < (double)SIZE_MAX / 2 ? (size_t)n : SIZE_MAX / 2;
+	}
+	if (ctx->heap_goal) {
+		// Leave some room even if the goal cannot be met, or full GCs would never end.
+		size_t n = ctx->heap_goal > alive_size + nursery_size ?
+			ctx->heap_goal - alive_size - nursery_size : 0;
+		if (n < alive_size / 4)
+			n = alive_size / 4;
+		if (n < headroom)
+			headroom = n;
+	}
+	if (headroom < nursery_size)
+		headroom = nursery_size;
+	const size_t threshold = alive_size + headroom;
+	ctx->gc_threshold = threshold > DEFAULT_GC_THRESHOLD || ctx->heap_goal ?
+		threshold : DEFAULT_GC_THRESHOLD;
+}
+
+/// Finish marking and reclaim unmarked objects.
+static void gc_finish(struct ow_machine *om, bool full_gc) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+
+	if (ctx->marking) {
+		// Objects that were modified without marking the stored values, and the roots,
+		// which have no write barriers.
+		gc_flush_remembered_set(om, true);
+		gc_mark_roots(om);
+		ctx->marking = false;
+	}
+	// Starting threads is not worth it for a small heap.
+	if (full_gc && ctx->mark_threads > 1 && ctx->allocated_size >= DEFAULT_GC_THRESHOLD &&
+			!ctx->mark_stack.marker.compacting)
+		gc_drain_mark_stack_parallel(om, ctx->mark_threads);
+	gc_drain_mark_stack(om, SIZE_MAX);
+	_ow_symbol_pool_gc_handler(om, om->symbol_pool);
+	if (ctx->mark_stack.marker.compacting)
+		gc_compact(om);
+	// Unmarked small objects are finalized and reclaimed when sweeping.
+	const size_t alive_size = ow_objalloc_collect(&ctx->objects, finalize_obj, om);
+	assert(!ctx->sweeper_running);
+	if (ctx->sweep_in_background && ow_objalloc_sweeping(&ctx->objects)) {
+		atomic_store_explicit(&ctx->sweeper_stop, false, memory_order_relaxed);
+		if (ow_thrd_create(&ctx->sweeper, gc_sweeper_main, ctx) == ow_thrd_success)
+			ctx->sweeper_running = true;
+	}
+	// Otherwise, blocks are swept when allocating.
 
-	assert(freed_size <= ctx->allocated_size);
-	const size_t alive_size = ctx->allocated_size - freed_size;
+	assert(alive_size <= ctx->allocated_size);
+	const size_t freed_size = ctx->allocated_size - alive_size;
+	ow_unused_var(freed_size);
+	gc_pacer_pause_end(&ctx->pacer);
+	const double pause_time = ctx->pacer.pause_time;
+	ow_unused_var(pause_time);
+	gc_pace(ctx, full_gc,
+		ctx->young_size, ctx->allocated_size - ctx->young_size, alive_size);
 	ctx->allocated_size = alive_size;
-	if (ow_unlikely(freed_size < alive_size / 4)) {
-		const size_t new_th = alive_size + alive_size / 2;
-		ctx->gc_threshold = new_th;
-	} else if (ow_unlikely(freed_size > alive_size * 3)) {
-		const size_t new_th = alive_size * 2;
-		ctx->gc_threshold = new_th > DEFAULT_GC_THRESHOLD ? new_th : DEFAULT_GC_THRESHOLD;
+	ctx->young_size = 0;
+	ctx->gc_trigger = ctx->nursery_size;
+	if (full_gc) {
+		ctx->compact_pending = ctx->compact_threshold &&
+			ow_objalloc_fragmentation(&ctx->objects) >= ctx->compact_threshold;
 	}
 
 #if OW_DEBUG_MEMORY
 	if (ow_unlikely(ctx->verbose)) {
-		struct timespec ts1;
-		timespec_get(&ts1, TIME_UTC);
-		double dt_ms =
-			(double)(ts1.tv_sec - ts0.tv_sec) * 1e3 +
-			(double)(ts1.tv_nsec - ts0.tv_nsec) / 1e6;
-
 		fprintf(
-			stderr, "[GC] %zu B freed, %zu B alive, next-threshold = %zu B; %.1lf ms\n",
-			freed_size, alive_size, ctx->gc_threshold, dt_ms);
+			stderr, "[GC] %s: %zu B freed, %zu B alive, next-threshold = %zu B, "
+			"nursery = %zu B; %.1lf ms",
+			full_gc ? "full" : "minor", freed_size, alive_size,
+			ctx->gc_threshold, ctx->nursery_size, pause_time * 1e3);
+		if (ctx->slice_count)
+			fprintf(stderr, " (after %zu slices)", ctx->slice_count);
+		if (ctx->moved_count)
+			fprintf(stderr, " (%zu objects moved)", ctx->moved_count);
+		fputc('\n', stderr);
 	}
+	ctx->slice_count = 0;
+	ctx->moved_count = 0;
+#endif // OW_DEBUG_MEMORY
+}
+
+/// Do a slice of incremental marking. Finish the GC if there is nothing to mark.
+static int gc_mark_slice(struct ow_machine *om) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+	assert(ctx->marking);
+	if (ow_unlikely(ctx->no_gc_count))
+		return -1;
+	ctx->no_gc_count = 1;
+
+#if OW_DEBUG_MEMORY
+	ctx->slice_count++;
 #endif // OW_DEBUG_MEMORY
+	gc_pacer_pause_begin(&ctx->pacer);
+
+	// Do not let the heap grow too much if marking cannot keep up with allocation.
+	const size_t budget =
+		ow_likely(ctx->young_size < ctx->gc_threshold) ? ctx->mark_budget : SIZE_MAX;
+	if (gc_drain_mark_stack(om, budget)) {
+		gc_finish(om, true);
+	} else {
+		ctx->gc_trigger = ctx->young_size + GC_SLICE_INTERVAL;
+		gc_pacer_pause_end(&ctx->pacer);
+	}
+
+	assert(ctx->no_gc_count == 1);
+	ctx->no_gc_count = 0;
+	return 0;
+}
+
+int ow_objmem_gc(struct ow_machine *om, int flags) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+
+	if (ctx->marking && (flags & OW_OBJMEM_GC_INCREMENTAL))
+		return gc_mark_slice(om);
+
+	if (ow_unlikely(ctx->no_gc_count))
+		return -1;
+	ctx->no_gc_count = 1;
+
+	gc_pacer_pause_begin(&ctx->pacer);
+
+	if (ctx->marking) {
+		gc_finish(om, true);
+		if (!(flags & OW_OBJMEM_GC_FULL))
+			goto done;
+	}
+
+	const size_t old_size = ctx->allocated_size - ctx->young_size;
+	const bool full_gc = (flags & OW_OBJMEM_GC_FULL) || old_size >= ctx->gc_threshold;
+
+	if (full_gc) {
+		gc_finish_sweeping(om);
+		ow_objalloc_clear_marks(&ctx->objects);
+		ctx->mark_stack.marker.compacting = ctx->compact_pending;
+	} else {
+		gc_stop_sweeper(om);
+	}
+	gc_flush_remembered_set(om, !full_gc);
+	gc_mark_roots(om);
+
+	if (full_gc && (flags & OW_OBJMEM_GC_INCREMENTAL) && ctx->mark_budget &&
+			!ctx->mark_stack.marker.compacting) {
+		ctx->marking = true;
+		ctx->gc_trigger = ctx->young_size + GC_SLICE_INTERVAL;
+		gc_pacer_pause_end(&ctx->pacer);
+		goto done;
+	}
+
+	gc_finish(om, full_gc);
+	if (flags & OW_OBJMEM_GC_FULL)
+		gc_finish_sweeping(om);
 
+done:
+	assert(ctx->no_gc_count == 1);
+	ctx->no_gc_count = 0;
 	return 0;
 }
 
+void _ow_objmem_write_barrier_slow(
+		struct ow_machine *om, struct ow_object *obj, struct ow_object *val) {
+	struct ow_objmem_context *const ctx = om->objmem_context;
+	if (val && ctx->marking) {
+		ow_objmem_object_gc_marker(om, val);
+		return;
+	}
+	assert(!ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_REMEMBERED));
+	ow_object_meta_set_flag(&obj->_meta, OW_OBJMETA_FLAG_REMEMBERED);
+	ow_array_append(&ctx->remembered_set, obj);
+}
+
+void _ow_objmem_mark_stack_push_slow(struct ow_machine *om, struct ow_object *obj) {
+	// The context may be a `struct gc_mark_worker` in fact.
+	mark_stack_push_slow((struct mark_stack *)_ow_objmem_marker(om), obj);
+}
+
 void _ow_objmem_object_gc_mark_children_obj(
 		struct ow_machine *om, struct ow_object *obj) {
 	struct ow_class_obj *const obj_class = ow_object_class(obj);
@@ -321,5 +1047,22 @@ void _ow_objmem_object_gc_mark_children_obj(
 	const size_t field_count = info->basic_field_count; // Ignore extra (extended) fields.
 	assert(field_index <= field_count);
 	for (; field_index < field_count; field_index++)
-		ow_objmem_object_gc_marker(om, ow_object_get_field(obj, field_index));
+		ow_objmem_object_gc_slot_marker(om, &obj->_fields[field_index]);
+}
+
+void _ow_objmem_object_gc_pin(struct ow_machine *om, struct ow_object *obj) {
+	if (om->objmem_context->updating_refs)
+		return; // Pinned objects have not been moved.
+	ow_object_meta_set_flag(&obj->_meta, OW_OBJMETA_FLAG_PINNED);
+	_ow_objmem_object_gc_mark(om, _ow_objmem_marker(om), obj);
+}
+
+void _ow_objmem_object_gc_update_slot(struct ow_machine *om, struct ow_object **slot) {
+	struct ow_object *const obj = *slot;
+	if (!om->objmem_context->updating_refs) {
+		_ow_objmem_object_gc_mark(om, _ow_objmem_marker(om), obj);
+		return;
+	}
+	if (ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_FORWARDED))
+		*slot = (struct ow_object *)obj->_class;
 }
@@ -4,18 +4,21 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "objalloc.h"
 #include "object.h"
 #include "smallint.h"
 
 #include <utilities/attributes.h>
 
+struct ow_allocator;
 struct ow_machine;
 
 /// Context of object memory management.
 struct ow_objmem_context;
 
-/// Create a memory context.
-struct ow_objmem_context *ow_objmem_context_new(void);
+/// Create a memory context. Objects are allocated with `allocator` (NULL for the
+/// C library), which is also set for the threads of the GC; see `ow_malloc_set_allocator()`.
+struct ow_objmem_context *ow_objmem_context_new(const struct ow_allocator *allocator);
 /// Destroy a memory context.
 void ow_objmem_context_del(struct ow_objmem_context *ctx);
 /// Set verbose flag.
@@ -33,7 +36,16 @@ bool ow_objmem_remove_gc_root(struct ow_machine *om, void *root);
 struct ow_object *ow_objmem_allocate(
 	struct ow_machine *om, struct ow_class_obj *obj_class, size_t extra_field_count);
 
-/// Run garbage collection.
+/// Collect the whole heap rather than only the young generation.
+#define OW_OBJMEM_GC_FULL         0x0001
+/// Allow a full GC to be done incrementally, if enabled.
+#define OW_OBJMEM_GC_INCREMENTAL  0x0002
+
+/// Run garbage collection. Unless `OW_OBJMEM_GC_FULL` is in `flags`, it may be
+/// a minor collection, which only reclaims objects allocated since last GC.
+/// With `OW_OBJMEM_GC_INCREMENTAL`, a full GC may only start marking, and the
+/// marking continues in slices while allocating. An incremental marking in
+/// progress is always finished by this function.
 int ow_objmem_gc(struct ow_machine *om, int flags);
 /// Start a no-GC region.
 ow_static_forceinline void ow_objmem_push_ngc(struct ow_machine *om);
@@ -48,13 +60,53 @@ ow_static_forceinline bool ow_objmem_test_ngc(struct ow_machine *om);
 /// while others will be automatically marked.
 /// A native gc_marker function will be called if exists in its class, which shall
 /// mark native fields and extra fields manually if needed.
+/// With parallel marking, native gc_marker functions may run on helper threads at
+/// the same time, each with its own `om` that is a copy of the machine. They must
+/// only read the objects and the machine, and pass the given `om` to this function.
+/// The object is pinned during a compacting GC, as the reference cannot be updated.
 ow_static_forceinline void ow_objmem_object_gc_marker(
 	struct ow_machine *om, struct ow_object *obj);
+/// GC marker for a reference that the GC may update, so that the object can be
+/// moved by compaction. During a compacting GC, native gc_marker functions are
+/// called again after moving objects, and this function then updates the slot.
+/// With compaction enabled, native code must not keep a reference to an object
+/// across anything that may allocate, unless the object is reachable from the
+/// roots (e.g. on the call stack), or is only referenced with the other marker.
+ow_static_forceinline void ow_objmem_object_gc_slot_marker(
+	struct ow_machine *om, struct ow_object **slot);
+/// Check whether an object has been marked. In GC, it is valid after marking the roots.
+/// Outside GC, it tells whether the object is old, i.e. has survived a GC.
+ow_static_forceinline bool ow_objmem_object_is_marked(const struct ow_object *obj);
+/// Make sure that an object is finalized before being reclaimed. This is needed only
+/// if the class of the object gets a finalizer after the object was allocated.
+ow_static_forceinline void ow_objmem_object_enable_finalizer(struct ow_object *obj);
+
+/// Write barrier. It must be called after storing a reference to `val` into an
+/// existing object `obj` (a field or native data), before anything that may run a
+/// GC. Not needed if `obj` has just been allocated and no GC can have happened since.
+ow_static_forceinline void ow_objmem_write_barrier(
+	struct ow_machine *om, struct ow_object *obj, struct ow_object *val);
+/// Write barrier for storing any number of references into an existing object.
+/// See `ow_objmem_write_barrier()`.
+ow_static_forceinline void ow_objmem_write_barrier_n(
+	struct ow_machine *om, struct ow_object *obj);
 
 ow_static_forceinline size_t *_ow_objmem_ngc_count(struct ow_machine *om) {
 	return (size_t *)*(struct ow_objmem_context **)om;
 }
 
+/// State of the marker, which is stored right after the no-GC count.
+struct _ow_objmem_marker {
+	struct ow_object **top; ///< Next free slot in current segment of the mark stack.
+	struct ow_object **limit; ///< End of current segment of the mark stack.
+	bool parallel; ///< Whether other threads are marking at the same time.
+	bool compacting; ///< Whether to pin objects or to update references. See `ow_objmem_object_gc_slot_marker()`.
+};
+
+ow_static_forceinline struct _ow_objmem_marker *_ow_objmem_marker(struct ow_machine *om) {
+	return (struct _ow_objmem_marker *)(_ow_objmem_ngc_count(om) + 1);
+}
+
 ow_static_forceinline void ow_objmem_push_ngc(struct ow_machine *om) {
 	(*_ow_objmem_ngc_count(om))++;
 	assert(*_ow_objmem_ngc_count(om) > 0);
@@ -70,13 +122,86 @@ ow_static_forceinline bool ow_objmem_test_ngc(struct ow_machine *om) {
 }
 
 void _ow_objmem_object_gc_mark_children_obj(struct ow_machine *om, struct ow_object *obj);
+void _ow_objmem_mark_stack_push_slow(struct ow_machine *om, struct ow_object *obj);
+void _ow_objmem_object_gc_pin(struct ow_machine *om, struct ow_object *obj);
+void _ow_objmem_object_gc_update_slot(struct ow_machine *om, struct ow_object **slot);
+
+ow_static_forceinline void _ow_objmem_object_gc_mark(
+		struct ow_machine *om, struct _ow_objmem_marker *marker, struct ow_object *obj) {
+	const bool is_large = ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_LARGE);
+	if (!(ow_unlikely(marker->parallel) ?
+			ow_objalloc_mark_atomic(obj, is_large) : ow_objalloc_mark(obj, is_large)))
+		return;
+	// Children will be marked when the object is popped from the mark stack.
+	struct ow_object **const top = marker->top;
+	if (ow_likely(top != marker->limit)) {
+		*top = obj;
+		marker->top = top + 1;
+		return;
+	}
+	_ow_objmem_mark_stack_push_slow(om, obj);
+}
 
 ow_static_forceinline void ow_objmem_object_gc_marker(
 		struct ow_machine *om, struct ow_object *obj) {
-	if (ow_unlikely(ow_smallint_check(obj)))
+	if (ow_unlikely(ow_object_is_immediate(obj)))
+		return;
+	struct _ow_objmem_marker *const marker = _ow_objmem_marker(om);
+	if (ow_unlikely(marker->compacting)) {
+		_ow_objmem_object_gc_pin(om, obj);
+		return;
+	}
+	_ow_objmem_object_gc_mark(om, marker, obj);
+}
+
+ow_static_forceinline void ow_objmem_object_gc_slot_marker(
+		struct ow_machine *om, struct ow_object **slot) {
+	struct ow_object *const obj = *slot;
+	if (ow_unlikely(ow_object_is_immediate(obj)))
+		return;
+	struct _ow_objmem_marker *const marker = _ow_objmem_marker(om);
+	if (ow_unlikely(marker->compacting)) {
+		_ow_objmem_object_gc_update_slot(om, slot);
+		return;
+	}
+	_ow_objmem_object_gc_mark(om, marker, obj);
+}
+
+ow_static_forceinline bool ow_objmem_object_is_marked(const struct ow_object *obj) {
+	assert(!ow_object_is_immediate(obj));
+	return ow_objalloc_is_marked(
+		obj, ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_LARGE));
+}
+
+ow_static_forceinline void ow_objmem_object_enable_finalizer(struct ow_object *obj) {
+	assert(!ow_object_is_immediate(obj));
+	ow_objalloc_set_finalizable(
+		obj, ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_LARGE));
+}
+
+void _ow_objmem_write_barrier_slow(
+	struct ow_machine *om, struct ow_object *obj, struct ow_object *val);
+
+ow_static_forceinline void ow_objmem_write_barrier(
+		struct ow_machine *om, struct ow_object *obj, struct ow_object *val) {
+	// Only references from old (or, during incremental marking, marked) objects
+	// to young (unmarked) objects need handling.
+	if (ow_unlikely(!val) || ow_object_is_immediate(val))
+		return;
+	if (ow_likely(!ow_objmem_object_is_marked(obj)))
+		return;
+	if (ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_REMEMBERED))
+		return;
+	if (ow_objmem_object_is_marked(val))
+		return;
+	_ow_objmem_write_barrier_slow(om, obj, val);
+}
+
+ow_static_forceinline void ow_objmem_write_barrier_n(
+		struct ow_machine *om, struct ow_object *obj) {
+	if (ow_likely(!ow_objmem_object_is_marked(obj)))
 		return;
-	if (ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_MARKED))
+	if (ow_object_meta_get_flag(&obj->_meta, OW_OBJMETA_FLAG_REMEMBERED))
 		return;
-	ow_object_meta_set_flag(&obj->_meta, OW_OBJMETA_FLAG_MARKED);
-	_ow_objmem_object_gc_mark_children_obj(om, obj);
+	_ow_objmem_write_barrier_slow(om, obj, NULL);
 }
@@ -49,6 +49,7 @@ static void module_dynlib_list_add(
 
 struct ow_module_obj {
 	OW_OBJECT_HEAD
+	struct ow_module_obj_pub_info pub_info;
 	struct ow_hashmap globals_map; // { name, index + 1 }
 	struct ow_array globals;
 	struct ow_symbol_obj *name; // Optional.
@@ -57,11 +58,13 @@ struct ow_module_obj {
 };
 
 static void ow_module_obj_init(struct ow_module_obj *self) {
+	self->pub_info.globals_version = 0;
 	ow_hashmap_init(&self->globals_map, 0);
 	ow_array_init(&self->globals, 0);
 	self->name = NULL;
 	self->finalizer = NULL;
 	module_dynlib_list_init(&self->dynlib_list);
+	assert(ow_module_obj_pub_info(self) == &self->pub_info);
 }
 
 static void ow_module_obj_fini(struct ow_module_obj *self) {
@@ -126,15 +129,17 @@ void ow_module_obj_load_native_def(
 		const ow_native_func_def_t func_def = def->functions[i];
 		struct ow_cfunc_obj *const func_obj = ow_cfunc_obj_new(
 			om, self, func_def.name, func_def.func,
-			(struct ow_func_spec){func_def.argc, 0});
+			(struct ow_func_spec){func_def.argc, 0, 0});
 		struct ow_symbol_obj *const name_obj =
 			ow_symbol_obj_new(om, func_def.name, (size_t)-1);
-		ow_module_obj_set_global_y(self, name_obj, ow_object_from(func_obj));
+		ow_module_obj_set_global_y(om, self, name_obj, ow_object_from(func_obj));
 	}
 
 	ow_objmem_pop_ngc(om);
 
 	self->name = def->name ? ow_symbol_obj_new(om, def->name, (size_t)-1) : NULL;
+	if (self->name)
+		ow_objmem_write_barrier(om, ow_object_from(self), ow_object_from(self->name));
 	self->finalizer = def->finalizer;
 }
 
@@ -164,15 +169,17 @@ struct ow_object *ow_module_obj_get_global_y(
 }
 
 bool ow_module_obj_set_global(
-		struct ow_module_obj *self, size_t index, struct ow_object *value) {
+		struct ow_machine *om, struct ow_module_obj *self,
+		size_t index, struct ow_object *value) {
 	if (ow_unlikely(index >= ow_array_size(&self->globals)))
 		return false;
 	ow_array_at(&self->globals, index) = value;
+	ow_objmem_write_barrier(om, ow_object_from(self), value);
 	return true;
 }
 
 size_t ow_module_obj_set_global_y(
-		struct ow_module_obj *self,
+		struct ow_machine *om, struct ow_module_obj *self,
 		const struct ow_symbol_obj *name, struct ow_object *value) {
 	size_t index = ow_module_obj_find_global(self, name);
 	if (index == (size_t)-1) {
@@ -181,8 +188,11 @@ size_t ow_module_obj_set_global_y(
 		ow_hashmap_set(
 			&self->globals_map, &ow_symbol_obj_hashmap_funcs,
 			name, (void *)(index + 1));
+		self->pub_info.globals_version++;
+		ow_objmem_write_barrier_n(om, ow_object_from(self));
 	} else {
 		ow_array_at(&self->globals, index) = value;
+		ow_objmem_write_barrier(om, ow_object_from(self), value);
 	}
 	return index;
 }
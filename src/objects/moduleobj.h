@@ -3,6 +3,9 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "object_util.h"
+#include <utilities/attributes.h>
+
 struct ow_machine;
 struct ow_native_module_def;
 struct ow_object;
@@ -28,10 +31,12 @@ struct ow_object *ow_module_obj_get_global_y(
 	const struct ow_module_obj *self, const struct ow_symbol_obj *name);
 /// Set global by index. If not exists, return false.
 bool ow_module_obj_set_global(
-	struct ow_module_obj *self, size_t index, struct ow_object *value);
+	struct ow_machine *om, struct ow_module_obj *self,
+	size_t index, struct ow_object *value);
 /// Set or add global by name. Return its index.
 size_t ow_module_obj_set_global_y(
-	struct ow_module_obj *self, const struct ow_symbol_obj *name, struct ow_object *value);
+	struct ow_machine *om, struct ow_module_obj *self,
+	const struct ow_symbol_obj *name, struct ow_object *value);
 /// Get number of global variables.
 size_t ow_module_obj_global_count(const struct ow_module_obj *self);
 /// View each global variable.
@@ -41,3 +46,21 @@ int ow_module_obj_foreach_global(
 	void *arg);
 /// Store a handle to a dynamic library and close it when finalizing.
 void ow_module_obj_keep_dynlib(struct ow_module_obj *self, void *lib_handle);
+/// Get a number that changes whenever a new global variable is added.
+/// Indices of existing global variables never change.
+ow_static_forceinline size_t ow_module_obj_globals_version(const struct ow_module_obj *self);
+
+struct ow_module_obj_pub_info {
+	size_t globals_version;
+};
+
+ow_static_forceinline const struct ow_module_obj_pub_info *ow_module_obj_pub_info(
+		const struct ow_module_obj *self) {
+	return (const struct ow_module_obj_pub_info *)
+		((const unsigned char *)self + OW_OBJECT_SIZE);
+}
+
+ow_static_forceinline size_t ow_module_obj_globals_version(
+		const struct ow_module_obj *self) {
+	return ow_module_obj_pub_info(self)->globals_version;
+}
@@ -2,6 +2,8 @@
 
 #include <ow.h>
 
+#include "classobj.h"
+
 struct ow_machine;
 struct ow_module_obj;
 struct ow_object;
@@ -13,4 +15,6 @@ struct ow_native_class_def_ex {
 	void (*finalizer)(struct ow_machine *, struct ow_object *);
 	void (*gc_marker)(struct ow_machine *, struct ow_object *);
 	bool extended;
+	bool concurrent_finalizer; // See `ow_class_obj_pub_info`.
+	const ow_class_op_native_t *op_natives; // Optional. Indexed by `enum ow_class_op`.
 };
@@ -0,0 +1,532 @@
+#include "objalloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <utilities/bits.h>
+#include <utilities/malloc.h>
+
+static_assert(!(OW_OBJALLOC_BLOCK_SIZE & (OW_OBJALLOC_BLOCK_SIZE - 1)), "");
+static_assert(OW_OBJALLOC_BLOCK_SIZE <= (1 << 14), "ow_objalloc_cell_index()");
+
+/// Cell sizes of the size classes.
+static const uint16_t class_cell_sizes[OW_OBJALLOC_CLASS_COUNT] = {
+	16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128,
+	160, 192, 224, 256, 320, 384, 448, 512,
+};
+
+static_assert(OW_OBJALLOC_SMALL_MAX == 512, "class_cell_sizes");
+
+static void block_list_add(
+		struct ow_objalloc_block **list, struct ow_objalloc_block *block) {
+	block->prev = NULL;
+	block->next = *list;
+	if (block->next)
+		block->next->prev = block;
+	*list = block;
+}
+
+static void block_list_remove(
+		struct ow_objalloc_block **list, struct ow_objalloc_block *block) {
+	if (block->prev)
+		block->prev->next = block->next;
+	else
+		*list = block->next;
+	if (block->next)
+		block->next->prev = block->prev;
+}
+
+static void block_del(struct ow_objalloc *alloc, struct ow_objalloc_block *block) {
+	ow_aligned_free(alloc->allocator, block, OW_OBJALLOC_BLOCK_SIZE, OW_OBJALLOC_BLOCK_SIZE);
+}
+
+static void block_list_del_all(struct ow_objalloc *alloc, struct ow_objalloc_block *list) {
+	while (list) {
+		struct ow_objalloc_block *const next = list->next;
+		block_del(alloc, list);
+		list = next;
+	}
+}
+
+ow_forceinline static void *block_cell(struct ow_objalloc_block *block, size_t index) {
+	return (unsigned char *)block + OW_OBJALLOC_BLOCK_DATA_OFFSET + index * block->cell_size;
+}
+
+static struct ow_objalloc_block *block_new(
+		struct ow_objalloc *alloc, size_t size_class, size_t cell_size) {
+	struct ow_objalloc_block *const block = ow_aligned_alloc(
+		alloc->allocator, OW_OBJALLOC_BLOCK_SIZE, OW_OBJALLOC_BLOCK_SIZE);
+	if (ow_unlikely(!block))
+		abort(); // Out of memory.
+	const size_t cell_count =
+		(OW_OBJALLOC_BLOCK_SIZE - OW_OBJALLOC_BLOCK_DATA_OFFSET) / cell_size;
+	assert(cell_count <= OW_OBJALLOC_BITMAP_WORDS * 64);
+	block->used_count = 0;
+	block->cell_count = (uint32_t)cell_count;
+	block->cell_size = (uint32_t)cell_size;
+	block->cell_index_mul = (uint32_t)((65536 + cell_size - 1) / cell_size);
+	block->size_class = (uint8_t)size_class;
+	block->state = OW_OBJALLOC_BLOCK_AVAILABLE;
+	for (size_t i = 0; i < OW_OBJALLOC_BITMAP_WORDS; i++) {
+		block->mark_bits[i] = 0;
+		block->finalize_bits[i] = 0;
+	}
+
+	// Thread the cells in address order.
+	unsigned char *const first_cell = block_cell(block, 0);
+	unsigned char *const last_cell = block_cell(block, cell_count - 1);
+	for (unsigned char *p = first_cell; p < last_cell; p += cell_size)
+		*(void **)p = p + cell_size;
+	*(void **)last_cell = NULL;
+	block->free_list = first_cell;
+
+	return block;
+}
+
+/// Finalize unmarked cells in a block, and reclaim them unless the finalization
+/// is deferred. Marks are kept.
+static void block_sweep(struct ow_objalloc *alloc, struct ow_objalloc_block *block) {
+	assert(block->state == OW_OBJALLOC_BLOCK_UNSWEPT);
+	for (size_t i = 0; i < OW_OBJALLOC_BITMAP_WORDS; i++) {
+		for (uint64_t dead = block->finalize_bits[i] & ~block->mark_bits[i];
+				dead; dead &= dead - 1) {
+			const size_t bit_index = ow_bits_ctz64(dead);
+			if (alloc->finalize(alloc->finalize_ctx, block_cell(block, i * 64 + bit_index)))
+				block->finalize_bits[i] &= ~(UINT64_C(1) << bit_index);
+		}
+	}
+	// Thread free cells in address order.
+	void *free_list = NULL, **free_list_tail = &free_list;
+	size_t used_count = 0;
+	const size_t cell_count = block->cell_count;
+	for (size_t i = 0; i * 64 < cell_count; i++) {
+		const uint64_t used = block->mark_bits[i] | block->finalize_bits[i];
+		used_count += ow_bits_popcount64(used);
+		uint64_t free_bits = ~used;
+		if (cell_count - i * 64 < 64)
+			free_bits &= (UINT64_C(1) << (cell_count - i * 64)) - 1;
+		for (; free_bits; free_bits &= free_bits - 1) {
+			void *const cell = block_cell(block, i * 64 + ow_bits_ctz64(free_bits));
+			*free_list_tail = cell;
+			free_list_tail = cell;
+		}
+	}
+	*free_list_tail = NULL;
+	block->free_list = free_list;
+	block->used_count = (uint32_t)used_count;
+}
+
+/// Put a swept block into a list according to its usage. Delete it if it is
+/// empty and there are other available blocks.
+static void block_place(
+		struct ow_objalloc *alloc, struct ow_objalloc_class *cls,
+		struct ow_objalloc_block *block) {
+	if (!block->free_list) {
+		block->state = OW_OBJALLOC_BLOCK_FULL;
+		block_list_add(&cls->full, block);
+	} else if (!block->used_count && cls->available) {
+		block_del(alloc, block);
+		alloc->block_count--;
+	} else {
+		block->state = OW_OBJALLOC_BLOCK_AVAILABLE;
+		block_list_add(&cls->available, block);
+	}
+}
+
+static void block_list_place_all(
+		struct ow_objalloc *alloc, struct ow_objalloc_class *cls,
+		struct ow_objalloc_block *list) {
+	while (list) {
+		struct ow_objalloc_block *const next = list->next;
+		assert(list->state == OW_OBJALLOC_BLOCK_SWEPT);
+		block_place(alloc, cls, list);
+		list = next;
+	}
+}
+
+void ow_objalloc_init(struct ow_objalloc *alloc, const struct ow_allocator *allocator) {
+	for (size_t i = 0; i < OW_OBJALLOC_CLASS_COUNT; i++) {
+		struct ow_objalloc_class *const cls = &alloc->classes[i];
+		cls->available = NULL;
+		cls->full = NULL;
+		cls->unswept = NULL;
+		cls->swept = NULL;
+		cls->cell_size = class_cell_sizes[i];
+	}
+	size_t class_index = 0;
+	for (size_t i = 0; i <= OW_OBJALLOC_SMALL_MAX / OW_OBJALLOC_GRANULARITY; i++) {
+		while (class_cell_sizes[class_index] < i * OW_OBJALLOC_GRANULARITY)
+			class_index++;
+		alloc->size_class_table[i] = (uint8_t)class_index;
+	}
+	alloc->block_count = 0;
+	alloc->large_objects = NULL;
+	alloc->sweeping = false;
+	ow_mtx_init(&alloc->sweep_lock, ow_mtx_plain);
+	alloc->finalize = NULL;
+	alloc->finalize_ctx = NULL;
+	alloc->evacuated = NULL;
+	alloc->marked_cell_count = 0;
+	alloc->marked_block_capacity = 0;
+	alloc->allocator = allocator;
+}
+
+void ow_objalloc_fini(struct ow_objalloc *alloc) {
+	for (size_t i = 0; i < OW_OBJALLOC_CLASS_COUNT; i++) {
+		struct ow_objalloc_class *const cls = &alloc->classes[i];
+		block_list_del_all(alloc, cls->available);
+		block_list_del_all(alloc, cls->full);
+		block_list_del_all(alloc, cls->unswept);
+		block_list_del_all(alloc, cls->swept);
+		cls->available = NULL;
+		cls->full = NULL;
+		cls->unswept = NULL;
+		cls->swept = NULL;
+	}
+	block_list_del_all(alloc, alloc->evacuated);
+	alloc->evacuated = NULL;
+	alloc->block_count = 0;
+	alloc->sweeping = false;
+	ow_mtx_destroy(&alloc->sweep_lock);
+
+	for (struct ow_objalloc_large *large = alloc->large_objects; large; ) {
+		struct ow_objalloc_large *const next = large->next;
+		ow_free(large);
+		large = next;
+	}
+	alloc->large_objects = NULL;
+}
+
+void *_ow_objalloc_allocate_slow(
+		struct ow_objalloc *alloc, struct ow_objalloc_class *cls) {
+	struct ow_objalloc_block *block;
+	while (!(block = cls->available) && alloc->sweeping) {
+		// Take the blocks that have been swept, or sweep one.
+		ow_mtx_lock(&alloc->sweep_lock);
+		struct ow_objalloc_block *swept_list = cls->swept, *unswept_block = NULL;
+		cls->swept = NULL;
+		if (!swept_list && (unswept_block = cls->unswept))
+			block_list_remove(&cls->unswept, unswept_block);
+		ow_mtx_unlock(&alloc->sweep_lock);
+		if (swept_list) {
+			block_list_place_all(alloc, cls, swept_list);
+		} else if (unswept_block) {
+			block_sweep(alloc, unswept_block);
+			block_place(alloc, cls, unswept_block);
+		} else {
+			break;
+		}
+	}
+	if (!block) {
+		const size_t size_class = (size_t)(cls - alloc->classes);
+		block = block_new(alloc, size_class, cls->cell_size);
+		block_list_add(&cls->available, block);
+		alloc->block_count++;
+	}
+
+	void *const cell = block->free_list;
+	assert(cell);
+	block->free_list = *(void **)cell;
+	block->used_count++;
+	if (!block->free_list) {
+		assert(block->used_count == block->cell_count);
+		block_list_remove(&cls->available, block);
+		block_list_add(&cls->full, block);
+		block->state = OW_OBJALLOC_BLOCK_FULL;
+	}
+	return cell;
+}
+
+void *ow_objalloc_allocate_large(struct ow_objalloc *alloc, size_t size) {
+	struct ow_objalloc_large *const large =
+		ow_malloc(offsetof(struct ow_objalloc_large, data) + size);
+	if (ow_unlikely(!large))
+		abort(); // Out of memory.
+	large->size = size;
+	large->marked = false;
+	large->finalizable = false;
+	large->prev = NULL;
+	large->next = alloc->large_objects;
+	if (large->next)
+		large->next->prev = large;
+	alloc->large_objects = large;
+	return large->data;
+}
+
+static void block_list_clear_marks(struct ow_objalloc_block *list) {
+	for (struct ow_objalloc_block *block = list; block; block = block->next) {
+		for (size_t i = 0; i < OW_OBJALLOC_BITMAP_WORDS; i++)
+			block->mark_bits[i] = 0;
+	}
+}
+
+void ow_objalloc_clear_marks(struct ow_objalloc *alloc) {
+	for (size_t i = 0; i < OW_OBJALLOC_CLASS_COUNT; i++) {
+		struct ow_objalloc_class *const cls = &alloc->classes[i];
+		block_list_clear_marks(cls->available);
+		block_list_clear_marks(cls->full);
+		assert(!cls->unswept && !cls->swept);
+	}
+	for (struct ow_objalloc_large *large = alloc->large_objects; large; large = large->next)
+		large->marked = false;
+}
+
+static void block_list_foreach_marked(
+		struct ow_objalloc_block *list, void (*func)(void *ctx, void *ptr), void *ctx) {
+	for (struct ow_objalloc_block *block = list; block; block = block->next) {
+		for (size_t i = 0; i < OW_OBJALLOC_BITMAP_WORDS; i++) {
+			for (uint64_t marks = block->mark_bits[i]; marks; marks &= marks - 1)
+				func(ctx, block_cell(block, i * 64 + ow_bits_ctz64(marks)));
+		}
+	}
+}
+
+void ow_objalloc_foreach_marked(
+		struct ow_objalloc *alloc, void (*func)(void *ctx, void *ptr), void *ctx) {
+	for (size_t i = 0; i < OW_OBJALLOC_CLASS_COUNT; i++) {
+		struct ow_objalloc_class *const cls = &alloc->classes[i];
+		block_list_foreach_marked(cls->available, func, ctx);
+		block_list_foreach_marked(cls->full, func, ctx);
+		block_list_foreach_marked(cls->unswept, func, ctx);
+	}
+	block_list_foreach_marked(alloc->evacuated, func, ctx);
+	for (struct ow_objalloc_large *large = alloc->large_objects; large; large = large->next) {
+		if (large->marked)
+			func(ctx, large->data);
+	}
+}
+
+bool ow_objalloc_sweep_block(struct ow_objalloc *alloc) {
+	struct ow_objalloc_class *cls = NULL;
+	struct ow_objalloc_block *block = NULL;
+	ow_mtx_lock(&alloc->sweep_lock);
+	for (size_t i = 0; i < OW_OBJALLOC_CLASS_COUNT; i++) {
+		if ((block = alloc->classes[i].unswept)) {
+			cls = &alloc->classes[i];
+			block_list_remove(&cls->unswept, block);
+			break;
+		}
+	}
+	ow_mtx_unlock(&alloc->sweep_lock);
+	if (!block)
+		return false;
+
+	block_sweep(alloc, block);
+	block->state = OW_OBJALLOC_BLOCK_SWEPT;
+	ow_mtx_lock(&alloc->sweep_lock);
+	block_list_add(&cls->swept, block);
+	ow_mtx_unlock(&alloc->sweep_lock);
+	return true;
+}
+
+void ow_objalloc_take_swept(struct ow_objalloc *alloc) {
+	if (!alloc->sweeping)
+		return;
+	bool sweeping = false;
+	for (size_t i = 0; i < OW_OBJALLOC_CLASS_COUNT; i++) {
+		struct ow_objalloc_class *const cls = &alloc->classes[i];
+		struct ow_objalloc_block *const swept_list = cls->swept;
+		cls->swept = NULL;
+		block_list_place_all(alloc, cls, swept_list);
+		if (cls->unswept)
+			sweeping = true;
+	}
+	alloc->sweeping = sweeping;
+}
+
+void ow_objalloc_finish_sweep(struct ow_objalloc *alloc) {
+	while (ow_objalloc_sweep_block(alloc))
+		;
+	ow_objalloc_take_swept(alloc);
+	assert(!alloc->sweeping);
+}
+
+/// Return number of marked cells in a block.
+static size_t block_marked_count(const struct ow_objalloc_block *block) {
+	size_t marked_count = 0;
+	for (size_t i = 0; i < OW_OBJALLOC_BITMAP_WORDS; i++)
+		marked_count += ow_bits_popcount64(block->mark_bits[i]);
+	return marked_count;
+}
+
+size_t ow_objalloc_collect(
+		struct ow_objalloc *alloc, bool (*finalize)(void *ctx, void *ptr), void *ctx) {
+	assert(!alloc->evacuated);
+	alloc->finalize = finalize;
+	alloc->finalize_ctx = ctx;
+	size_t marked_size = 0;
+	alloc->marked_cell_count = 0;
+	alloc->marked_block_capacity = 0;
+
+	for (size_t i = 0; i < OW_OBJALLOC_CLASS_COUNT; i++) {
+		struct ow_objalloc_class *const cls = &alloc->classes[i];
+		assert(!cls->swept);
+		for (struct ow_objalloc_block *block = cls->unswept; block; block = block->next) {
+			const size_t marked_count = block_marked_count(block);
+			marked_size += marked_count * block->cell_size;
+			if (marked_count) {
+				alloc->marked_cell_count += marked_count;
+				alloc->marked_block_capacity += block->cell_count;
+			}
+		}
+		struct ow_objalloc_block *const lists[2] = {cls->available, cls->full};
+		cls->available = NULL;
+		cls->full = NULL;
+		for (size_t j = 0; j < 2; j++) {
+			for (struct ow_objalloc_block *block = lists[j]; block; ) {
+				struct ow_objalloc_block *const next = block->next;
+				const size_t marked_count = block_marked_count(block);
+				marked_size += marked_count * block->cell_size;
+				if (marked_count) {
+					alloc->marked_cell_count += marked_count;
+					alloc->marked_block_capacity += block->cell_count;
+				}
+				if (marked_count == block->used_count) {
+					// No dead cells. Typical for old blocks after a minor GC.
+					block_list_add(j ? &cls->full : &cls->available, block);
+				} else {
+					block->state = OW_OBJALLOC_BLOCK_UNSWEPT;
+					block_list_add(&cls->unswept, block);
+				}
+				block = next;
+			}
+		}
+		if (cls->unswept)
+			alloc->sweeping = true;
+	}
+
+	for (struct ow_objalloc_large *large = alloc->large_objects; large; ) {
+		struct ow_objalloc_large *const next = large->next;
+		if (large->marked || (large->finalizable && !finalize(ctx, large->data))) {
+			// Alive, or finalization deferred.
+			marked_size += large->size;
+		} else {
+			if (large->prev)
+				large->prev->next = next;
+			else
+				alloc->large_objects = next;
+			if (next)
+				next->prev = large->prev;
+			ow_free(large);
+		}
+		large = next;
+	}
+
+	return marked_size;
+}
+
+static int block_used_count_compare(const void *lhs, const void *rhs) {
+	const uint32_t a = (*(struct ow_objalloc_block *const *)lhs)->used_count;
+	const uint32_t b = (*(struct ow_objalloc_block *const *)rhs)->used_count;
+	return a < b ? -1 : a > b;
+}
+
+/// Move marked cells of an evacuated block into other blocks of the same class.
+static size_t block_evacuate(
+		struct ow_objalloc *alloc, struct ow_objalloc_block *block,
+		bool (*movable)(void *ctx, void *ptr), void (*forward)(void *ctx, void *from, void *to),
+		void *ctx) {
+	assert(block->state == OW_OBJALLOC_BLOCK_EVACUATED);
+	const size_t cell_size = block->cell_size;
+	size_t moved_count = 0;
+	for (size_t i = 0; i < OW_OBJALLOC_BITMAP_WORDS; i++) {
+		for (uint64_t marks = block->mark_bits[i]; marks; marks &= marks - 1) {
+			const size_t bit_index = ow_bits_ctz64(marks);
+			const uint64_t bit = UINT64_C(1) << bit_index;
+			void *const from = block_cell(block, i * 64 + bit_index);
+			if (!movable(ctx, from))
+				continue;
+			size_t to_cell_size;
+			void *const to = ow_objalloc_allocate(alloc, cell_size, &to_cell_size);
+			assert(to_cell_size == cell_size);
+			assert(ow_objalloc_block_of(to)->state != OW_OBJALLOC_BLOCK_EVACUATED);
+			memcpy(to, from, cell_size);
+			ow_objalloc_mark(to, false);
+			if (block->finalize_bits[i] & bit) {
+				ow_objalloc_set_finalizable(to, false);
+				block->finalize_bits[i] &= ~bit;
+			}
+			block->mark_bits[i] &= ~bit;
+			forward(ctx, from, to);
+			moved_count++;
+		}
+	}
+	return moved_count;
+}
+
+size_t ow_objalloc_evacuate(
+		struct ow_objalloc *alloc, bool (*finalize)(void *ctx, void *ptr),
+		bool (*movable)(void *ctx, void *ptr), void (*forward)(void *ctx, void *from, void *to),
+		void *ctx) {
+	assert(!alloc->sweeping && !alloc->evacuated);
+	alloc->finalize = finalize;
+	alloc->finalize_ctx = ctx;
+
+	struct ow_objalloc_block **const blocks =
+		ow_malloc(sizeof(struct ow_objalloc_block *) * (alloc->block_count + 1));
+	size_t moved_count = 0;
+
+	for (size_t i = 0; i < OW_OBJALLOC_CLASS_COUNT; i++) {
+		struct ow_objalloc_class *const cls = &alloc->classes[i];
+		assert(!cls->unswept && !cls->swept);
+
+		// Sweep all the blocks, so that used counts tell how many cells are alive.
+		size_t block_count = 0, free_count = 0;
+		struct ow_objalloc_block *const lists[2] = {cls->available, cls->full};
+		cls->available = NULL;
+		cls->full = NULL;
+		for (size_t j = 0; j < 2; j++) {
+			for (struct ow_objalloc_block *block = lists[j]; block; block = block->next) {
+				block->state = OW_OBJALLOC_BLOCK_UNSWEPT;
+				block_sweep(alloc, block);
+				block->state = OW_OBJALLOC_BLOCK_SWEPT;
+				free_count += block->cell_count - block->used_count;
+				assert(block_count < alloc->block_count);
+				blocks[block_count++] = block;
+			}
+		}
+
+		// Choose the sparsest blocks, as long as the others can hold their cells.
+		qsort(blocks, block_count, sizeof blocks[0], block_used_count_compare);
+		size_t evacuated_count = 0, evacuated_used_count = 0;
+		for (; evacuated_count < block_count; evacuated_count++) {
+			struct ow_objalloc_block *const block = blocks[evacuated_count];
+			if (!block->used_count)
+				continue; // Will be deleted.
+			if (block->used_count > block->cell_count / 2)
+				break;
+			const size_t block_free_count = block->cell_count - block->used_count;
+			if (evacuated_used_count + block->used_count > free_count - block_free_count)
+				break;
+			free_count -= block_free_count;
+			evacuated_used_count += block->used_count;
+		}
+		for (size_t j = 0; j < block_count; j++) {
+			struct ow_objalloc_block *const block = blocks[j];
+			if (j < evacuated_count && block->used_count) {
+				block->state = OW_OBJALLOC_BLOCK_EVACUATED;
+				block_list_add(&alloc->evacuated, block);
+			} else {
+				block_place(alloc, cls, block);
+			}
+		}
+	}
+
+	ow_free(blocks);
+
+	for (struct ow_objalloc_block *block = alloc->evacuated; block; block = block->next)
+		moved_count += block_evacuate(alloc, block, movable, forward, ctx);
+	return moved_count;
+}
+
+void ow_objalloc_finish_evacuation(struct ow_objalloc *alloc) {
+	for (struct ow_objalloc_block *block = alloc->evacuated; block; ) {
+		struct ow_objalloc_block *const next = block->next;
+		// Moved cells are neither marked nor finalizable now.
+		block->state = OW_OBJALLOC_BLOCK_UNSWEPT;
+		block_sweep(alloc, block);
+		block_place(alloc, &alloc->classes[block->size_class], block);
+		block = next;
+	}
+	alloc->evacuated = NULL;
+}
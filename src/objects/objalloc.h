@@ -0,0 +1,281 @@
+#pragma once
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#	include <compat/msvc_stdatomic.h>
+#else
+#	include <stdatomic.h>
+#endif
+
+#include <utilities/attributes.h>
+#include <utilities/thread.h>
+
+struct ow_allocator;
+
+/// Size of a block, which is also its alignment.
+#define OW_OBJALLOC_BLOCK_SIZE  (16 * 1024)
+/// Max size of an object that can be allocated from blocks.
+#define OW_OBJALLOC_SMALL_MAX   512
+/// Size classes are defined for sizes rounded up to multiples of this granularity.
+#define OW_OBJALLOC_GRANULARITY 8
+/// Number of size classes.
+#define OW_OBJALLOC_CLASS_COUNT 19
+/// Number of words in a bitmap of a block, which has a bit for each cell.
+#define OW_OBJALLOC_BITMAP_WORDS (OW_OBJALLOC_BLOCK_SIZE / 16 / 64)
+/// Offset of the first cell in a block.
+#define OW_OBJALLOC_BLOCK_DATA_OFFSET \
+	((sizeof(struct ow_objalloc_block) + 15) / 16 * 16)
+
+/// State of a block.
+enum ow_objalloc_block_state {
+	OW_OBJALLOC_BLOCK_AVAILABLE, ///< Swept and has free cells.
+	OW_OBJALLOC_BLOCK_FULL, ///< Swept and has no free cells.
+	OW_OBJALLOC_BLOCK_UNSWEPT, ///< Dead cells have not been reclaimed since last GC.
+	OW_OBJALLOC_BLOCK_SWEPT, ///< Swept, but not yet put into the available or full list.
+	OW_OBJALLOC_BLOCK_EVACUATED, ///< Objects are being moved out. See `ow_objalloc_evacuate()`.
+};
+
+/// A block of memory, holding cells of the same size.
+struct ow_objalloc_block {
+	struct ow_objalloc_block *prev; ///< Previous block in the list of class.
+	struct ow_objalloc_block *next; ///< Next block in the list of class.
+	void *free_list; ///< Free cells, linked by their first words.
+	uint32_t used_count; ///< Number of cells in use, not counting dead ones before sweeping.
+	uint32_t cell_count; ///< Number of cells in the block.
+	uint32_t cell_size; ///< Size of each cell.
+	uint32_t cell_index_mul; ///< See `ow_objalloc_cell_index()`.
+	uint8_t size_class; ///< Index of the size class.
+	uint8_t state; ///< See `enum ow_objalloc_block_state`.
+	uint64_t mark_bits[OW_OBJALLOC_BITMAP_WORDS]; ///< GC marks of cells.
+	uint64_t finalize_bits[OW_OBJALLOC_BITMAP_WORDS]; ///< Cells that need finalizing.
+};
+
+/// Blocks of a size class.
+struct ow_objalloc_class {
+	struct ow_objalloc_block *available; ///< Blocks that have free cells. The first one is used first.
+	struct ow_objalloc_block *full; ///< Blocks that have no free cells.
+	struct ow_objalloc_block *unswept; ///< Blocks to sweep before allocating from them.
+	struct ow_objalloc_block *swept; ///< Blocks that have been swept by `ow_objalloc_sweep_block()`.
+	size_t cell_size;
+};
+
+/// Header of a large object, which is allocated individually.
+struct ow_objalloc_large {
+	struct ow_objalloc_large *prev;
+	struct ow_objalloc_large *next;
+	size_t size; ///< Size of the object.
+	bool marked;
+	bool finalizable;
+	_Alignas(16) unsigned char data[];
+};
+
+/// Allocator for objects. Small objects are allocated from blocks of same-sized
+/// cells, where each size class has its own blocks; GC marks are stored in bitmaps
+/// of blocks. Large objects are allocated individually, each with a header.
+///
+/// After marking, `ow_objalloc_collect()` finalizes and frees dead large objects,
+/// and leaves the blocks to be swept. Blocks are swept by `ow_objalloc_sweep_block()`,
+/// which can run on other threads, or by the allocating thread when it needs one.
+/// Sweeping a block finalizes its dead cells and reclaims them. A finalizer can be
+/// deferred, leaving the cell in use until `ow_objalloc_clear_finalizable()` is called.
+/// Marks are sticky: they are kept until `ow_objalloc_clear_marks()` is called,
+/// so that objects that survived a GC can be told apart from newly allocated ones.
+struct ow_objalloc {
+	struct ow_objalloc_class classes[OW_OBJALLOC_CLASS_COUNT];
+	uint8_t size_class_table[OW_OBJALLOC_SMALL_MAX / OW_OBJALLOC_GRANULARITY + 1];
+	size_t block_count;
+	struct ow_objalloc_large *large_objects;
+	bool sweeping; ///< Whether there are blocks in the unswept or swept lists.
+	ow_mtx_t sweep_lock; ///< Protects the unswept and swept lists while sweeping.
+	bool (*finalize)(void *ctx, void *ptr); ///< See `ow_objalloc_collect()`.
+	void *finalize_ctx;
+	struct ow_objalloc_block *evacuated; ///< Blocks whose objects have been moved out.
+	size_t marked_cell_count; ///< Number of marked cells found by last `ow_objalloc_collect()`.
+	size_t marked_block_capacity; ///< Number of cells in the blocks that have marked cells.
+	const struct ow_allocator *allocator; ///< Where blocks come from. See `ow_aligned_alloc()`.
+};
+
+/// Initialize the allocator, which gets blocks from `allocator` (NULL for the C library).
+void ow_objalloc_init(struct ow_objalloc *alloc, const struct ow_allocator *allocator);
+/// Release all blocks and large objects. All objects become invalid.
+void ow_objalloc_fini(struct ow_objalloc *alloc);
+/// Allocate a cell that can hold `size` bytes, where `size` must not be greater
+/// than `OW_OBJALLOC_SMALL_MAX`. Return the cell, whose size is stored to
+/// `*cell_size_out`.
+ow_static_forceinline void *ow_objalloc_allocate(
+	struct ow_objalloc *alloc, size_t size, size_t *cell_size_out);
+/// Allocate memory for a large object.
+void *ow_objalloc_allocate_large(struct ow_objalloc *alloc, size_t size);
+/// Get the block that a cell belongs to.
+ow_static_forceinline struct ow_objalloc_block *ow_objalloc_block_of(const void *ptr);
+/// Get the header of a large object.
+ow_static_forceinline struct ow_objalloc_large *ow_objalloc_large_of(const void *ptr);
+/// Get index of a cell in its block.
+ow_static_forceinline size_t ow_objalloc_cell_index(
+	const struct ow_objalloc_block *block, const void *ptr);
+/// Set the GC mark of an object. Return false if it has already been marked.
+ow_static_forceinline bool ow_objalloc_mark(void *ptr, bool is_large);
+/// Like `ow_objalloc_mark()`, but safe to be called by multiple threads at a time.
+ow_static_forceinline bool ow_objalloc_mark_atomic(void *ptr, bool is_large);
+/// Check the GC mark of an object.
+ow_static_forceinline bool ow_objalloc_is_marked(const void *ptr, bool is_large);
+/// Require the object to be finalized before its memory is reclaimed.
+ow_static_forceinline void ow_objalloc_set_finalizable(void *ptr, bool is_large);
+/// Tell that a dead object, whose finalization was deferred, has been finalized.
+/// Its memory will be reclaimed after next GC.
+ow_static_forceinline void ow_objalloc_clear_finalizable(void *ptr, bool is_large);
+/// Clear marks of all objects.
+void ow_objalloc_clear_marks(struct ow_objalloc *alloc);
+/// Call `func()` for each marked object. Objects marked during the iteration
+/// may or may not be visited.
+void ow_objalloc_foreach_marked(
+	struct ow_objalloc *alloc, void (*func)(void *ctx, void *ptr), void *ctx);
+/// Finish a GC after marking. Free unmarked large objects, and leave all the blocks
+/// to be swept. Marks are not cleared. Return total size of marked objects.
+/// Function `finalize()` is called for each unmarked object that needs finalizing,
+/// here or when sweeping, probably on another thread. It returns false to defer
+/// the finalization. Blocks left unswept since last GC stay unswept; no other
+/// thread may be sweeping.
+size_t ow_objalloc_collect(
+	struct ow_objalloc *alloc, bool (*finalize)(void *ctx, void *ptr), void *ctx);
+/// Sweep an unswept block. Return false if there are none. It can be called by
+/// several threads at the same time, while the allocating thread keeps allocating.
+bool ow_objalloc_sweep_block(struct ow_objalloc *alloc);
+/// Make blocks that have been swept by `ow_objalloc_sweep_block()` available.
+/// It must not be called while another thread is sweeping.
+void ow_objalloc_take_swept(struct ow_objalloc *alloc);
+/// Sweep the rest of the blocks, and call `ow_objalloc_take_swept()`.
+void ow_objalloc_finish_sweep(struct ow_objalloc *alloc);
+/// Check whether there are blocks that have not been swept since last GC.
+ow_static_forceinline bool ow_objalloc_sweeping(const struct ow_objalloc *alloc) {
+	return alloc->sweeping;
+}
+/// Get fragmentation of blocks measured by last `ow_objalloc_collect()`, which is
+/// the percentage of cells that are not marked in blocks that have marked cells.
+ow_static_forceinline unsigned int ow_objalloc_fragmentation(const struct ow_objalloc *alloc) {
+	if (!alloc->marked_block_capacity)
+		return 0;
+	return (unsigned int)
+		(100 - alloc->marked_cell_count * 100 / alloc->marked_block_capacity);
+}
+/// Move marked objects out of sparse blocks into denser ones after marking. All the
+/// blocks are swept first, calling `finalize()` like `ow_objalloc_collect()`. A
+/// marked object is moved if `movable()` returns true, and then `forward()` is
+/// called with the old and new addresses. The old cells are unmarked but kept
+/// until `ow_objalloc_finish_evacuation()`, so that references can be updated
+/// in between. Sweeping must have been finished. Return number of moved objects.
+size_t ow_objalloc_evacuate(
+	struct ow_objalloc *alloc, bool (*finalize)(void *ctx, void *ptr),
+	bool (*movable)(void *ctx, void *ptr), void (*forward)(void *ctx, void *from, void *to),
+	void *ctx);
+/// Reclaim the cells that objects were moved out of by `ow_objalloc_evacuate()`.
+void ow_objalloc_finish_evacuation(struct ow_objalloc *alloc);
+
+void *_ow_objalloc_allocate_slow(struct ow_objalloc *alloc, struct ow_objalloc_class *cls);
+
+ow_static_forceinline struct ow_objalloc_block *ow_objalloc_block_of(const void *ptr) {
+	return (struct ow_objalloc_block *)
+		((uintptr_t)ptr & ~(uintptr_t)(OW_OBJALLOC_BLOCK_SIZE - 1));
+}
+
+ow_static_forceinline struct ow_objalloc_large *ow_objalloc_large_of(const void *ptr) {
+	return (struct ow_objalloc_large *)
+		((unsigned char *)ptr - offsetof(struct ow_objalloc_large, data));
+}
+
+ow_static_forceinline size_t ow_objalloc_cell_index(
+		const struct ow_objalloc_block *block, const void *ptr) {
+	// Offsets are less than 2^14 and cell sizes are at least 16, so dividing by
+	// multiplying with ceil(2^16 / cell_size) and shifting gives exact results.
+	const size_t offset = (size_t)((const unsigned char *)ptr -
+		((const unsigned char *)block + OW_OBJALLOC_BLOCK_DATA_OFFSET));
+	return (offset * block->cell_index_mul) >> 16;
+}
+
+ow_static_forceinline void *ow_objalloc_allocate(
+		struct ow_objalloc *alloc, size_t size, size_t *cell_size_out) {
+	assert(size && size <= OW_OBJALLOC_SMALL_MAX);
+	struct ow_objalloc_class *const cls = &alloc->classes[
+		alloc->size_class_table[(size + OW_OBJALLOC_GRANULARITY - 1) / OW_OBJALLOC_GRANULARITY]];
+	*cell_size_out = cls->cell_size;
+	struct ow_objalloc_block *const block = cls->available;
+	if (ow_likely(block)) {
+		void *const cell = block->free_list;
+		void *const next_cell = *(void **)cell;
+		if (ow_likely(next_cell)) {
+			block->free_list = next_cell;
+			block->used_count++;
+			return cell;
+		}
+	}
+	return _ow_objalloc_allocate_slow(alloc, cls);
+}
+
+ow_static_forceinline bool ow_objalloc_mark(void *ptr, bool is_large) {
+	if (ow_unlikely(is_large)) {
+		struct ow_objalloc_large *const large = ow_objalloc_large_of(ptr);
+		if (large->marked)
+			return false;
+		large->marked = true;
+		return true;
+	}
+	struct ow_objalloc_block *const block = ow_objalloc_block_of(ptr);
+	const size_t index = ow_objalloc_cell_index(block, ptr);
+	uint64_t *const word = &block->mark_bits[index / 64];
+	const uint64_t bit = UINT64_C(1) << (index % 64);
+	if (*word & bit)
+		return false;
+	*word |= bit;
+	return true;
+}
+
+ow_static_forceinline bool ow_objalloc_mark_atomic(void *ptr, bool is_large) {
+	if (ow_unlikely(is_large)) {
+		struct ow_objalloc_large *const large = ow_objalloc_large_of(ptr);
+		static_assert(sizeof large->marked == sizeof(atomic_bool), "");
+		if (atomic_load((atomic_bool *)&large->marked))
+			return false;
+		return !atomic_exchange((atomic_bool *)&large->marked, true);
+	}
+	struct ow_objalloc_block *const block = ow_objalloc_block_of(ptr);
+	const size_t index = ow_objalloc_cell_index(block, ptr);
+	atomic_uint_least64_t *const word =
+		(atomic_uint_least64_t *)&block->mark_bits[index / 64];
+	const uint64_t bit = UINT64_C(1) << (index % 64);
+	// Test before setting, which is much cheaper when it has been marked.
+	if (atomic_load(word) & bit)
+		return false;
+	return !(atomic_fetch_or(word, bit) & bit);
+}
+
+ow_static_forceinline bool ow_objalloc_is_marked(const void *ptr, bool is_large) {
+	if (ow_unlikely(is_large))
+		return ow_objalloc_large_of(ptr)->marked;
+	const struct ow_objalloc_block *const block = ow_objalloc_block_of(ptr);
+	const size_t index = ow_objalloc_cell_index(block, ptr);
+	return block->mark_bits[index / 64] & (UINT64_C(1) << (index % 64));
+}
+
+ow_static_forceinline void ow_objalloc_set_finalizable(void *ptr, bool is_large) {
+	if (ow_unlikely(is_large)) {
+		ow_objalloc_large_of(ptr)->finalizable = true;
+		return;
+	}
+	struct ow_objalloc_block *const block = ow_objalloc_block_of(ptr);
+	const size_t index = ow_objalloc_cell_index(block, ptr);
+	block->finalize_bits[index / 64] |= UINT64_C(1) << (index % 64);
+}
+
+ow_static_forceinline void ow_objalloc_clear_finalizable(void *ptr, bool is_large) {
+	if (ow_unlikely(is_large)) {
+		ow_objalloc_large_of(ptr)->finalizable = false;
+		return;
+	}
+	struct ow_objalloc_block *const block = ow_objalloc_block_of(ptr);
+	const size_t index = ow_objalloc_cell_index(block, ptr);
+	block->finalize_bits[index / 64] &= ~(UINT64_C(1) << (index % 64));
+}
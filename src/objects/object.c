@@ -4,9 +4,13 @@
 
 #include "classes.h"
 #include "classes_util.h"
+#include "classobj.h"
+#include "floatobj.h"
 #include "intobj.h"
 #include "natives.h"
 #include "object_util.h"
+#include "stringobj.h"
+#include "symbolobj.h"
 #include <machine/globals.h>
 #include <machine/invoke.h>
 #include <machine/machine.h>
@@ -30,14 +34,31 @@ static bool _ow_object_hashmap_funcs_key_equal(
 	struct ow_object *const lhs = (void *)key_new, *const rhs = (void *)key_stored;
 	if (ow_unlikely(ow_smallint_check(lhs) && ow_smallint_check(rhs)))
 		return ow_smallint_from_ptr(lhs) == ow_smallint_from_ptr(rhs);
+	struct ow_builtin_classes *const bic = om->builtin_classes;
+	struct ow_class_obj *const lhs_class = ow_builtin_classes_class_of(bic, lhs);
+	struct ow_class_obj *const rhs_class = ow_builtin_classes_class_of(bic, rhs);
+	if (lhs_class == bic->string) {
+		return rhs_class == bic->string && ow_string_obj_equal(
+			ow_object_cast(lhs, struct ow_string_obj), ow_object_cast(rhs, struct ow_string_obj));
+	}
+	if (lhs_class == bic->symbol || lhs_class == bic->nil || lhs_class == bic->bool_)
+		return false; // Equal only if identical.
+	if (lhs_class == bic->float_ && rhs_class == bic->float_)
+		return ow_float_obj_or_flonum_value(lhs) == ow_float_obj_or_flonum_value(rhs);
+	struct ow_object *argv[2] = {lhs, rhs};
+	const ow_class_op_native_t cmp_native = ow_class_obj_op_native(lhs_class, OW_CLASS_OP_cmp);
+	struct ow_object *const cmp_meth = ow_class_obj_op_method(lhs_class, OW_CLASS_OP_cmp);
 	struct ow_object *cmp_res;
-	const int cmp_status = ow_machine_call_method(
-		om, om->common_symbols->cmp, 2,
-		(struct ow_object *[]){om->globals->value_nil, lhs, rhs}, &cmp_res);
+	const int cmp_status =
+		cmp_native ? cmp_native(om, argv, &cmp_res) :
+		cmp_meth ? ow_machine_call(om, cmp_meth, 2, argv, &cmp_res) :
+		ow_machine_call_method(om, om->common_symbols->cmp, 2, argv, &cmp_res);
 	if (cmp_status != 0)
 		return false; // TODO: Return an exception.
 	if (ow_smallint_check(cmp_res))
 		return ow_smallint_from_ptr(cmp_res) == 0;
+	if (ow_flonum_check(cmp_res))
+		return false;
 	if (ow_object_class(cmp_res) == om->builtin_classes->int_)
 		return ow_int_obj_value(ow_object_cast(cmp_res, struct ow_int_obj)) == 0;
 	return false;
@@ -56,13 +77,33 @@ static ow_hash_t _ow_object_hashmap_funcs_key_hash(
 #endif
 			(ow_smallint_from_ptr(val));
 	}
+	if (ow_unlikely(ow_flonum_check(val)))
+		return ow_hash_double(ow_flonum_from_ptr(val));
+	struct ow_builtin_classes *const bic = om->builtin_classes;
+	struct ow_class_obj *const val_class = ow_object_class(val);
+	if (val_class == bic->string)
+		return ow_string_obj_hash(ow_object_cast(val, struct ow_string_obj));
+	if (val_class == bic->symbol)
+		return ow_symbol_obj_hash(ow_object_cast(val, struct ow_symbol_obj));
+	if (val_class == bic->float_)
+		return ow_hash_double(ow_float_obj_value(ow_object_cast(val, struct ow_float_obj)));
+	if (val_class == bic->int_)
+		return ow_hash_int64(ow_int_obj_value(ow_object_cast(val, struct ow_int_obj)));
+	if (val_class == bic->nil || val_class == bic->bool_)
+		return val == om->globals->value_true ? 1 : 0;
+	const ow_class_op_native_t hash_native = ow_class_obj_op_native(val_class, OW_CLASS_OP_hash);
+	struct ow_object *const hash_meth = ow_class_obj_op_method(val_class, OW_CLASS_OP_hash);
 	struct ow_object *hash_res;
-	const int hash_status = ow_machine_call_method(
-		om, om->common_symbols->hash, 1, &val, &hash_res);
+	const int hash_status =
+		hash_native ? hash_native(om, &val, &hash_res) :
+		hash_meth ? ow_machine_call(om, hash_meth, 1, &val, &hash_res) :
+		ow_machine_call_method(om, om->common_symbols->hash, 1, &val, &hash_res);
 	if (hash_status != 0)
 		return 0; // TODO: Return an exception.
 	if (ow_smallint_check(hash_res))
 		return (ow_hash_t)ow_smallint_from_ptr(hash_res);
+	if (ow_flonum_check(hash_res))
+		return 0; // TODO: Return an exception.
 	if (ow_object_class(hash_res) == om->builtin_classes->int_)
 		return (ow_hash_t)ow_int_obj_value(ow_object_cast(hash_res, struct ow_int_obj));
 	return 0; // TODO: Return an exception.
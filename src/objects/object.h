@@ -1,9 +1,11 @@
 #pragma once
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h> // uintptr_t
 
+#include "flonum.h"
 #include "objmeta.h"
 #include "smallint.h"
 #include <utilities/attributes.h>
@@ -28,10 +30,16 @@ struct ow_object {
 	struct ow_object *_fields[];
 };
 
-/// Get class of an object.
+/// Check whether an object pointer is an immediate value (a small int or a flonum)
+/// instead of a pointer to an object.
+ow_static_forceinline bool ow_object_is_immediate(const struct ow_object *obj) {
+	return ow_smallint_check(obj) || ow_flonum_check(obj);
+}
+
+/// Get class of an object. The object must not be an immediate value.
 ow_static_forceinline struct ow_class_obj *ow_object_class(
 		const struct ow_object *obj) {
-	assert(!ow_smallint_check(obj));
+	assert(!ow_object_is_immediate(obj));
 	return obj->_class;
 }
 
@@ -11,17 +11,14 @@
 #	include <stdint.h>
 #endif
 
-struct ow_object;
-
-/// GC info and other data.
+/// Flags and other data.
 struct ow_object_meta {
 #if OW_WORDSIZE == 64
-	uint64_t _data;
-#	define OW_OBJMETA_NEXT_MASK    0x0000ffffffffffff
+	uint64_t _data; // The low 48 bits are unused.
 #	define OW_OBJMETA_FLAGS_SHIFT  48
 #elif OW_WORDSIZE == 32
-	struct ow_object *_next;
-	uint32_t          _flags;
+	uint32_t _unused;
+	uint32_t _flags;
 #else
 #	error "unexpected OW_WORDSIZE value"
 #endif
@@ -29,30 +26,15 @@ struct ow_object_meta {
 
 enum ow_object_meta_flag {
 	OW_OBJMETA_FLAG_EXTENDED  = 0, // Has extra fields. If set, field 0 shall be the number of actual fields (uintptr_t).
-	OW_OBJMETA_FLAG_MARKED    = 1, // GC mark.
+	OW_OBJMETA_FLAG_LARGE     = 1, // Allocated individually rather than from a block of small objects.
+	OW_OBJMETA_FLAG_REMEMBERED = 2, // In the remembered set of GC. See `ow_objmem_write_barrier()`.
+	OW_OBJMETA_FLAG_FINALIZING = 3, // Dead, and waiting for its deferred finalizer.
+	OW_OBJMETA_FLAG_PINNED    = 4, // Must not be moved by current compacting GC.
+	OW_OBJMETA_FLAG_FORWARDED = 5, // Moved by compaction; the class field is the new address.
 	OW_OBJMETA_FLAG_USER1     = 6,
 	OW_OBJMETA_FLAG_USER2     = 7,
 };
 
-ow_static_forceinline struct ow_object *ow_object_meta_get_next(
-		const struct ow_object_meta *meta) {
-#if OW_WORDSIZE == 64
-	return (struct ow_object *)(meta->_data & OW_OBJMETA_NEXT_MASK);
-#elif OW_WORDSIZE == 32
-	return meta->_next;
-#endif
-}
-
-ow_static_forceinline void ow_object_meta_set_next(
-		struct ow_object_meta *meta, struct ow_object *next) {
-#if OW_WORDSIZE == 64
-	assert(!((uintptr_t)next & ~OW_OBJMETA_NEXT_MASK));
-	meta->_data = (meta->_data & ~OW_OBJMETA_NEXT_MASK) | (uintptr_t)next;
-#elif OW_WORDSIZE == 32
-	meta->_next = next;
-#endif
-}
-
 ow_static_forceinline bool ow_object_meta_get_flag(
 		const struct ow_object_meta *meta, enum ow_object_meta_flag flag) {
 #if OW_WORDSIZE == 64
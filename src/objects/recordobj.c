@@ -0,0 +1,68 @@
+#include "recordobj.h"
+
+#include <assert.h>
+
+#include "classes.h"
+#include "classes_util.h"
+#include "classobj.h"
+#include "natives.h"
+#include "shapeobj.h"
+#include <machine/globals.h>
+#include <machine/machine.h>
+#include <utilities/malloc.h>
+
+static void ow_record_obj_finalizer(struct ow_machine *om, struct ow_object *obj) {
+	ow_unused_var(om);
+	assert(ow_class_obj_is_base(om->builtin_classes->record, ow_object_class(obj)));
+	struct ow_record_obj *const self = ow_object_cast(obj, struct ow_record_obj);
+	if (self->slots)
+		ow_free(self->slots);
+}
+
+static void ow_record_obj_gc_marker(struct ow_machine *om, struct ow_object *obj) {
+	assert(ow_class_obj_is_base(om->builtin_classes->record, ow_object_class(obj)));
+	struct ow_record_obj *const self = ow_object_cast(obj, struct ow_record_obj);
+	ow_objmem_object_gc_slot_marker(om, (struct ow_object **)&self->shape);
+	for (size_t i = 0, n = ow_shape_obj_attribute_count(self->shape); i < n; i++)
+		ow_objmem_object_gc_slot_marker(om, &self->slots[i]);
+}
+
+struct ow_record_obj *ow_record_obj_new(struct ow_machine *om) {
+	struct ow_record_obj *const obj = ow_object_cast(
+		ow_objmem_allocate(om, om->builtin_classes->record, 0),
+		struct ow_record_obj);
+	obj->shape = om->globals->empty_shape;
+	obj->slots = NULL;
+	obj->slot_capacity = 0;
+	return obj;
+}
+
+void ow_record_obj_add(
+		struct ow_machine *om, struct ow_record_obj *self,
+		struct ow_shape_obj *new_shape, struct ow_object *val) {
+	const size_t index = ow_shape_obj_attribute_count(self->shape);
+	assert(ow_shape_obj_attribute_count(new_shape) == index + 1);
+	if (ow_unlikely(index >= self->slot_capacity)) {
+		const size_t new_capacity = self->slot_capacity ? self->slot_capacity * 2 : 4;
+		self->slots = ow_realloc(self->slots, new_capacity * sizeof(struct ow_object *));
+		self->slot_capacity = new_capacity;
+	}
+	self->slots[index] = val;
+	self->shape = new_shape;
+	ow_objmem_write_barrier(om, ow_object_from(self), val);
+	ow_objmem_write_barrier(om, ow_object_from(self), ow_object_from(new_shape));
+}
+
+static const struct ow_native_func_def record_methods[] = {
+	{NULL, NULL, 0},
+};
+
+OW_BICLS_CLASS_DEF_EX(record) = {
+	.name      = "Record",
+	.data_size = OW_OBJ_STRUCT_DATA_SIZE(struct ow_record_obj),
+	.methods   = record_methods,
+	.finalizer = ow_record_obj_finalizer,
+	.gc_marker = ow_record_obj_gc_marker,
+	.extended  = false,
+	.concurrent_finalizer = true,
+};
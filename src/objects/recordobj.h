@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "memory.h"
+#include "object.h"
+#include <utilities/attributes.h>
+
+struct ow_machine;
+struct ow_shape_obj;
+
+/// Record object, a plain object that attributes can be added to.
+/// Attribute values are stored in slots, whose layout is described by a shape.
+struct ow_record_obj {
+	OW_OBJECT_HEAD
+	struct ow_shape_obj *shape;
+	struct ow_object **slots; // nullable
+	size_t slot_capacity;
+};
+
+/// Create a record without attributes.
+struct ow_record_obj *ow_record_obj_new(struct ow_machine *om);
+/// Get attribute by slot index. No bounds checking.
+ow_static_forceinline struct ow_object *ow_record_obj_get(
+	const struct ow_record_obj *self, size_t index);
+/// Set attribute by slot index. No bounds checking.
+ow_static_forceinline void ow_record_obj_set(
+	struct ow_machine *om, struct ow_record_obj *self, size_t index, struct ow_object *val);
+/// Add an attribute, changing the shape to `new_shape`, which must be a
+/// transition of current shape (see `ow_shape_obj_transition()`).
+void ow_record_obj_add(
+	struct ow_machine *om, struct ow_record_obj *self,
+	struct ow_shape_obj *new_shape, struct ow_object *val);
+
+ow_static_forceinline struct ow_object *ow_record_obj_get(
+		const struct ow_record_obj *self, size_t index) {
+	return self->slots[index];
+}
+
+ow_static_forceinline void ow_record_obj_set(
+		struct ow_machine *om, struct ow_record_obj *self,
+		size_t index, struct ow_object *val) {
+	self->slots[index] = val;
+	ow_objmem_write_barrier(om, ow_object_from(self), val);
+}
@@ -9,17 +9,18 @@
 #include "object_util.h"
 #include <machine/machine.h>
 #include <utilities/hashmap.h>
+#include <utilities/ordmap.h>
 
 struct ow_set_obj {
 	OW_OBJECT_HEAD
-	struct ow_hashmap data; // {object, NULL}
+	struct ow_ordmap data; // {object, NULL}
 };
 
 static void ow_set_obj_finalizer(struct ow_machine *om, struct ow_object *obj) {
 	ow_unused_var(om);
 	assert(ow_class_obj_is_base(om->builtin_classes->set, ow_object_class(obj)));
 	struct ow_set_obj *const self = ow_object_cast(obj, struct ow_set_obj);
-	ow_hashmap_fini(&self->data);
+	ow_ordmap_fini(&self->data);
 }
 
 static int _ow_set_obj_gc_marker_walker(void *arg, const void *key, void *val) {
@@ -34,25 +35,26 @@ static void ow_set_obj_gc_marker(struct ow_machine *om, struct ow_object *obj) {
 	ow_unused_var(om);
 	assert(ow_class_obj_is_base(om->builtin_classes->set, ow_object_class(obj)));
 	struct ow_set_obj *const self = ow_object_cast(obj, struct ow_set_obj);
-	ow_hashmap_foreach(&self->data, _ow_set_obj_gc_marker_walker, om);
+	ow_ordmap_foreach(&self->data, _ow_set_obj_gc_marker_walker, om);
 }
 
 struct ow_set_obj *ow_set_obj_new(struct ow_machine *om) {
 	struct ow_set_obj *const obj = ow_object_cast(
 		ow_objmem_allocate(om, om->builtin_classes->set, 0),
 		struct ow_set_obj);
-	ow_hashmap_init(&obj->data, 0);
+	ow_ordmap_init(&obj->data, 0);
 	return obj;
 }
 
 void ow_set_obj_insert(
 		struct ow_machine *om, struct ow_set_obj *self,	struct ow_object *val) {
 	struct ow_hashmap_funcs mf = OW_OBJECT_HASHMAP_FUNCS_INIT(om);
-	ow_hashmap_set(&self->data, &mf, val, NULL);
+	ow_ordmap_set(&self->data, &mf, val, NULL);
+	ow_objmem_write_barrier(om, ow_object_from(self), val);
 }
 
 size_t ow_set_obj_length(const struct ow_set_obj *self) {
-	return ow_hashmap_size(&self->data);
+	return ow_ordmap_size(&self->data);
 }
 
 struct _ow_set_obj_foreach_walker_wrapper_arg {
@@ -71,7 +73,7 @@ static int _ow_set_obj_foreach_walker_wrapper(
 int ow_set_obj_foreach(
 		const struct ow_set_obj *self,
 		int (*walker)(void *arg, struct ow_object *elem), void *arg) {
-	return ow_hashmap_foreach(
+	return ow_ordmap_foreach(
 		&self->data, _ow_set_obj_foreach_walker_wrapper,
 		&(struct _ow_set_obj_foreach_walker_wrapper_arg){walker, arg});
 }
@@ -87,4 +89,5 @@ OW_BICLS_CLASS_DEF_EX(set) = {
 	.finalizer = ow_set_obj_finalizer,
 	.gc_marker = ow_set_obj_gc_marker,
 	.extended  = false,
+	.concurrent_finalizer = true,
 };
@@ -5,7 +5,7 @@
 struct ow_machine;
 struct ow_object;
 
-/// Set object.
+/// Set object. Elements are kept in insertion order.
 struct ow_set_obj;
 
 /// Create an empty set object.
@@ -15,7 +15,7 @@ void ow_set_obj_insert(
 	struct ow_machine *om, struct ow_set_obj *self, struct ow_object *val);
 /// Get number of elements.
 size_t ow_set_obj_length(const struct ow_set_obj *self);
-/// Visit each element.
+/// Visit each element in insertion order.
 int ow_set_obj_foreach(
 	const struct ow_set_obj *self,
 	int (*walker)(void *arg, struct ow_object *elem), void *arg);
@@ -0,0 +1,107 @@
+#include "shapeobj.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+#include "classes.h"
+#include "classes_util.h"
+#include "classobj.h"
+#include "memory.h"
+#include "natives.h"
+#include "object.h"
+#include "symbolobj.h"
+#include <machine/machine.h>
+#include <utilities/hashmap.h>
+
+struct ow_shape_obj {
+	OW_OBJECT_HEAD
+	struct ow_shape_obj_pub_info pub_info;
+	struct ow_hashmap attrs_map; // { name, index + 1 }
+	struct ow_hashmap transitions_map; // { name, child_shape }
+};
+
+static void ow_shape_obj_finalizer(struct ow_machine *om, struct ow_object *obj) {
+	ow_unused_var(om);
+	assert(ow_object_class(obj) == om->builtin_classes->shape);
+	struct ow_shape_obj *const self = ow_object_cast(obj, struct ow_shape_obj);
+	ow_hashmap_fini(&self->attrs_map);
+	ow_hashmap_fini(&self->transitions_map);
+}
+
+static int _attrs_map_gc_walker(void *ctx, const void *key, void *val) {
+	struct ow_machine *const om = ctx;
+	ow_unused_var(val);
+	ow_objmem_object_gc_marker(om, (struct ow_object *)key);
+	return 0;
+}
+
+static int _transitions_map_gc_walker(void *ctx, const void *key, void *val) {
+	struct ow_machine *const om = ctx;
+	ow_objmem_object_gc_marker(om, (struct ow_object *)key);
+	ow_objmem_object_gc_marker(om, val);
+	return 0;
+}
+
+static void ow_shape_obj_gc_marker(struct ow_machine *om, struct ow_object *obj) {
+	assert(ow_object_class(obj) == om->builtin_classes->shape);
+	struct ow_shape_obj *const self = ow_object_cast(obj, struct ow_shape_obj);
+	ow_hashmap_foreach(&self->attrs_map, _attrs_map_gc_walker, om);
+	ow_hashmap_foreach(&self->transitions_map, _transitions_map_gc_walker, om);
+}
+
+struct ow_shape_obj *ow_shape_obj_new(struct ow_machine *om) {
+	struct ow_shape_obj *const obj = ow_object_cast(
+		ow_objmem_allocate(om, om->builtin_classes->shape, 0),
+		struct ow_shape_obj);
+	obj->pub_info.attribute_count = 0;
+	ow_hashmap_init(&obj->attrs_map, 0);
+	ow_hashmap_init(&obj->transitions_map, 0);
+	assert(ow_shape_obj_pub_info(obj) == &obj->pub_info);
+	return obj;
+}
+
+size_t ow_shape_obj_find(
+		const struct ow_shape_obj *self, const struct ow_symbol_obj *name) {
+	const uintptr_t index = (uintptr_t)ow_hashmap_get(
+		&self->attrs_map, &ow_symbol_obj_hashmap_funcs, name);
+	return index - 1;
+}
+
+struct ow_shape_obj *ow_shape_obj_transition(
+		struct ow_machine *om, struct ow_shape_obj *self, struct ow_symbol_obj *name) {
+	assert(ow_shape_obj_find(self, name) == (size_t)-1);
+
+	struct ow_shape_obj *child = ow_hashmap_get(
+		&self->transitions_map, &ow_symbol_obj_hashmap_funcs, name);
+	if (ow_likely(child))
+		return child;
+
+	// Objects are not moved or collected while creating the shape.
+	ow_objmem_push_ngc(om);
+	child = ow_shape_obj_new(om);
+	const size_t count = self->pub_info.attribute_count;
+	ow_hashmap_reserve(&child->attrs_map, count + 1);
+	ow_hashmap_extend(&child->attrs_map, &ow_symbol_obj_hashmap_funcs, &self->attrs_map);
+	ow_hashmap_set(
+		&child->attrs_map, &ow_symbol_obj_hashmap_funcs,
+		name, (void *)(uintptr_t)(count + 1));
+	child->pub_info.attribute_count = count + 1;
+	ow_hashmap_set(&self->transitions_map, &ow_symbol_obj_hashmap_funcs, name, child);
+	ow_objmem_write_barrier_n(om, ow_object_from(self));
+	ow_objmem_pop_ngc(om);
+	return child;
+}
+
+static const struct ow_native_func_def shape_methods[] = {
+	{NULL, NULL, 0},
+};
+
+OW_BICLS_CLASS_DEF_EX(shape) = {
+	.name      = "Shape",
+	.data_size = OW_OBJ_STRUCT_DATA_SIZE(struct ow_shape_obj),
+	.methods   = shape_methods,
+	.finalizer = ow_shape_obj_finalizer,
+	.gc_marker = ow_shape_obj_gc_marker,
+	.extended  = false,
+	.concurrent_finalizer = true,
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "object_util.h"
+#include <utilities/attributes.h>
+
+struct ow_machine;
+struct ow_symbol_obj;
+
+/// Shape object, an immutable mapping from attribute names to slot indices.
+/// Adding an attribute to an object changes its shape to a child shape, which
+/// is shared by all objects that got the same attributes in the same order.
+struct ow_shape_obj;
+
+/// Create an empty shape, the root of transition chains.
+struct ow_shape_obj *ow_shape_obj_new(struct ow_machine *om);
+/// Get slot index of an attribute. If not exists, return -1.
+size_t ow_shape_obj_find(
+	const struct ow_shape_obj *self, const struct ow_symbol_obj *name);
+/// Get the shape that has one more attribute after the existing ones.
+/// The attribute must not exist. The shape is created if it does not exist yet.
+struct ow_shape_obj *ow_shape_obj_transition(
+	struct ow_machine *om, struct ow_shape_obj *self, struct ow_symbol_obj *name);
+/// Get number of attributes.
+ow_static_forceinline size_t ow_shape_obj_attribute_count(const struct ow_shape_obj *self);
+
+struct ow_shape_obj_pub_info {
+	size_t attribute_count;
+};
+
+ow_static_forceinline const struct ow_shape_obj_pub_info *ow_shape_obj_pub_info(
+		const struct ow_shape_obj *self) {
+	return (const struct ow_shape_obj_pub_info *)
+		((const unsigned char *)self + OW_OBJECT_SIZE);
+}
+
+ow_static_forceinline size_t ow_shape_obj_attribute_count(const struct ow_shape_obj *self) {
+	return ow_shape_obj_pub_info(self)->attribute_count;
+}
@@ -10,6 +10,8 @@
 #include "natives.h"
 #include "object_util.h"
 #include <machine/machine.h>
+#include <utilities/hash.h>
+#include <utilities/malloc.h>
 #include <utilities/unicode.h>
 #include <utilities/unreachable.h>
 
@@ -17,6 +19,7 @@
 	OW_EXTENDED_OBJECT_HEAD \
 	size_t size; /* Number of bytes. */ \
 	size_t length; /* Number of chars. */ \
+	ow_hash_t hash; /* Hash of the bytes, or 0 if not calculated yet. */ \
 // ^^^ STRING_OBJ_HEAD ^^^
 
 struct ow_string_obj {
@@ -103,6 +106,7 @@ struct ow_string_obj *ow_string_obj_new(
 	ow_string_obj_impl_set_subtype(&obj->_meta, STR_INNER);
 	obj->size = n;
 	obj->length = (size_t)u8_len;
+	obj->hash = 0;
 	memcpy(obj->bytes, s, n);
 	obj->bytes[n] = '\0';
 	return (struct ow_string_obj *)obj;
@@ -140,6 +144,7 @@ struct ow_string_obj *ow_string_obj_slice(
 			struct ow_string_obj_impl_slice);
 		ow_string_obj_impl_set_subtype(&obj->_meta, STR_SLICE);
 		obj->length = len;
+		obj->hash = 0;
 
 		if (str_type == STR_INNER) {
 			struct ow_string_obj_impl_inner *const inner_str =
@@ -208,6 +213,7 @@ struct ow_string_obj *ow_string_obj_concat(
 	ow_string_obj_impl_set_subtype(&obj->_meta, STR_CONS);
 	obj->size = res_size;
 	obj->length = str1->length + str2->length;
+	obj->hash = 0;
 	obj->str1 = str1;
 	obj->str2 = str2;
 	return (struct ow_string_obj *)obj;
@@ -300,6 +306,7 @@ const char *ow_string_obj_flatten(
 		ow_string_obj_impl_set_subtype(&str_inner->_meta, STR_INNER);
 		str_inner->size = self->size;
 		str_inner->length = self->length;
+		str_inner->hash = self->hash;
 		ow_string_obj_copy(self, 0, (size_t)-1, str_inner->bytes, self->size);
 		str_inner->bytes[self->size] = '\0';
 
@@ -310,6 +317,7 @@ const char *ow_string_obj_flatten(
 		ow_string_obj_impl_set_subtype(&str_slice->_meta, STR_SLICE);
 		str_slice->str = str_inner;
 		str_slice->begin_offset = 0;
+		ow_objmem_write_barrier(om, ow_object_from(self), ow_object_from(str_inner));
 	}
 
 	if (str_type == STR_SLICE) {
@@ -329,6 +337,65 @@ const char *ow_string_obj_flatten(
 	}
 }
 
+/// Get string bytes without allocating objects. If the string is not flat, the
+/// bytes are copied to a buffer, which is stored to `*buf` and shall be freed
+/// with `ow_free()`; otherwise, `*buf` is set to NULL.
+static const char *ow_string_obj_impl_bytes(const struct ow_string_obj *self, char **buf) {
+	switch (ow_string_obj_impl_get_subtype(&self->_meta)) {
+	case STR_INNER:
+		*buf = NULL;
+		return ((const struct ow_string_obj_impl_inner *)self)->bytes;
+
+	case STR_SLICE: {
+		const struct ow_string_obj_impl_slice *const str_slice =
+			(const struct ow_string_obj_impl_slice *)self;
+		*buf = NULL;
+		return str_slice->str->bytes + str_slice->begin_offset;
+	}
+
+	case STR_CONS:
+		*buf = ow_malloc(self->size);
+		ow_string_obj_copy(self, 0, (size_t)-1, *buf, self->size);
+		return *buf;
+
+	default:
+		ow_unreachable();
+	}
+}
+
+ow_hash_t ow_string_obj_hash(struct ow_string_obj *self) {
+	if (ow_likely(self->hash))
+		return self->hash;
+	char *buf;
+	const char *const bytes = ow_string_obj_impl_bytes(self, &buf);
+	ow_hash_t hash = ow_hash_bytes(bytes, self->size);
+	if (ow_unlikely(buf))
+		ow_free(buf);
+	if (ow_unlikely(!hash))
+		hash = 1;
+	self->hash = hash;
+	return hash;
+}
+
+bool ow_string_obj_equal(
+		const struct ow_string_obj *self, const struct ow_string_obj *other) {
+	if (self == other)
+		return true;
+	if (self->size != other->size)
+		return false;
+	if (self->hash && other->hash && self->hash != other->hash)
+		return false;
+	char *buf1, *buf2;
+	const char *const bytes1 = ow_string_obj_impl_bytes(self, &buf1);
+	const char *const bytes2 = ow_string_obj_impl_bytes(other, &buf2);
+	const bool res = memcmp(bytes1, bytes2, self->size) == 0;
+	if (ow_unlikely(buf1))
+		ow_free(buf1);
+	if (ow_unlikely(buf2))
+		ow_free(buf2);
+	return res;
+}
+
 size_t ow_string_obj_size(const struct ow_string_obj *self) {
 	return self->size;
 }
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 
+#include <utilities/hash.h>
+
 struct ow_machine;
 
 /// String object, using UTF-8 string.
@@ -25,6 +28,11 @@ size_t ow_string_obj_copy(
 /// Param `s_size` can be NULL, if do not need the string size.
 const char *ow_string_obj_flatten(
 	struct ow_machine *om, struct ow_string_obj *self, size_t *s_size);
+/// Get hash value of the string bytes. It is calculated once and then cached.
+ow_hash_t ow_string_obj_hash(struct ow_string_obj *self);
+/// Check whether two strings have the same bytes. No objects are allocated.
+bool ow_string_obj_equal(
+	const struct ow_string_obj *self, const struct ow_string_obj *other);
 /// Get number of bytes in the string.
 size_t ow_string_obj_size(const struct ow_string_obj *self);
 /// Get number of characters in the string.
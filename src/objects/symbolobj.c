@@ -43,8 +43,7 @@ int _ow_symbol_pool_gc_handler_pool_walker(void *arg, const void *key, void *val
 	struct ow_symbol_obj *const sym = val;
 	ow_unused_var(key);
 	assert(key == val);
-	const bool sym_marked =
-		ow_object_meta_get_flag(&ow_object_from(sym)->_meta, OW_OBJMETA_FLAG_MARKED);
+	const bool sym_marked = ow_objmem_object_is_marked(ow_object_from(sym));
 	if (ow_unlikely(!sym_marked))
 		ow_array_append(unreachable_symbols, sym);
 	return 0;
@@ -155,6 +154,10 @@ const char *ow_symbol_obj_data(const struct ow_symbol_obj *self) {
 	return self->str;
 }
 
+ow_hash_t ow_symbol_obj_hash(const struct ow_symbol_obj *self) {
+	return self->hash;
+}
+
 static bool _ow_symbol_obj_hashmap_funcs_key_equal(
 		void *ctx, const void *key_new, const void *key_stored) {
 	ow_unused_var(ctx);
@@ -2,6 +2,8 @@
 
 #include <stddef.h>
 
+#include <utilities/hash.h>
+
 struct ow_hashmap_funcs;
 struct ow_machine;
 
@@ -12,7 +14,7 @@ struct ow_symbol_pool;
 struct ow_symbol_pool *ow_symbol_pool_new(void);
 /// Destroy a symbol pool.
 void ow_symbol_pool_del(struct ow_symbol_pool *sp);
-/// GC handler. Must be called after other GC markers.
+/// GC handler. Must be called after all reachable objects have been marked.
 void _ow_symbol_pool_gc_handler(struct ow_machine *om, struct ow_symbol_pool *sp);
 
 /// Symbol object.
@@ -24,6 +26,8 @@ struct ow_symbol_obj *ow_symbol_obj_new(struct ow_machine *om, const char *s, si
 size_t ow_symbol_obj_size(const struct ow_symbol_obj *self);
 /// Get symbol string bytes.
 const char *ow_symbol_obj_data(const struct ow_symbol_obj *self);
+/// Get hash value of the symbol string.
+ow_hash_t ow_symbol_obj_hash(const struct ow_symbol_obj *self);
 
 /// Hash map functions for hash maps that use symbol objects as keys.
 extern const struct ow_hashmap_funcs ow_symbol_obj_hashmap_funcs;
@@ -63,8 +63,8 @@ static void ow_tuple_obj_gc_marker(struct ow_machine *om, struct ow_object *obj)
 	switch (ow_tuple_obj_impl_get_subtype(&self->_meta)) {
 	case TUPLE_INNER:
 		for (size_t i = 0, n = self->elem_count; i < n; i++) {
-			ow_objmem_object_gc_marker(
-				om, ((struct ow_tuple_obj_impl_inner *)self)->elems[i]);
+			ow_objmem_object_gc_slot_marker(
+				om, &((struct ow_tuple_obj_impl_inner *)self)->elems[i]);
 		}
 		break;
 
@@ -277,6 +277,7 @@ struct ow_object **ow_tuple_obj_flatten(
 		ow_tuple_obj_impl_set_subtype(&tuple_slice->_meta, TUPLE_SLICE);
 		tuple_slice->tuple = tuple_inner;
 		tuple_slice->begin_index = 0;
+		ow_objmem_write_barrier(om, ow_object_from(self), ow_object_from(tuple_inner));
 	}
 
 	if (tuple_type == TUPLE_SLICE) {
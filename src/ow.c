@@ -461,6 +461,115 @@ static_cold_func int opt_stack_size(
 	return 0;
 }
 
+static_cold_func int opt_stack_reserve(
+		void *ctx, const argparse_option_t *opt, const char *arg) {
+	ow_unused_var(opt);
+	const long long n = atoll(arg);
+	if (n < 0) {
+		struct ow_args *const args = ctx;
+		fprintf(stderr, "%s: invalid stack size: `%s'\n", args->prog, arg);
+		cleanup_mom_and_exit(EXIT_FAILURE);
+	}
+	ow_sysctl(OW_CTL_STACKRESERVE, &n, sizeof n);
+	return 0;
+}
+
+static_cold_func int opt_gc_mark_budget(
+		void *ctx, const argparse_option_t *opt, const char *arg) {
+	ow_unused_var(opt);
+	const long long n = atoll(arg);
+	if (n < 0) {
+		struct ow_args *const args = ctx;
+		fprintf(stderr, "%s: invalid GC mark budget: `%s'\n", args->prog, arg);
+		cleanup_mom_and_exit(EXIT_FAILURE);
+	}
+	ow_sysctl(OW_CTL_GCMARKBUDGET, &n, sizeof n);
+	return 0;
+}
+
+static_cold_func int opt_gc_mark_threads(
+		void *ctx, const argparse_option_t *opt, const char *arg) {
+	ow_unused_var(opt);
+	const long long n = atoll(arg);
+	if (ow_sysctl(OW_CTL_GCMARKTHREADS, &n, sizeof n) != 0) {
+		struct ow_args *const args = ctx;
+		fprintf(stderr, "%s: invalid number of GC mark threads: `%s'\n", args->prog, arg);
+		cleanup_mom_and_exit(EXIT_FAILURE);
+	}
+	return 0;
+}
+
+static_cold_func int opt_gc_compact(
+		void *ctx, const argparse_option_t *opt, const char *arg) {
+	ow_unused_var(opt);
+	const long long n = atoll(arg);
+	if (ow_sysctl(OW_CTL_GCCOMPACT, &n, sizeof n) != 0) {
+		struct ow_args *const args = ctx;
+		fprintf(stderr, "%s: invalid GC compaction threshold: `%s'\n", args->prog, arg);
+		cleanup_mom_and_exit(EXIT_FAILURE);
+	}
+	return 0;
+}
+
+/// Parse a size with an optional suffix (K, M or G). Return -1 if invalid.
+static_cold_func long long parse_size(const char *s) {
+	char *end;
+	long long n = strtoll(s, &end, 10);
+	if (end == s || n < 0)
+		return -1;
+	switch (toupper((unsigned char)*end)) {
+	case 'G':
+		n *= 1024;
+		ow_fallthrough;
+	case 'M':
+		n *= 1024;
+		ow_fallthrough;
+	case 'K':
+		n *= 1024;
+		end++;
+		break;
+	default:
+		break;
+	}
+	return *end ? -1 : n;
+}
+
+static_cold_func int opt_gc_cpu_goal(
+		void *ctx, const argparse_option_t *opt, const char *arg) {
+	ow_unused_var(opt);
+	const long long n = atoll(arg);
+	if (ow_sysctl(OW_CTL_GCCPUGOAL, &n, sizeof n) != 0) {
+		struct ow_args *const args = ctx;
+		fprintf(stderr, "%s: invalid GC CPU goal: `%s'\n", args->prog, arg);
+		cleanup_mom_and_exit(EXIT_FAILURE);
+	}
+	return 0;
+}
+
+static_cold_func int opt_gc_heap_goal(
+		void *ctx, const argparse_option_t *opt, const char *arg) {
+	ow_unused_var(opt);
+	const long long n = parse_size(arg);
+	if (ow_sysctl(OW_CTL_GCHEAPGOAL, &n, sizeof n) != 0) {
+		struct ow_args *const args = ctx;
+		fprintf(stderr, "%s: invalid GC heap goal: `%s'\n", args->prog, arg);
+		cleanup_mom_and_exit(EXIT_FAILURE);
+	}
+	return 0;
+}
+
+static_cold_func int opt_heap_limit(
+		void *ctx, const argparse_option_t *opt, const char *arg) {
+	ow_unused_var(opt);
+	const long long n = parse_size(arg);
+	if (ow_sysctl(OW_CTL_HEAPLIMIT, &n, sizeof n) != 0) {
+		struct ow_args *const args = ctx;
+		fprintf(stderr, "%s: invalid heap limit: `%s'\n", args->prog, arg);
+		cleanup_mom_and_exit(EXIT_FAILURE);
+	}
+	return 0;
+}
+
 static_cold_func int opt_file_or_arg(
 		void *ctx, const argparse_option_t *opt, const char *arg) {
 	ow_unused_var(opt), ow_unused_var(arg);
@@ -492,6 +601,27 @@ static const char opt_verbose_help[] =
 	"Enable or disable verbose output for memory (M), lexer (L), parser (P), "
 	"code generator (C) or detailed version information (V).";
 
+static const char opt_stack_reserve_help[] =
+	"Reserve a guard-page-protected stack of N objects (0 to disable).";
+
+static const char opt_gc_mark_budget_help[] =
+	"Do full GCs incrementally, marking N objects at a time (0 to disable).";
+
+static const char opt_gc_mark_threads_help[] =
+	"Mark objects in full GCs with N threads.";
+
+static const char opt_gc_compact_help[] =
+	"Compact the heap in full GCs when N percent of it is fragmented (0 to disable).";
+
+static const char opt_gc_cpu_goal_help[] =
+	"Size the heap so that GC takes about N percent of time (0 for fixed growth).";
+
+static const char opt_gc_heap_goal_help[] =
+	"Try to keep the heap within SIZE bytes (suffix K, M or G allowed; 0 for none).";
+
+static const char opt_heap_limit_help[] =
+	"Raise an out-of-memory error if the heap exceeds SIZE bytes (0 for default).";
+
 static const argparse_option_t options[] = {
 	{'h', "help"   , NULL   , "Print help message and exit.", opt_help        },
 	{'V', "version", NULL   , opt_version_help              , opt_version     },
@@ -501,6 +631,13 @@ static const argparse_option_t options[] = {
 	{'P', "path"   , "PATH" , "Add a module search path."   , opt_path        },
 	{'v', "verbose", "[!]M|L|P|C|V", opt_verbose_help       , opt_verbose     },
 	{0  , "stack-size", "N" , "Set stack size (object count).", opt_stack_size},
+	{0  , "stack-reserve", "N", opt_stack_reserve_help     , opt_stack_reserve},
+	{0  , "gc-mark-budget", "N", opt_gc_mark_budget_help   , opt_gc_mark_budget},
+	{0  , "gc-mark-threads", "N", opt_gc_mark_threads_help , opt_gc_mark_threads},
+	{0  , "gc-compact", "N" , opt_gc_compact_help          , opt_gc_compact  },
+	{0  , "gc-cpu-goal", "N", opt_gc_cpu_goal_help         , opt_gc_cpu_goal },
+	{0  , "gc-heap-goal", "SIZE", opt_gc_heap_goal_help    , opt_gc_heap_goal},
+	{0  , "heap-limit", "SIZE", opt_heap_limit_help        , opt_heap_limit  },
 	{0  , NULL     , "..."  , NULL                          , opt_file_or_arg },
 	{0  , NULL     , NULL   , NULL                          , NULL            },
 };
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <utilities/attributes.h>
+
+#if defined _MSC_VER && !defined __clang__
+#	include <intrin.h>
+#endif
+
+/// Count set bits.
+ow_static_forceinline unsigned int ow_bits_popcount64(uint64_t x) {
+#if defined __GNUC__
+	return (unsigned int)__builtin_popcountll(x);
+#elif defined _MSC_VER && defined _M_X64
+	return (unsigned int)__popcnt64(x);
+#else
+	x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+	x = (x & UINT64_C(0x3333333333333333)) + ((x >> 2) & UINT64_C(0x3333333333333333));
+	x = (x + (x >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+	return (unsigned int)((x * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+/// Count trailing zero bits. The value must not be zero.
+ow_static_forceinline unsigned int ow_bits_ctz64(uint64_t x) {
+#if defined __GNUC__
+	return (unsigned int)__builtin_ctzll(x);
+#elif defined _MSC_VER && defined _M_X64
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (unsigned int)index;
+#else
+	return ow_bits_popcount64((x & -x) - 1);
+#endif
+}
@@ -4,98 +4,157 @@
 #include <math.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
 
-ow_hash_t ow_hash_double(double val) {
-	if (ow_unlikely(!isnormal(val))) {
-		if (val == 0.0)
-			return 0;
-		return 0x55555555;
-	}
+#include <utilities/platform.h>
+#include <utilities/thread.h>
+
+#if _IS_WINDOWS_
+#	define _CRT_RAND_S
+#	include <stdlib.h> // rand_s()
+#elif _IS_POSIX_
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
 
-	const int32_t as_int = (int32_t)val;
-	static_assert(sizeof as_int == sizeof(ow_hash_t), "");
-	if ((double)as_int == val)
-		return ow_hash_int(as_int);
+//-----------------------------------------------------------------------------
+// wyhash (final version 4) was written by Wang Yi, and is released into the
+// public domain. The original code is adapted here.
 
-	static_assert(sizeof(float) == sizeof(ow_hash_t), "");
-	union { float f; int32_t i; } converter;
-	converter.f = (float)val;
-	return converter.i >> 2;
+static const uint64_t wyhash_secret[4] = {
+	UINT64_C(0x2d358dccaa6c78a5), UINT64_C(0x8bb84b93962eacc9),
+	UINT64_C(0x4b33a62ed433d4a3), UINT64_C(0x4d5a2da51de1aa47),
+};
+
+ow_static_forceinline uint64_t wyhash_mix(uint64_t a, uint64_t b) {
+	ow_hash_mum(&a, &b);
+	return a ^ b;
 }
 
-#ifdef _MSC_VER
-extern unsigned int _rotl(unsigned int value, int shift);
-#endif // _MSC_VER
+// Reads in native byte order. The seed is random anyway, so results need not
+// agree between platforms.
 
-ow_static_forceinline uint32_t rotl32(uint32_t x, int8_t r) {
-#if defined(_MSC_VER)
-	return _rotl(x, r);
-#else // !_MSC_VER
-	return (x << r) | (x >> (32 - r));
-#endif // _MSC_VER
+ow_static_forceinline uint64_t wyhash_r8(const uint8_t *p) {
+	uint64_t v;
+	memcpy(&v, p, sizeof v);
+	return v;
 }
 
-//-----------------------------------------------------------------------------
-// MurmurHash3 was written by Austin Appleby, and is placed in the public
-// domain. The author hereby disclaims copyright to this source code.
-static uint32_t MurmurHash3_x86_32(const void *key, int len, uint32_t seed) {
-	const uint8_t *data = (const uint8_t *)key;
-	const int nblocks = len / 4;
+ow_static_forceinline uint64_t wyhash_r4(const uint8_t *p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+ow_static_forceinline uint64_t wyhash_r3(const uint8_t *p, size_t k) {
+	return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+/// The wyhash function, with the seed already mixed with the secret.
+static uint64_t wyhash(const void *key, size_t len, uint64_t seed) {
+	const uint64_t *const secret = wyhash_secret;
+	const uint8_t *p = key;
+	uint64_t a, b;
+
+	if (ow_likely(len <= 16)) {
+		if (ow_likely(len >= 4)) {
+			const size_t off = (len >> 3) << 2;
+			a = (wyhash_r4(p) << 32) | wyhash_r4(p + off);
+			b = (wyhash_r4(p + len - 4) << 32) | wyhash_r4(p + len - 4 - off);
+		} else if (ow_likely(len > 0)) {
+			a = wyhash_r3(p, len);
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = len;
+		if (ow_unlikely(i >= 48)) {
+			// Bulk path: three independent lanes of 16 bytes each, so that the
+			// multiplications of a round can be executed in parallel.
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = wyhash_mix(wyhash_r8(p) ^ secret[1], wyhash_r8(p + 8) ^ seed);
+				see1 = wyhash_mix(wyhash_r8(p + 16) ^ secret[2], wyhash_r8(p + 24) ^ see1);
+				see2 = wyhash_mix(wyhash_r8(p + 32) ^ secret[3], wyhash_r8(p + 40) ^ see2);
+				p += 48, i -= 48;
+			} while (ow_likely(i >= 48));
+			seed ^= see1 ^ see2;
+		}
+		while (ow_unlikely(i > 16)) {
+			seed = wyhash_mix(wyhash_r8(p) ^ secret[1], wyhash_r8(p + 8) ^ seed);
+			p += 16, i -= 16;
+		}
+		a = wyhash_r8(p + i - 16);
+		b = wyhash_r8(p + i - 8);
+	}
 
-	uint32_t h1 = seed;
+	a ^= secret[1];
+	b ^= seed;
+	ow_hash_mum(&a, &b);
+	return wyhash_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
 
-	const uint32_t c1 = 0xcc9e2d51;
-	const uint32_t c2 = 0x1b873593;
+//-----------------------------------------------------------------------------
 
-	const uint32_t *blocks = (const uint32_t *)(data + (ptrdiff_t)nblocks * 4);
+uint64_t _ow_hash_seed; // Mixed with the secret.
+static ow_once_flag_t hash_seed_once = OW_ONCE_FLAG_INIT;
+
+/// Get a random number from the system, or 0 if not available.
+static uint64_t system_random(void) {
+	uint64_t val = 0;
+#if _IS_WINDOWS_
+	unsigned int lo, hi;
+	if (rand_s(&lo) == 0 && rand_s(&hi) == 0)
+		val = (uint64_t)hi << 32 | lo;
+#elif _IS_POSIX_
+	const int fd = open("/dev/urandom", O_RDONLY);
+	if (fd >= 0) {
+		if (read(fd, &val, sizeof val) != (ssize_t)sizeof val)
+			val = 0;
+		close(fd);
+	}
+#endif
+	return val;
+}
 
-	for (int i = -nblocks; i; i++) {
-		uint32_t k1 = blocks[i];
+static void hash_seed_init(void) {
+	uint64_t seed = system_random();
+	// Extra entropy, in case the system has no random source. Addresses of
+	// static and automatic variables vary if ASLR is enabled.
+	seed ^= wyhash_mix((uint64_t)time(NULL), (uint64_t)clock());
+	seed ^= wyhash_mix((uint64_t)(uintptr_t)&_ow_hash_seed, (uint64_t)(uintptr_t)&seed);
+	seed ^= wyhash_mix(seed ^ wyhash_secret[0], wyhash_secret[1]);
+	_ow_hash_seed = seed ? seed : wyhash_secret[2];
+}
 
-		k1 *= c1;
-		k1 = rotl32(k1, 15);
-		k1 *= c2;
+void ow_hash_init(void) {
+	ow_call_once(&hash_seed_once, hash_seed_init);
+}
+
+ow_hash_t ow_hash_double(double val) {
+	if (ow_unlikely(!isnormal(val))) {
+		if (val == 0.0)
+			return 0;
+		return UINT64_C(0x5555555555555555);
+	}
 
-		h1 ^= k1;
-		h1 = rotl32(h1, 13);
-		h1 = h1 * 5 + 0xe6546b64;
+	// Integral values shall have the same hashes as the integers.
+	if (val >= -9223372036854775808.0 && val < 9223372036854775808.0) {
+		const int64_t as_int = (int64_t)val;
+		if ((double)as_int == val)
+			return ow_hash_int64(as_int);
 	}
 
-	const uint8_t *tail = (const uint8_t *)(data + (ptrdiff_t)nblocks * 4);
-
-	uint32_t k1 = 0;
-
-	switch (len & 3) {
-	case 3:
-		k1 ^= tail[2] << 16;
-		ow_fallthrough;
-	case 2:
-		k1 ^= tail[1] << 8;
-		ow_fallthrough;
-	case 1:
-		k1 ^= tail[0];
-		k1 *= c1;
-		k1 = rotl32(k1, 15);
-		k1 *= c2;
-		h1 ^= k1;
-	default:
-		break;
-	};
-
-	h1 ^= len;
-
-	h1 ^= h1 >> 16;
-	h1 *= 0x85ebca6b;
-	h1 ^= h1 >> 13;
-	h1 *= 0xc2b2ae35;
-	h1 ^= h1 >> 16;
-
-	return h1;
+	uint64_t bits;
+	static_assert(sizeof bits == sizeof val, "");
+	memcpy(&bits, &val, sizeof bits);
+	assert(_ow_hash_seed); // See `ow_hash_init()`.
+	return wyhash_mix(bits ^ _ow_hash_seed, wyhash_secret[1]);
 }
 
 ow_hash_t ow_hash_bytes(const void *data, size_t size) {
-	assert(size <= INT32_MAX);
-	const uint32_t seed = 0x5d9ee90;
-	const ow_hash_t result = MurmurHash3_x86_32(data, (int)size, seed);
-	return result;
+	assert(_ow_hash_seed); // See `ow_hash_init()`.
+	return wyhash(data, size, _ow_hash_seed);
 }
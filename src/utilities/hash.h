@@ -5,7 +5,19 @@
 
 #include <utilities/attributes.h>
 
-typedef uint32_t ow_hash_t;
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(__SIZEOF_INT128__)
+#	include <intrin.h> // _umul128()
+#endif
+
+typedef uint64_t ow_hash_t;
+
+/// Per-process random seed. 0 if not initialized. See `ow_hash_init()`.
+extern uint64_t _ow_hash_seed;
+
+/// Initialize the per-process random seed of `ow_hash_bytes()`, `ow_hash_double()`
+/// and `ow_hash_spread()`. It must be called before hashing anything;
+/// calls other than the first have no effect.
+void ow_hash_init(void);
 
 /// Hash function for 32-bit integer.
 ow_static_inline ow_hash_t ow_hash_int(int32_t val);
@@ -15,11 +27,17 @@ ow_static_inline ow_hash_t ow_hash_int64(int64_t val);
 ow_static_inline ow_hash_t ow_hash_pointer(const void *ptr);
 /// Hash function for double.
 ow_hash_t ow_hash_double(double val);
-/// Hash function for byte array.
+/// Hash function for byte array. Results differ between processes.
 ow_hash_t ow_hash_bytes(const void *data, size_t size);
+/// 64x64->128 multiplication. Low half to `*a`, high half to `*b`.
+ow_static_forceinline void ow_hash_mum(uint64_t *a, uint64_t *b);
+/// Mix a hash value with the per-process seed, for locating it in a hash table.
+/// Integers hash to themselves, so without this, keys differing only in high
+/// bits could be picked to fall into the same bucket.
+ow_static_forceinline uint64_t ow_hash_spread(ow_hash_t hash);
 
 ow_static_inline ow_hash_t ow_hash_int(int32_t val) {
-	return (ow_hash_t)val;
+	return ow_hash_int64(val);
 }
 
 ow_static_inline ow_hash_t ow_hash_int64(int64_t val) {
@@ -29,3 +47,28 @@ ow_static_inline ow_hash_t ow_hash_int64(int64_t val) {
 ow_static_inline ow_hash_t ow_hash_pointer(const void *ptr) {
 	return (ow_hash_t)(uintptr_t)ptr;
 }
+
+ow_static_forceinline void ow_hash_mum(uint64_t *a, uint64_t *b) {
+#if defined(__SIZEOF_INT128__)
+	const __uint128_t r = (__uint128_t)*a * *b;
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	*a = _umul128(*a, *b, b);
+#else
+	const uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+	const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	const uint64_t t = rl + (rm0 << 32), lo = t + (rm1 << 32);
+	const uint64_t c = (uint64_t)(t < rl) + (uint64_t)(lo < t);
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+ow_static_forceinline uint64_t ow_hash_spread(ow_hash_t hash) {
+	// The high half of the product folds all bits down, which a plain
+	// multiplication cannot do.
+	uint64_t a = hash ^ _ow_hash_seed, b = UINT64_C(0x9e3779b97f4a7c15);
+	ow_hash_mum(&a, &b);
+	return a ^ b;
+}
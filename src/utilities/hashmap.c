@@ -1,79 +1,280 @@
 #include "hashmap.h"
 
 #include <assert.h>
+#include <stdint.h>
+#include <string.h>
 
 #include <utilities/attributes.h>
+#include <utilities/bits.h>
 #include <utilities/malloc.h>
 
-struct _ow_hashmap_node {
-	struct _ow_hashmap_node *next_node; // nullable
-	ow_hash_t key_hash;
-	void  *key;
-	void  *value;
+#if defined __SSE2__ || defined _M_X64 || defined _M_AMD64 \
+		|| (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#	define HASHMAP_SSE2 1
+#	include <emmintrin.h>
+#elif (defined __ARM_NEON && !defined __ARM_BIG_ENDIAN) || defined _M_ARM64
+#	define HASHMAP_NEON 1
+#	include <arm_neon.h>
+#endif
+
+/*
+ * The table is a Swiss table. Each slot has a control byte, which is EMPTY,
+ * DELETED, or the lower 7 bits of the hash (H2) when the slot is full. The
+ * control bytes are probed a group at a time, comparing all of them with H2 in
+ * a few instructions. The rest of the hash (H1) selects the first group.
+ *
+ * The capacity is 0 or (2^n - 1). The control byte array has a SENTINEL byte
+ * after the last slot, followed by a copy of the first (GROUP_WIDTH - 1) bytes,
+ * so that a group can be loaded from any position without wrapping around.
+ */
+
+struct _ow_hashmap_slot {
+	void *key;
+	void *value;
+	ow_hash_t hash;
 };
 
-struct _ow_hashmap_bucket {
-	struct _ow_hashmap_node *nodes; // nullable
+typedef struct _ow_hashmap_slot slot_t;
+typedef signed char ctrl_t;
+
+#define CTRL_EMPTY     ((ctrl_t)-128)
+#define CTRL_DELETED   ((ctrl_t)-2)
+#define CTRL_SENTINEL  ((ctrl_t)-1)
+
+#define ctrl_is_full(C)  ((C) >= 0)
+
+#if HASHMAP_SSE2
+
+#define GROUP_WIDTH 16
+
+typedef __m128i group_t;
+typedef uint32_t group_mask_t; // One bit for each byte.
+
+#define group_mask_index(M)  ((size_t)ow_bits_ctz64(M))
+
+ow_static_forceinline group_t group_load(const ctrl_t *ctrl) {
+	return _mm_loadu_si128((const __m128i *)ctrl);
+}
+
+ow_static_forceinline group_mask_t group_match(group_t g, ctrl_t h2) {
+	return (group_mask_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), g));
+}
+
+ow_static_forceinline group_mask_t group_match_empty(group_t g) {
+	return (group_mask_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(CTRL_EMPTY), g));
+}
+
+ow_static_forceinline group_mask_t group_match_empty_or_deleted(group_t g) {
+	return (group_mask_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(CTRL_SENTINEL), g));
+}
+
+#elif HASHMAP_NEON
+
+#define GROUP_WIDTH 8
+
+typedef uint8x8_t group_t;
+typedef uint64_t group_mask_t; // The highest bit of each byte.
+
+#define GROUP_MSBS  UINT64_C(0x8080808080808080)
+#define group_mask_index(M)  ((size_t)ow_bits_ctz64(M) >> 3)
+
+ow_static_forceinline group_t group_load(const ctrl_t *ctrl) {
+	return vld1_u8((const uint8_t *)ctrl);
+}
+
+ow_static_forceinline group_mask_t group_match(group_t g, ctrl_t h2) {
+	return vget_lane_u64(vreinterpret_u64_u8(vceq_u8(g, vdup_n_u8((uint8_t)h2))), 0)
+		& GROUP_MSBS;
+}
+
+ow_static_forceinline group_mask_t group_match_empty(group_t g) {
+	return vget_lane_u64(vreinterpret_u64_u8(vceq_u8(g, vdup_n_u8((uint8_t)CTRL_EMPTY))), 0)
+		& GROUP_MSBS;
+}
+
+ow_static_forceinline group_mask_t group_match_empty_or_deleted(group_t g) {
+	return vget_lane_u64(vreinterpret_u64_u8(
+		vclt_s8(vreinterpret_s8_u8(g), vdup_n_s8(CTRL_SENTINEL))), 0) & GROUP_MSBS;
+}
+
+#else // Portable SWAR implementation.
+
+#define GROUP_WIDTH 8
+
+typedef uint64_t group_t;
+typedef uint64_t group_mask_t; // The highest bit of each byte.
+
+#define GROUP_LSBS  UINT64_C(0x0101010101010101)
+#define GROUP_MSBS  UINT64_C(0x8080808080808080)
+#define group_mask_index(M)  ((size_t)ow_bits_ctz64(M) >> 3)
+
+ow_static_forceinline group_t group_load(const ctrl_t *ctrl) {
+	group_t g;
+	memcpy(&g, ctrl, sizeof g);
+#if defined __BYTE_ORDER__ && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	g = __builtin_bswap64(g);
+#endif
+	return g;
+}
+
+ow_static_forceinline group_mask_t group_match(group_t g, ctrl_t h2) {
+	// May give false positives, which are filtered out by comparing the hash.
+	const uint64_t x = g ^ (GROUP_LSBS * (uint8_t)h2);
+	return (x - GROUP_LSBS) & ~x & GROUP_MSBS;
+}
+
+ow_static_forceinline group_mask_t group_match_empty(group_t g) {
+	return g & ~(g << 6) & GROUP_MSBS;
+}
+
+ow_static_forceinline group_mask_t group_match_empty_or_deleted(group_t g) {
+	return g & ~(g << 7) & GROUP_MSBS;
+}
+
+#endif
+
+/// Control bytes of a map without slots.
+static const ctrl_t empty_group[16] = {
+	CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY,
+	CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY,
+	CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY,
+	CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY, CTRL_EMPTY,
 };
 
-static_assert(offsetof(struct _ow_hashmap_node, next_node)
-	== offsetof(struct _ow_hashmap_bucket, nodes), "");
+static_assert(GROUP_WIDTH <= sizeof empty_group, "");
+
+/// Spread the hash value, which may be as weak as the identity of an integer.
+ow_static_forceinline uint64_t hash_mix(ow_hash_t hash) {
+	return ow_hash_spread(hash);
+}
 
-typedef struct _ow_hashmap_node node_t;
-typedef struct _ow_hashmap_bucket bucket_t;
+ow_static_forceinline size_t hash_h1(uint64_t mixed_hash) {
+	return (size_t)(mixed_hash >> 32);
+}
 
-void ow_hashmap_init(struct ow_hashmap *map, size_t n) {
-	if (n < 3) // Empty bucket array may cause SIGFPE.
-		n = 3;
-	map->_size = 0;
-	map->_bucket_count = n;
-	map->_buckets = ow_malloc(sizeof(bucket_t) * n);
-	for (size_t i = 0; i < n; i++)
-		map->_buckets[i].nodes = NULL;
+ow_static_forceinline ctrl_t hash_h2(uint64_t mixed_hash) {
+	return (ctrl_t)((mixed_hash >> 25) & 0x7f);
 }
 
-void ow_hashmap_fini(struct ow_hashmap *map) {
-	ow_hashmap_clear(map);
-	ow_free(map->_buckets);
-}
-
-static void ow_hashmap_rehash(struct ow_hashmap *map, size_t size) {
-	bucket_t *const new_bucket_vec = ow_malloc(sizeof(bucket_t) * size);
-	for (size_t i = 0; i < size; i++)
-		new_bucket_vec[i].nodes = NULL;
-	bucket_t *const old_bucket_vec = map->_buckets;
-	const size_t old_bucket_cnt = map->_bucket_count;
-
-	for (size_t old_bucket_i = 0; old_bucket_i < old_bucket_cnt; old_bucket_i++) {
-		node_t *old_node_p = old_bucket_vec[old_bucket_i].nodes;
-		while (old_node_p != NULL) {
-			const size_t new_bucket_i = old_node_p->key_hash % size;
-			bucket_t *const new_bucket = new_bucket_vec + new_bucket_i;
-			node_t *new_prev_node_p = (node_t *)new_bucket;
-			while (new_prev_node_p->next_node)
-				new_prev_node_p = new_prev_node_p->next_node;
-			new_prev_node_p->next_node = old_node_p;
-			node_t *next_node_p = old_node_p->next_node;
-			old_node_p->next_node = NULL;
-			old_node_p = next_node_p;
+/// Max number of elements in a table of the capacity. At least one slot is kept empty.
+static size_t capacity_to_growth(size_t capacity) {
+	return capacity - capacity / 8 - (capacity < 8);
+}
+
+/// Min capacity for the number of elements.
+static size_t capacity_for_size(size_t size) {
+	size_t capacity = 3;
+	while (capacity_to_growth(capacity) < size)
+		capacity = capacity * 2 + 1;
+	return capacity;
+}
+
+ow_static_forceinline void set_ctrl(struct ow_hashmap *map, size_t index, ctrl_t c) {
+	const size_t capacity = map->_capacity;
+	map->_ctrl[index] = c;
+	map->_ctrl[((index - (GROUP_WIDTH - 1)) & capacity) + ((GROUP_WIDTH - 1) & capacity)] = c;
+}
+
+static void reset_ctrl(struct ow_hashmap *map) {
+	const size_t capacity = map->_capacity;
+	assert(capacity);
+	memset(map->_ctrl, CTRL_EMPTY, capacity + GROUP_WIDTH);
+	map->_ctrl[capacity] = CTRL_SENTINEL;
+	map->_growth_left = capacity_to_growth(capacity) - map->_size;
+}
+
+/// Find the first empty or deleted slot in the probe sequence.
+static size_t find_free_slot(const struct ow_hashmap *map, uint64_t mixed_hash) {
+	const size_t capacity = map->_capacity;
+	size_t pos = hash_h1(mixed_hash) & capacity;
+	for (size_t step = GROUP_WIDTH; ; step += GROUP_WIDTH) {
+		const group_mask_t mask = group_match_empty_or_deleted(group_load(map->_ctrl + pos));
+		if (ow_likely(mask))
+			return (pos + group_mask_index(mask)) & capacity;
+		assert(step <= capacity + GROUP_WIDTH);
+		pos = (pos + step) & capacity;
+	}
+}
+
+ow_static_forceinline slot_t *find_slot(
+		const struct ow_hashmap *map, const struct ow_hashmap_funcs *mf,
+		const void *key, ow_hash_t hash) {
+	const size_t capacity = map->_capacity;
+	const uint64_t mixed_hash = hash_mix(hash);
+	const ctrl_t h2 = hash_h2(mixed_hash);
+	size_t pos = hash_h1(mixed_hash) & capacity;
+	for (size_t step = GROUP_WIDTH; ; step += GROUP_WIDTH) {
+		const group_t g = group_load(map->_ctrl + pos);
+		for (group_mask_t mask = group_match(g, h2); mask; mask &= mask - 1) {
+			slot_t *const slot = map->_slots + ((pos + group_mask_index(mask)) & capacity);
+			if (ow_likely(slot->hash == hash) &&
+					ow_likely(mf->key_equal(mf->context, key, slot->key)))
+				return slot;
 		}
+		if (ow_likely(group_match_empty(g)))
+			return NULL;
+		assert(step <= capacity + GROUP_WIDTH);
+		pos = (pos + step) & capacity;
+	}
+}
+
+/// Move all elements to a new table, dropping the deleted slots.
+static void ow_hashmap_rehash(struct ow_hashmap *map, size_t capacity) {
+	assert(!capacity || capacity_to_growth(capacity) >= map->_size);
+	ctrl_t *const old_ctrl = map->_ctrl;
+	slot_t *const old_slots = map->_slots;
+	const size_t old_capacity = map->_capacity;
+
+	map->_capacity = capacity;
+	if (capacity) {
+		map->_slots = ow_malloc(sizeof(slot_t) * capacity + capacity + GROUP_WIDTH);
+		map->_ctrl = (ctrl_t *)(map->_slots + capacity);
+		reset_ctrl(map);
+	} else {
+		map->_slots = NULL;
+		map->_ctrl = (ctrl_t *)empty_group;
+		map->_growth_left = 0;
 	}
 
-	map->_buckets = new_bucket_vec;
-	map->_bucket_count = size;
-	ow_free(old_bucket_vec);
+	for (size_t i = 0; i < old_capacity; i++) {
+		if (!ctrl_is_full(old_ctrl[i]))
+			continue;
+		const uint64_t mixed_hash = hash_mix(old_slots[i].hash);
+		const size_t index = find_free_slot(map, mixed_hash);
+		set_ctrl(map, index, hash_h2(mixed_hash));
+		map->_slots[index] = old_slots[i];
+	}
+
+	if (old_capacity)
+		ow_free(old_slots);
+}
+
+void ow_hashmap_init(struct ow_hashmap *map, size_t n) {
+	map->_size = 0;
+	map->_capacity = 0;
+	map->_growth_left = 0;
+	map->_ctrl = (ctrl_t *)empty_group;
+	map->_slots = NULL;
+	if (n)
+		ow_hashmap_rehash(map, capacity_for_size(n));
+}
+
+void ow_hashmap_fini(struct ow_hashmap *map) {
+	if (map->_capacity)
+		ow_free(map->_slots);
 }
 
 void ow_hashmap_reserve(struct ow_hashmap *map, size_t size) {
-	if (ow_unlikely(size <= map->_bucket_count))
+	if (ow_unlikely(size <= map->_size + map->_growth_left))
 		return;
-	ow_hashmap_rehash(map, size);
+	ow_hashmap_rehash(map, capacity_for_size(size));
 }
 
 void ow_hashmap_shrink(struct ow_hashmap *map) {
-	if (ow_unlikely(map->_size > map->_bucket_count))
+	const size_t capacity = map->_size ? capacity_for_size(map->_size) : 0;
+	if (ow_unlikely(capacity >= map->_capacity))
 		return;
-	ow_hashmap_rehash(map, map->_size);
+	ow_hashmap_rehash(map, capacity);
 }
 
 struct _ow_hashmap_extend_walker_context {
@@ -90,6 +291,7 @@ static int _ow_hashmap_extend_walker(void *arg, const void *key, void *val) {
 void ow_hashmap_extend(
 		struct ow_hashmap *map, const struct ow_hashmap_funcs *mf,
 		struct ow_hashmap *other) {
+	ow_hashmap_reserve(map, map->_size + other->_size);
 	struct _ow_hashmap_extend_walker_context ctx = { map, mf };
 	ow_hashmap_foreach(other, _ow_hashmap_extend_walker, &ctx);
 }
@@ -98,67 +300,48 @@ bool ow_hashmap_remove(
 		struct ow_hashmap *map, const struct ow_hashmap_funcs *mf,
 		const void *key) {
 	const ow_hash_t hash = mf->key_hash(mf->context, key);
-	bucket_t *const bucket = map->_buckets + (hash % map->_bucket_count);
-	node_t *node_p = (node_t *)bucket;
-	while (1) {
-		node_t *next_node_p = node_p->next_node;
-		if (next_node_p == NULL)
-			return false;
-		if (next_node_p->key_hash == hash &&
-				mf->key_equal(mf->context, key, next_node_p->key)) {
-			node_p->next_node = next_node_p->next_node;
-			ow_free(next_node_p);
-			return true;
-		}
-		node_p = next_node_p;
-	}
+	slot_t *const slot = find_slot(map, mf, key, hash);
+	if (!slot)
+		return false;
+	set_ctrl(map, (size_t)(slot - map->_slots), CTRL_DELETED);
+	if (!--map->_size)
+		reset_ctrl(map); // Drop the deleted slots.
+	return true;
 }
 
 void ow_hashmap_clear(struct ow_hashmap *map) {
 	if (ow_unlikely(!map->_size))
 		return;
-
-	bucket_t *const buckets = map->_buckets;
-	const size_t bucket_cnt = map->_bucket_count;
-	for (size_t i = 0; i < bucket_cnt; i++) {
-		node_t *node_p = buckets[i].nodes;
-		while (node_p != NULL) {
-			node_t *const next_node_p = node_p->next_node;
-			ow_free(node_p);
-			node_p = next_node_p;
-		}
-		buckets[i].nodes = NULL;
-	}
 	map->_size = 0;
+	reset_ctrl(map);
 }
 
 void ow_hashmap_set(
 		struct ow_hashmap *map, const struct ow_hashmap_funcs *mf,
 		const void *key, void *val) {
-	if (ow_unlikely(map->_size > map->_bucket_count))
-		ow_hashmap_rehash(map, (map->_size - 1) * 2);
-
 	const ow_hash_t hash = mf->key_hash(mf->context, key);
-	bucket_t *const bucket = map->_buckets + (hash % map->_bucket_count);
-	node_t *node_p = (node_t *)bucket;
-	while (1) {
-		node_t *next_node_p = node_p->next_node;
-		if (next_node_p == NULL)
-			break;
-		if (next_node_p->key_hash == hash &&
-				mf->key_equal(mf->context, key, next_node_p->key)) {
-			next_node_p->value = val;
-			return;
-		}
-		node_p = next_node_p;
+	slot_t *slot = find_slot(map, mf, key, hash);
+	if (slot) {
+		slot->value = val;
+		return;
 	}
 
-	node_t *const new_node = ow_malloc(sizeof(node_t));
-	new_node->next_node = NULL;
-	new_node->key_hash = hash;
-	new_node->key = (void *)key;
-	new_node->value = val;
-	node_p->next_node = new_node;
+	const uint64_t mixed_hash = hash_mix(hash);
+	size_t index = find_free_slot(map, mixed_hash);
+	if (ow_unlikely(!map->_growth_left && map->_ctrl[index] == CTRL_EMPTY)) {
+		const size_t capacity = map->_capacity;
+		if (capacity > GROUP_WIDTH && map->_size * 32 <= capacity * 25)
+			ow_hashmap_rehash(map, capacity); // Mostly deleted slots.
+		else
+			ow_hashmap_rehash(map, capacity ? capacity * 2 + 1 : 3);
+		index = find_free_slot(map, mixed_hash);
+	}
+	map->_growth_left -= map->_ctrl[index] == CTRL_EMPTY;
+	set_ctrl(map, index, hash_h2(mixed_hash));
+	slot = map->_slots + index;
+	slot->key = (void *)key;
+	slot->value = val;
+	slot->hash = hash;
 	map->_size++;
 }
 
@@ -166,30 +349,20 @@ void *ow_hashmap_get(
 		const struct ow_hashmap *map, const struct ow_hashmap_funcs *mf,
 		const void *key) {
 	const ow_hash_t hash = mf->key_hash(mf->context, key);
-	bucket_t *const bucket = map->_buckets + (hash % map->_bucket_count);
-	node_t *node_p = (node_t *)bucket;
-	while (1) {
-		node_t *next_node_p = node_p->next_node;
-		if (next_node_p == NULL)
-			return NULL;
-		if (next_node_p->key_hash == hash &&
-				mf->key_equal(mf->context, key, next_node_p->key))
-			return next_node_p->value;
-		node_p = next_node_p;
-	}
+	slot_t *const slot = find_slot(map, mf, key, hash);
+	return slot ? slot->value : NULL;
 }
 
 int ow_hashmap_foreach(
 		const struct ow_hashmap *map, ow_hashmap_walker_t walker, void *arg) {
-	bucket_t *const buckets = map->_buckets;
-	const size_t bucket_cnt = map->_bucket_count;
-	for (size_t i = 0; i < bucket_cnt; i++) {
-		for (node_t *node_p = buckets[i].nodes;
-			node_p != NULL; node_p = node_p->next_node) {
-			int ret = walker(arg, node_p->key, node_p->value);
-			if (ret)
-				return ret;
-		}
+	const ctrl_t *const ctrl = map->_ctrl;
+	slot_t *const slots = map->_slots;
+	for (size_t i = 0, n = map->_capacity; i < n; i++) {
+		if (!ctrl_is_full(ctrl[i]))
+			continue;
+		const int ret = walker(arg, slots[i].key, slots[i].value);
+		if (ret)
+			return ret;
 	}
 	return 0;
 }
@@ -5,13 +5,16 @@
 
 #include "hash.h" // ow_hash_t
 
-struct _ow_hashmap_bucket;
+struct _ow_hashmap_slot;
 
 /// Hash map, whose keys and values are pointers.
+/// It is an open-addressing table probed by groups of control bytes.
 struct ow_hashmap {
 	size_t _size;
-	size_t _bucket_count;
-	struct _ow_hashmap_bucket *_buckets;
+	size_t _capacity; // 0 or (2^n - 1)
+	size_t _growth_left; // Number of empty slots that can be filled before rehashing.
+	signed char *_ctrl; // Control bytes, one for each slot, plus the cloned group.
+	struct _ow_hashmap_slot *_slots;
 };
 
 /// Functions used for hash map querying and manipulating.
@@ -0,0 +1,135 @@
+#include "malloc.h"
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ow.h>
+#include <utilities/round.h>
+#include <utilities/thread.h>
+
+#ifdef _MSC_VER
+#	include <malloc.h>
+#endif // _MSC_VER
+
+/// Header of memory allocated by `ow_malloc()` with a custom allocator.
+union malloc_header {
+	size_t size; // Not including the header.
+	max_align_t _align;
+};
+
+#define HEADER_SIZE  sizeof(union malloc_header)
+#define ALIGNMENT    alignof(max_align_t)
+
+static thread_local const struct ow_allocator *current_allocator = NULL;
+
+void ow_malloc_set_allocator(const struct ow_allocator *allocator) {
+	current_allocator = allocator;
+}
+
+const struct ow_allocator *ow_malloc_get_allocator(void) {
+	return current_allocator;
+}
+
+ow_nodiscard void *ow_malloc(size_t size) {
+	const struct ow_allocator *const allocator = current_allocator;
+	if (ow_likely(!allocator))
+		return malloc(size);
+	if (ow_unlikely(size > SIZE_MAX - HEADER_SIZE))
+		return NULL;
+	union malloc_header *const header =
+		allocator->allocate(allocator->data, HEADER_SIZE + size, ALIGNMENT);
+	if (ow_unlikely(!header))
+		return NULL;
+	header->size = size;
+	return header + 1;
+}
+
+ow_nodiscard void *ow_calloc(size_t count, size_t size) {
+	const struct ow_allocator *const allocator = current_allocator;
+	if (ow_likely(!allocator))
+		return calloc(count, size);
+	if (ow_unlikely(size && count > (SIZE_MAX - HEADER_SIZE) / size))
+		return NULL;
+	const size_t total_size = count * size;
+	union malloc_header *const header =
+		allocator->allocate(allocator->data, HEADER_SIZE + total_size, ALIGNMENT);
+	if (ow_unlikely(!header))
+		return NULL;
+	header->size = total_size;
+	memset(header + 1, 0, total_size);
+	return header + 1;
+}
+
+ow_nodiscard void *ow_realloc(void *pointer, size_t new_size) {
+	const struct ow_allocator *const allocator = current_allocator;
+	if (ow_likely(!allocator))
+		return realloc(pointer, new_size);
+	if (!pointer)
+		return ow_malloc(new_size);
+	if (ow_unlikely(new_size > SIZE_MAX - HEADER_SIZE))
+		return NULL;
+	union malloc_header *const header = (union malloc_header *)pointer - 1;
+	const size_t old_size = header->size;
+	union malloc_header *new_header;
+	if (allocator->reallocate) {
+		new_header = allocator->reallocate(
+			allocator->data, header,
+			HEADER_SIZE + old_size, HEADER_SIZE + new_size, ALIGNMENT);
+	} else {
+		new_header = allocator->allocate(allocator->data, HEADER_SIZE + new_size, ALIGNMENT);
+		if (ow_likely(new_header)) {
+			memcpy(new_header, header, HEADER_SIZE + (old_size < new_size ? old_size : new_size));
+			allocator->deallocate(allocator->data, header, HEADER_SIZE + old_size, ALIGNMENT);
+		}
+	}
+	if (ow_unlikely(!new_header))
+		return NULL;
+	new_header->size = new_size;
+	return new_header + 1;
+}
+
+void ow_free(void *pointer) {
+	const struct ow_allocator *const allocator = current_allocator;
+	if (ow_likely(!allocator)) {
+		free(pointer);
+		return;
+	}
+	if (!pointer)
+		return;
+	union malloc_header *const header = (union malloc_header *)pointer - 1;
+	allocator->deallocate(allocator->data, header, HEADER_SIZE + header->size, ALIGNMENT);
+}
+
+ow_nodiscard void *ow_aligned_alloc(
+		const struct ow_allocator *allocator, size_t alignment, size_t size) {
+	assert(alignment && !(alignment & (alignment - 1)));
+	if (allocator)
+		return allocator->allocate(allocator->data, size, alignment);
+	if (alignment <= ALIGNMENT)
+		return malloc(size);
+#ifdef _MSC_VER
+	return _aligned_malloc(size, alignment);
+#else
+	return aligned_alloc(alignment, ow_round_up_to(alignment, size));
+#endif
+}
+
+void ow_aligned_free(
+		const struct ow_allocator *allocator, void *pointer, size_t alignment, size_t size) {
+	if (allocator) {
+		allocator->deallocate(allocator->data, pointer, size, alignment);
+		return;
+	}
+	if (alignment <= ALIGNMENT) {
+		free(pointer);
+		return;
+	}
+#ifdef _MSC_VER
+	_aligned_free(pointer);
+#else
+	free(pointer);
+#endif
+}
@@ -1,8 +1,34 @@
 #pragma once
 
-#include <stdlib.h>
+#include <stddef.h>
 
-#define ow_malloc(size)                malloc((size))
-#define ow_calloc(count, size)         calloc((count), (size))
-#define ow_realloc(pointer, new_size)  realloc((pointer), (new_size))
-#define ow_free(pointer)               free((pointer))
+#include <utilities/attributes.h>
+
+struct ow_allocator; // `ow_allocator_t` in `ow.h`
+
+/// Set the allocator for `ow_malloc()` and its friends on current thread, or
+/// NULL to use the C library. Memory must be resized and freed with the same
+/// allocator set as it was allocated with.
+void ow_malloc_set_allocator(const struct ow_allocator *allocator);
+/// Get the allocator set by `ow_malloc_set_allocator()`.
+const struct ow_allocator *ow_malloc_get_allocator(void);
+
+/// Allocate memory with the allocator of current thread. With a custom allocator,
+/// the size is recorded before the returned memory, so that exact sizes can be
+/// passed to the allocator when resizing or freeing it.
+ow_nodiscard void *ow_malloc(size_t size);
+/// Allocate zero-initialized memory like `ow_malloc()`.
+ow_nodiscard void *ow_calloc(size_t count, size_t size);
+/// Resize memory allocated with `ow_malloc()` or `ow_calloc()`, using the same
+/// allocator. If `pointer` is NULL, it works like `ow_malloc()`.
+ow_nodiscard void *ow_realloc(void *pointer, size_t new_size);
+/// Free memory allocated with `ow_malloc()`, `ow_calloc()` or `ow_realloc()`.
+void ow_free(void *pointer);
+
+/// Allocate memory directly from an allocator (NULL for the C library) without
+/// recording anything. `alignment` must be a power of 2.
+ow_nodiscard void *ow_aligned_alloc(
+	const struct ow_allocator *allocator, size_t alignment, size_t size);
+/// Free memory allocated with `ow_aligned_alloc()`. The arguments must be the same.
+void ow_aligned_free(
+	const struct ow_allocator *allocator, void *pointer, size_t alignment, size_t size);
@@ -0,0 +1,156 @@
+#include "ordmap.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <utilities/attributes.h>
+#include <utilities/malloc.h>
+
+/*
+ * Entries are appended to an array and never move, except when the array is
+ * reallocated. Small maps are searched by scanning the entries, comparing the
+ * stored hashes first. Larger maps have an open-addressing index table (linear
+ * probing), whose size is twice the capacity, mapping hashes to entries.
+ */
+
+struct _ow_ordmap_entry {
+	void *key;
+	void *value;
+	ow_hash_t hash;
+};
+
+typedef struct _ow_ordmap_entry entry_t;
+
+/// Max capacity without an index table.
+#define MAX_SCAN_CAPACITY 8
+
+/// Spread the hash value, which may be as weak as the identity of an integer.
+ow_static_forceinline size_t hash_pos(ow_hash_t hash) {
+	return (size_t)(ow_hash_spread(hash) >> 32);
+}
+
+/// Find the entry of the key. If not exist, return NULL.
+ow_static_forceinline entry_t *find_entry(
+		const struct ow_ordmap *map, const struct ow_hashmap_funcs *mf,
+		const void *key, ow_hash_t hash) {
+	entry_t *const entries = map->_entries;
+	const size_t index_mask = map->_index_mask;
+	if (!index_mask) {
+		for (size_t i = 0, n = map->_size; i < n; i++) {
+			entry_t *const entry = entries + i;
+			if (entry->hash == hash && mf->key_equal(mf->context, key, entry->key))
+				return entry;
+		}
+		return NULL;
+	}
+	const uint32_t *const index = map->_index;
+	for (size_t pos = hash_pos(hash) & index_mask; ; pos = (pos + 1) & index_mask) {
+		const uint32_t i = index[pos];
+		if (!i)
+			return NULL;
+		entry_t *const entry = entries + (i - 1);
+		if (ow_likely(entry->hash == hash) &&
+				ow_likely(mf->key_equal(mf->context, key, entry->key)))
+			return entry;
+	}
+}
+
+/// Add an entry to the index table. The entry must not be in it.
+static void index_insert(struct ow_ordmap *map, size_t entry_index) {
+	const size_t index_mask = map->_index_mask;
+	uint32_t *const index = map->_index;
+	size_t pos = hash_pos(map->_entries[entry_index].hash) & index_mask;
+	while (index[pos])
+		pos = (pos + 1) & index_mask;
+	index[pos] = (uint32_t)(entry_index + 1);
+}
+
+/// Move entries to a new array of the capacity and rebuild the index table.
+static void ow_ordmap_resize(struct ow_ordmap *map, size_t capacity) {
+	assert(capacity >= map->_size && !(capacity & (capacity - 1)));
+	assert(capacity <= UINT32_MAX / 2);
+	const size_t index_size = capacity > MAX_SCAN_CAPACITY ? capacity * 2 : 0;
+	entry_t *const old_entries = map->_entries;
+
+	map->_capacity = capacity;
+	map->_entries = ow_malloc(sizeof(entry_t) * capacity + sizeof(uint32_t) * index_size);
+	if (old_entries) {
+		memcpy(map->_entries, old_entries, sizeof(entry_t) * map->_size);
+		ow_free(old_entries);
+	}
+	if (index_size) {
+		map->_index_mask = index_size - 1;
+		map->_index = (uint32_t *)(map->_entries + capacity);
+		memset(map->_index, 0, sizeof(uint32_t) * index_size);
+		for (size_t i = 0, n = map->_size; i < n; i++)
+			index_insert(map, i);
+	} else {
+		map->_index_mask = 0;
+		map->_index = NULL;
+	}
+}
+
+void ow_ordmap_init(struct ow_ordmap *map, size_t n) {
+	map->_size = 0;
+	map->_capacity = 0;
+	map->_index_mask = 0;
+	map->_entries = NULL;
+	map->_index = NULL;
+	if (n)
+		ow_ordmap_reserve(map, n);
+}
+
+void ow_ordmap_fini(struct ow_ordmap *map) {
+	if (map->_entries)
+		ow_free(map->_entries);
+}
+
+void ow_ordmap_reserve(struct ow_ordmap *map, size_t size) {
+	if (ow_unlikely(size <= map->_capacity))
+		return;
+	size_t capacity = 4;
+	while (capacity < size)
+		capacity *= 2;
+	ow_ordmap_resize(map, capacity);
+}
+
+void ow_ordmap_set(
+		struct ow_ordmap *map, const struct ow_hashmap_funcs *mf,
+		const void *key, void *val) {
+	const ow_hash_t hash = mf->key_hash(mf->context, key);
+	entry_t *entry = find_entry(map, mf, key, hash);
+	if (entry) {
+		entry->value = val;
+		return;
+	}
+
+	if (ow_unlikely(map->_size == map->_capacity))
+		ow_ordmap_resize(map, map->_capacity ? map->_capacity * 2 : 4);
+	const size_t entry_index = map->_size++;
+	entry = map->_entries + entry_index;
+	entry->key = (void *)key;
+	entry->value = val;
+	entry->hash = hash;
+	if (map->_index_mask)
+		index_insert(map, entry_index);
+}
+
+void *ow_ordmap_get(
+		const struct ow_ordmap *map, const struct ow_hashmap_funcs *mf,
+		const void *key) {
+	const ow_hash_t hash = mf->key_hash(mf->context, key);
+	entry_t *const entry = find_entry(map, mf, key, hash);
+	return entry ? entry->value : NULL;
+}
+
+int ow_ordmap_foreach(
+		const struct ow_ordmap *map, ow_hashmap_walker_t walker, void *arg) {
+	entry_t *const entries = map->_entries;
+	for (size_t i = 0, n = map->_size; i < n; i++) {
+		const int ret = walker(arg, entries[i].key, entries[i].value);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hash.h" // ow_hash_t
+#include "hashmap.h" // ow_hashmap_funcs, ow_hashmap_walker_t
+
+struct _ow_ordmap_entry;
+
+/// Hash map, whose keys and values are pointers, that remembers the order of
+/// insertion. Elements are stored densely in insertion order; a separate table
+/// of element indices is used for lookup when there are more than a few elements.
+struct ow_ordmap {
+	size_t _size;
+	size_t _capacity; // 0 or 2^n
+	size_t _index_mask; // Index table size - 1, or 0 if there is no index table.
+	struct _ow_ordmap_entry *_entries;
+	uint32_t *_index; // { entry_index + 1 }, or 0 for empty.
+};
+
+/// Initialize the map.
+void ow_ordmap_init(struct ow_ordmap *map, size_t n);
+/// Finalize the map.
+void ow_ordmap_fini(struct ow_ordmap *map);
+/// Reserve space for more elements.
+void ow_ordmap_reserve(struct ow_ordmap *map, size_t size);
+/// Insert or assign. A new element is put after existing ones.
+void ow_ordmap_set(
+	struct ow_ordmap *map, const struct ow_hashmap_funcs *mf, const void *key, void *val);
+/// Find element. If not exist, return NULL.
+void *ow_ordmap_get(
+	const struct ow_ordmap *map, const struct ow_hashmap_funcs *mf, const void *key);
+/// Traverse through the map in insertion order.
+int ow_ordmap_foreach(
+	const struct ow_ordmap *map, ow_hashmap_walker_t walker, void *arg);
+/// Get the number of elements.
+static inline size_t ow_ordmap_size(const struct ow_ordmap *map) { return map->_size; }
@@ -179,6 +179,19 @@ void ow_thrd_yield(void) {
 #endif
 }
 
+size_t ow_thrd_hardware_concurrency(void) {
+#if OW_THRD_WINNT
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#elif OW_THRD_POSIX && defined(_SC_NPROCESSORS_ONLN)
+	const long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (size_t)n : 1;
+#else
+	return 1;
+#endif
+}
+
 _Noreturn void ow_thrd_exit(int res) {
 #if OW_THRD_WINNT
 	_endthreadex((DWORD)res);
@@ -342,3 +355,30 @@ void ow_mtx_destroy(ow_mtx_t *mutex) {
 	ow_unused_var(mutex);
 #endif
 }
+
+#if OW_THRD_WINNT
+
+static BOOL CALLBACK winnt_call_once_func_wrapper(
+		PINIT_ONCE once, PVOID param, PVOID *context) {
+	ow_unused_var(once), ow_unused_var(context);
+	void (*const *const func_p)(void) = param;
+	(*func_p)();
+	return TRUE;
+}
+
+#endif // OW_THRD_WINNT
+
+void ow_call_once(ow_once_flag_t *flag, void (*func)(void)) {
+#if OW_THRD_WINNT
+	InitOnceExecuteOnce(flag, winnt_call_once_func_wrapper, (PVOID)&func, NULL);
+#elif OW_THRD_POSIX
+	pthread_once(flag, func);
+#elif OW_THRD_STDC
+	call_once(flag, func);
+#else
+	if (!*flag) {
+		*flag = 1;
+		func();
+	}
+#endif
+}
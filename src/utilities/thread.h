@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 #include <utilities/platform.h>
 
 struct timespec;
@@ -9,19 +11,27 @@ struct timespec;
 #	define OW_THRD_WINNT 1
 typedef void *ow_thrd_t;
 typedef CRITICAL_SECTION ow_mtx_t;
+typedef INIT_ONCE ow_once_flag_t;
+#	define OW_ONCE_FLAG_INIT INIT_ONCE_STATIC_INIT
 #elif _IS_POSIX_
 #	include <pthread.h>
 #	define OW_THRD_POSIX 1
 typedef pthread_t ow_thrd_t;
 typedef pthread_mutex_t ow_mtx_t;
+typedef pthread_once_t ow_once_flag_t;
+#	define OW_ONCE_FLAG_INIT PTHREAD_ONCE_INIT
 #elif !defined(__STDC_NO_THREADS__)
 #	include <threads.h>
 #	define OW_THRD_STDC  1
 typedef thrd_t ow_thrd_t;
 typedef mtx_t ow_mtx_t;
+typedef once_flag ow_once_flag_t;
+#	define OW_ONCE_FLAG_INIT ONCE_FLAG_INIT
 #else
 typedef long ow_thrd_t;
 typedef long ow_mtx_t;
+typedef int ow_once_flag_t;
+#	define OW_ONCE_FLAG_INIT 0
 #endif
 
 #ifdef _MSC_VER
@@ -61,6 +71,8 @@ ow_thrd_t ow_thrd_current(void);
 int ow_thrd_sleep(const struct timespec *duration, struct timespec *remaining);
 /// Yields the current time slice.
 void ow_thrd_yield(void);
+/// Returns the number of processors that threads can run on, at least 1.
+size_t ow_thrd_hardware_concurrency(void);
 /// Terminates the calling thread.
 _Noreturn void ow_thrd_exit(int res);
 /// Detaches a thread.
@@ -93,3 +105,7 @@ int ow_mtx_trylock(ow_mtx_t *mutex);
 int ow_mtx_unlock(ow_mtx_t *mutex);
 /// Destroys a mutex.
 void ow_mtx_destroy(ow_mtx_t *mutex);
+
+/// Calls a function exactly once, even if invoked from several threads.
+/// The flag must be initialized with `OW_ONCE_FLAG_INIT`.
+void ow_call_once(ow_once_flag_t *flag, void (*func)(void));
@@ -1,4 +1,7 @@
 #include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <ow.h>
@@ -106,6 +109,22 @@ static void test_expressions(ow_machine_t *om) {
 	TEST_ASSERT(eval_and_cmp_int(om, "1 + 2 * 3", 7));
 	TEST_ASSERT(eval_and_cmp_int(om, "(1+2)*3", 9));
 	TEST_ASSERT(eval_and_cmp_int(om, "(((1)+(2))*(3))", 9));
+	TEST_ASSERT(eval_and_cmp_flt(om, "1.5 * 2 - 1 / 4.0", 2.75));
+	TEST_ASSERT(eval_and_cmp_flt(om, "x = 3; x / 2.0 + 1", 2.5));
+	TEST_ASSERT(eval_and_cmp_int(om, "x = 7; x / 2 + x % 2", 4));
+	TEST_ASSERT(eval_and_cmp_int(om, "(2.5 * 3):to_int()", 7));
+	// floats that are too large or too small to be immediate values
+	TEST_ASSERT(eval_and_cmp_flt(om,
+		"x = 1.0; i = 0; while i < 100; x = x * 1024.0; i = i + 1; end; "
+		"while i > 0; x = x / 1024.0; i = i - 1; end; x", 1.0));
+	TEST_ASSERT(eval_and_cmp_flt(om,
+		"x = 1.0; i = 0; while i < 100; x = x / 1024; i = i + 1; end; x * 0.0", 0.0));
+	TEST_ASSERT(eval_and_cmp_flt(om, "0.0 - 0.0 * -1", 0.0));
+	TEST_ASSERT(!eval(om, "x = 0; 1 / x"));
+	double nan_val;
+	TEST_ASSERT(eval(om, "x = 0.0 / 0.0; x * 2.0"));
+	TEST_ASSERT(ow_read_float(om, 0, &nan_val) == 0 && nan_val != nan_val);
+	ow_drop(om, 1);
 
 	TEST_ASSERT(check(om, "()"));
 	TEST_ASSERT(check(om, "(1,)"));
@@ -153,6 +172,410 @@ static void test_statements(ow_machine_t *om) {
 		om, "a=1; b=0; if a<b; y=1; elif a==b; y=0; else; y=-1; end; y", -1));
 	// while statement
 	TEST_ASSERT(eval_and_cmp_int(om, "i=0; while i<100; i+=1; end; i", 100));
+	// local variables
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "func f(n); i=0; s=0; while i<n; s=s+i; i+=1; end; return s; end; f(10)", 45));
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "func f(); a=3; b=5; if a>=b; return a-b; end; a-=1; return b-a; end; f()", 3));
+	// operand types changing between calls
+	TEST_ASSERT(eval_and_cmp_flt(
+		om, "func f(a, b); return a * b - b; end; f(2, 3); f(1.5, 2.0) + f(1.0, 4.0)", 1.0));
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "func f(a, b); if a < b; return a; end; return b; end; f(2.5, 1.5); f(7, 8)", 7));
+}
+
+// Evaluate a map literal of integers. Return its size and the sum of key * value.
+static bool eval_map_int(ow_machine_t *om, const char *src, size_t *len, intmax_t *sum) {
+	if (!eval(om, src))
+		return false;
+	*len = ow_read_map(om, 0, OW_RDMAP_GETLEN);
+	*sum = 0;
+	if (ow_read_map(om, 0, OW_RDMAP_EXPAND) != *len)
+		return false;
+	for (size_t i = 0; i < *len; i++) {
+		intmax_t key, val;
+		if (ow_read_int(om, 0, &val))
+			return false;
+		ow_drop(om, 1);
+		if (ow_read_int(om, 0, &key))
+			return false;
+		ow_drop(om, 1);
+		*sum += key * val;
+	}
+	ow_drop(om, 1);
+	return true;
+}
+
+static void test_maps(ow_machine_t *om) {
+	size_t len;
+	intmax_t sum;
+	TEST_ASSERT(eval_map_int(om, "{1 => 10, 2 => 20, 3 => 30, 1 => 40}", &len, &sum));
+	TEST_ASSERT(len == 3 && sum == 1 * 40 + 2 * 20 + 3 * 30);
+
+	// Large enough to grow the table several times.
+	char src[2048] = "{";
+	intmax_t expected_sum = 0;
+	for (int i = 0; i < 100; i++) {
+		snprintf(src + strlen(src), sizeof src - strlen(src), "%i => %i, ", i * 7, i);
+		expected_sum += i * 7 * i;
+	}
+	strcat(src, "}");
+	TEST_ASSERT(eval_map_int(om, src, &len, &sum));
+	TEST_ASSERT(len == 100 && sum == expected_sum);
+
+	// Keys that are not small ints are compared by their `<=>` methods.
+	TEST_ASSERT(eval(om, "a = 4611686018427387904; {a => 1, a + 0 => 2, 1.5 => 3, 3 / 2.0 => 4}"));
+	TEST_ASSERT(ow_read_map(om, 0, OW_RDMAP_GETLEN) == 2);
+	ow_drop(om, 1);
+
+	// String keys are compared by contents. Elements are kept in insertion order.
+	for (int i = 0; i < 200; i++) {
+		char key[16];
+		snprintf(key, sizeof key, "k%i", i % 100);
+		ow_push_string(om, key, (size_t)-1);
+		ow_push_int(om, i);
+	}
+	ow_make_map(om, 200);
+	TEST_ASSERT(ow_read_map(om, 0, OW_RDMAP_EXPAND) == 100);
+	for (int i = 99; i >= 0; i--) {
+		intmax_t val;
+		char key[16], expected_key[16];
+		TEST_ASSERT(ow_read_int(om, 0, &val) == 0 && val == i + 100);
+		ow_drop(om, 1);
+		snprintf(expected_key, sizeof expected_key, "k%i", i);
+		TEST_ASSERT(ow_read_string_to(om, 0, key, sizeof key) > 0 && !strcmp(key, expected_key));
+		ow_drop(om, 1);
+	}
+	ow_drop(om, 1);
+
+	// Long keys that differ only in the last bytes.
+	for (int i = 0; i < 40; i++) {
+		char key[128];
+		memset(key, 'x', sizeof key);
+		snprintf(key + 100, sizeof key - 100, "%i", i % 20);
+		ow_push_string(om, key, (size_t)-1);
+		ow_push_int(om, i);
+	}
+	ow_make_map(om, 40);
+	TEST_ASSERT(ow_read_map(om, 0, OW_RDMAP_GETLEN) == 20);
+	ow_drop(om, 1);
+
+	// Integers that differ only in high bits, and the equal floats.
+	for (int i = 0; i < 4000; i++) {
+		const intmax_t key = (intmax_t)(i % 2000) << 47;
+		if (i < 2000)
+			ow_push_int(om, key);
+		else
+			ow_push_float(om, (double)key);
+		ow_push_int(om, i);
+	}
+	ow_make_map(om, 4000);
+	TEST_ASSERT(ow_read_map(om, 0, OW_RDMAP_GETLEN) == 2000);
+	ow_drop(om, 1);
+
+	TEST_ASSERT(eval(om, "{`a => 1, nil => 2, true => 3, false => 4, 0.5 => 5, `a => 6, nil => 7}"));
+	TEST_ASSERT(ow_read_map(om, 0, OW_RDMAP_GETLEN) == 5);
+	ow_drop(om, 1);
+}
+
+static void test_operators(ow_machine_t *om) {
+	// Operands that are not small ints or floats use operator methods.
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "a = 4611686018427387904; n = 0; if a == a + 0; n = n + 1; end; "
+		"if 2.5 < a; n = n + 10; end; if a > 1.5; n = n + 100; end; n", 111));
+	TEST_ASSERT(!eval(om, "4611686018427387904 < nil"));
+	TEST_ASSERT(!eval(om, "nil + 1"));
+
+	// `x -= n` shall call `-` rather than `+` with `-n`.
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "func f(); a = 4611686018427387904; a -= 4; a += 1; return a - 4611686018427387900; end; f()", 1));
+	TEST_ASSERT(eval_and_cmp_flt(
+		om, "func f(); x = 0.5; i = 0; while i < 10; x += 1; x -= 3; i += 1; end; return x; end; f()", -19.5));
+	char msg[128];
+	TEST_ASSERT(ow_make_module(
+		om, "", "func f(); s = \"abc\"; s -= 1; end; f()", OW_MKMOD_STRING | OW_MKMOD_RETLAST) == 0);
+	TEST_ASSERT(ow_invoke(om, 0, OW_IVK_MODULE) != 0);
+	TEST_ASSERT(ow_read_exception(om, 0, OW_RDEXC_MSG | OW_RDEXC_TOBUF, msg, sizeof msg) == 0);
+	TEST_ASSERT(strstr(msg, "method `-'") != NULL);
+	ow_drop(om, 2);
+}
+
+static void test_records(ow_machine_t *om) {
+	TEST_ASSERT(eval_and_cmp_int(om, "r = record(); r.x = 1; r.y = 2; r.x = r.x * 10; r.x + r.y", 12));
+	// Objects with the same attributes share a shape, while the order of adding
+	// attributes matters. The same code sees objects of different shapes.
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "func make(a, b, ab); r = record(); if ab; r.a = a; r.b = b; "
+		"else; r.b = b; r.a = a; end; return r; end; func f(r); return r.a * 10 + r.b; end; "
+		"f(make(1, 2, true)) + f(make(3, 4, false)) * 100 + f(make(5, 6, true)) * 10000", 563412));
+	TEST_ASSERT(!eval(om, "r = record(); r.x = 1; r.y"));
+}
+
+static void test_gc(ow_machine_t *om) {
+	// Old module globals keep referring to new arrays, which must survive minor GCs.
+	TEST_ASSERT(eval(
+		om, "lst = nil; i = 0; while i < 200000; tmp = [i]; "
+		"if i % 4 == 0; lst = [i, lst, [i, i]]; end; i = i + 1; end; lst"));
+	for (intmax_t i = 199996; i >= 0; i -= 4) {
+		intmax_t v;
+		TEST_ASSERT(ow_read_array(om, 0, 1) == 0);
+		TEST_ASSERT(ow_read_int(om, 0, &v) == 0 && v == i);
+		ow_drop(om, 1);
+		TEST_ASSERT(ow_read_array(om, 0, 2) == 0);
+		ow_swap(om);
+		ow_drop(om, 1);
+	}
+	TEST_ASSERT(ow_read_nil(om, 0) == 0);
+	ow_drop(om, 1);
+
+	// Records of two shapes, whose attributes refer to young objects.
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "func node(i, next); n = record(); v = record(); v.x = i; "
+		"if i % 2 == 0; n.v = v; n.next = next; else; n.next = next; n.v = v; end; "
+		"return n; end; lst = nil; i = 0; while i < 100000; tmp = record(); tmp.a = i; "
+		"lst = node(i, lst); i = i + 1; end; s = 0; i = 0; "
+		"while i < 100000; s = s + lst.v.x; lst = lst.next; i = i + 1; end; s",
+		4999950000));
+}
+
+static void test_incremental_gc(void) {
+	int64_t mark_budget = 100;
+	TEST_ASSERT(ow_sysctl(OW_CTL_GCMARKBUDGET, &mark_budget, sizeof mark_budget) == 0);
+	ow_machine_t *const om = ow_create();
+	test_gc(om);
+	ow_destroy(om);
+	mark_budget = 0;
+	TEST_ASSERT(ow_sysctl(OW_CTL_GCMARKBUDGET, &mark_budget, sizeof mark_budget) == 0);
+}
+
+static void test_parallel_gc(void) {
+	int64_t mark_threads = 4;
+	TEST_ASSERT(ow_sysctl(OW_CTL_GCMARKTHREADS, &mark_threads, sizeof mark_threads) == 0);
+	ow_machine_t *const om = ow_create();
+	test_gc(om);
+	ow_destroy(om);
+	mark_threads = 1;
+	TEST_ASSERT(ow_sysctl(OW_CTL_GCMARKTHREADS, &mark_threads, sizeof mark_threads) == 0);
+}
+
+static void test_compacting_gc(void) {
+	int64_t compact_threshold = 1;
+	TEST_ASSERT(ow_sysctl(OW_CTL_GCCOMPACT, &compact_threshold, sizeof compact_threshold) == 0);
+	ow_machine_t *const om = ow_create();
+	// Lists of earlier runs become garbage, fragmenting the heap.
+	for (int i = 0; i < 3; i++)
+		test_gc(om);
+	ow_destroy(om);
+	compact_threshold = 0;
+	TEST_ASSERT(ow_sysctl(OW_CTL_GCCOMPACT, &compact_threshold, sizeof compact_threshold) == 0);
+}
+
+static void test_gc_pacer(void) {
+	int64_t cpu_goal = 5, heap_goal = 8 << 20;
+	TEST_ASSERT(ow_sysctl(OW_CTL_GCCPUGOAL, &cpu_goal, sizeof cpu_goal) == 0);
+	TEST_ASSERT(ow_sysctl(OW_CTL_GCHEAPGOAL, &heap_goal, sizeof heap_goal) == 0);
+	ow_machine_t *const om = ow_create();
+	test_gc(om);
+	ow_destroy(om);
+	cpu_goal = 0, heap_goal = 0;
+	TEST_ASSERT(ow_sysctl(OW_CTL_GCCPUGOAL, &cpu_goal, sizeof cpu_goal) == 0);
+	TEST_ASSERT(ow_sysctl(OW_CTL_GCHEAPGOAL, &heap_goal, sizeof heap_goal) == 0);
+}
+
+static void test_heap_limit(void) {
+	int64_t heap_limit = 16 << 20;
+	TEST_ASSERT(ow_sysctl(OW_CTL_HEAPLIMIT, &heap_limit, sizeof heap_limit) == 0);
+	ow_machine_t *const om = ow_create();
+	// An exception is raised at a backward jump or a call. The objects are
+	// referred to only by locals, so they become garbage with the frames.
+	TEST_ASSERT(!eval(om, "func g(); lst = nil; while true; lst = [lst, lst]; end; end; g()"));
+	TEST_ASSERT(!eval(om, "func f(x); return [x, x]; end; "
+		"func g(); lst = nil; while true; lst = f(lst); end; end; g()"));
+	test_gc(om);
+	ow_destroy(om);
+	heap_limit = 0;
+	TEST_ASSERT(ow_sysctl(OW_CTL_HEAPLIMIT, &heap_limit, sizeof heap_limit) == 0);
+}
+
+// Memory in use, counted by the allocator.
+// Updated atomically, as the hooks are also called on garbage collector threads.
+struct test_allocator_data {
+	atomic_size_t size;
+	atomic_size_t count;
+};
+
+static void *test_allocate(void *data, size_t size, size_t alignment) {
+	unsigned char *const p = malloc(sizeof(void *) + alignment + size);
+	if (!p)
+		return NULL;
+	void **const res = (void **)(((uintptr_t)p + sizeof(void *) + alignment) & ~(alignment - 1));
+	res[-1] = p;
+	atomic_fetch_add(&((struct test_allocator_data *)data)->size, size);
+	atomic_fetch_add(&((struct test_allocator_data *)data)->count, 1);
+	return res;
+}
+
+static void test_deallocate(void *data, void *ptr, size_t size, size_t alignment) {
+	(void)alignment;
+	free(((void **)ptr)[-1]);
+	atomic_fetch_sub(&((struct test_allocator_data *)data)->size, size);
+	atomic_fetch_sub(&((struct test_allocator_data *)data)->count, 1);
+}
+
+static ow_machine_t *test_other_om;
+
+// Allocate in another context.
+static int test_native_other(ow_machine_t *om) {
+	(void)om;
+	ow_push_string(test_other_om, "0123456789abcdef0123456789abcdef", 32);
+	ow_drop(test_other_om, 1);
+	return 0;
+}
+
+static void test_allocator(void) {
+	struct test_allocator_data data = {0, 0};
+	const ow_allocator_t allocator = {test_allocate, NULL, test_deallocate, &data};
+	TEST_ASSERT(ow_sysctl(OW_CTL_ALLOCATOR, &allocator, sizeof allocator) == 0);
+	ow_machine_t *const om = ow_create();
+	TEST_ASSERT(ow_sysctl(OW_CTL_ALLOCATOR, NULL, 0) == 0);
+	TEST_ASSERT(atomic_load(&data.size) && atomic_load(&data.count));
+	test_gc(om);
+	TEST_ASSERT(eval_and_cmp_int(om, "func f(n); return [n, (n, n), {n => n}, {n}]; end; f(1); 2", 2));
+	ow_destroy(om);
+	TEST_ASSERT(!atomic_load(&data.size) && !atomic_load(&data.count));
+
+	// A native function of one context calls the API of another context, after
+	// which the caller goes on allocating with its own allocator.
+	struct test_allocator_data data1 = {0, 0}, data2 = {0, 0};
+	const ow_allocator_t allocator1 = {test_allocate, NULL, test_deallocate, &data1};
+	const ow_allocator_t allocator2 = {test_allocate, NULL, test_deallocate, &data2};
+	TEST_ASSERT(ow_sysctl(OW_CTL_ALLOCATOR, &allocator1, sizeof allocator1) == 0);
+	ow_machine_t *const om1 = ow_create();
+	TEST_ASSERT(ow_sysctl(OW_CTL_ALLOCATOR, &allocator2, sizeof allocator2) == 0);
+	test_other_om = ow_create();
+	TEST_ASSERT(ow_sysctl(OW_CTL_ALLOCATOR, NULL, 0) == 0);
+	static const ow_native_func_def_t other_funcs[] = {
+		{"other", test_native_other, 0},
+		{NULL, NULL, 0},
+	};
+	static const ow_native_module_def_t other_mod = {"other", other_funcs, NULL};
+	TEST_ASSERT(ow_make_module(om1, "other", &other_mod, OW_MKMOD_NATIVE) == 0);
+	TEST_ASSERT(ow_make_module(
+		om1, "", "func g(h); a = nil; i = 0; while i < 1000; h(); a = [i, a]; i = i + 1; end; "
+		"return a; end", OW_MKMOD_STRING) == 0);
+	TEST_ASSERT(ow_invoke(om1, 0, OW_IVK_MODULE | OW_IVK_NORETVAL) == 0);
+	TEST_ASSERT(ow_load_attribute(om1, 0, "g") == 0);
+	TEST_ASSERT(ow_load_attribute(om1, 1, "other") == 0);
+	TEST_ASSERT(ow_invoke(om1, 1, 0) == 0);
+	TEST_ASSERT(ow_read_array(om1, 0, 1) == 0);
+	intmax_t val;
+	TEST_ASSERT(ow_read_int(om1, 0, &val) == 0 && val == 999);
+	ow_destroy(om1);
+	TEST_ASSERT(!atomic_load(&data1.size) && !atomic_load(&data1.count));
+	ow_destroy(test_other_om);
+	test_other_om = NULL;
+	TEST_ASSERT(!atomic_load(&data2.size) && !atomic_load(&data2.count));
+}
+
+static void test_call_depth(void) {
+	// A stack that is large enough to reach the call depth limit first.
+	const int64_t stack_size = 1 << 16;
+	TEST_ASSERT(ow_sysctl(OW_CTL_STACKSIZE, &stack_size, sizeof stack_size) == 0);
+	ow_machine_t *const om = ow_create();
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "func f(n); if n == 0; return 0; end; return f(n - 1) + 1; end; f(500)", 500));
+	TEST_ASSERT(!eval(om, "func f(n); return f(n + 1); end; f(0)"));
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "func f(n); if n == 0; return 0; end; return f(n - 1) + 1; end; f(500)", 500));
+	ow_destroy(om);
+}
+
+// Push integers 0 ~ n-1 and return them in an array.
+static int test_native_spread(ow_machine_t *om) {
+	intmax_t n;
+	if (ow_read_args(om, OW_RDARG_MKEXC, "i", &n) != 0)
+		return -1;
+	for (intmax_t i = 0; i < n; i++)
+		ow_push_int(om, i);
+	ow_make_array(om, (size_t)n);
+	return 1;
+}
+
+static void test_stack_segments(void) {
+	// A tiny stack segment, so that deep calls have to allocate more segments.
+	const int64_t stack_size = 64;
+	TEST_ASSERT(ow_sysctl(OW_CTL_STACKSIZE, &stack_size, sizeof stack_size) == 0);
+	ow_machine_t *const om = ow_create();
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "func f(n, x); if n == 0; return 0; end; "
+		"a = [n, x, [1, 2, 3]]; return f(n - 1, a) + 1; end; f(900, nil)", 900));
+	TEST_ASSERT(!eval(om, "func f(n, x); if n == 0; return x.y; end; return f(n - 1, x); end; f(900, 1)"));
+	TEST_ASSERT(eval_and_cmp_int(
+		om, "func f(n, x); if n == 0; return x; end; return f(n - 1, x); end; f(900, 7)", 7));
+
+	// Native functions and the host push more objects than a segment holds.
+	static const ow_native_func_def_t spread_funcs[] = {
+		{"spread", test_native_spread, 1},
+		{NULL, NULL, 0},
+	};
+	static const ow_native_module_def_t spread_mod = {"spread", spread_funcs, NULL};
+	const int spread_mod_index = ow_drop(om, 0) + 1;
+	TEST_ASSERT(ow_make_module(om, "spread", &spread_mod, OW_MKMOD_NATIVE) == 0);
+	TEST_ASSERT(ow_make_module(
+		om, "", "func g(k, h); if k == 0; return h(300); end; return g(k - 1, h); end",
+		OW_MKMOD_STRING) == 0);
+	TEST_ASSERT(ow_invoke(om, 0, OW_IVK_MODULE | OW_IVK_NORETVAL) == 0);
+	TEST_ASSERT(ow_load_attribute(om, 0, "g") == 0);
+	ow_push_int(om, 50);
+	TEST_ASSERT(ow_load_attribute(om, spread_mod_index, "spread") == 0);
+	TEST_ASSERT(ow_invoke(om, 2, 0) == 0);
+	TEST_ASSERT(ow_read_array(om, 0, (size_t)-1) == 300);
+	for (int i = 299; i >= 0; i--) {
+		intmax_t val;
+		TEST_ASSERT(ow_read_int(om, 0, &val) == 0 && val == i);
+		ow_drop(om, 1);
+	}
+	ow_drop(om, 3);
+	ow_destroy(om);
+}
+
+static void test_stack_reserve(void) {
+	// A small guarded stack (if supported), which overflows before reaching the call depth limit.
+	int64_t stack_reserve = 512;
+	TEST_ASSERT(ow_sysctl(OW_CTL_STACKRESERVE, &stack_reserve, sizeof stack_reserve) == 0);
+	ow_machine_t *const om = ow_create();
+	for (int i = 0; i < 3; i++) {
+		TEST_ASSERT(!eval(om, "func f(n); return f(n + 1); end; f(0)"));
+		TEST_ASSERT(eval_and_cmp_int(
+			om, "func f(n); if n == 0; return 0; end; return f(n - 1) + 1; end; f(100)", 100));
+	}
+
+	// A native function that pushes more objects than guaranteed, called when
+	// the stack is about to overflow.
+	static const ow_native_func_def_t spread_funcs[] = {
+		{"spread", test_native_spread, 1},
+		{NULL, NULL, 0},
+	};
+	static const ow_native_module_def_t spread_mod = {"spread", spread_funcs, NULL};
+	const int spread_mod_index = ow_drop(om, 0) + 1;
+	TEST_ASSERT(ow_make_module(om, "spread", &spread_mod, OW_MKMOD_NATIVE) == 0);
+	TEST_ASSERT(ow_make_module(
+		om, "", "func f(n, h); h(100); return f(n + 1, h); end", OW_MKMOD_STRING) == 0);
+	TEST_ASSERT(ow_invoke(om, 0, OW_IVK_MODULE | OW_IVK_NORETVAL) == 0);
+	for (int i = 0; i < 3; i++) {
+		TEST_ASSERT(ow_load_attribute(om, 0, "f") == 0);
+		ow_push_int(om, 0);
+		TEST_ASSERT(ow_load_attribute(om, spread_mod_index, "spread") == 0);
+		TEST_ASSERT(ow_invoke(om, 2, 0) != 0);
+		char msg[64];
+		TEST_ASSERT(ow_read_exception(om, 0, OW_RDEXC_MSG | OW_RDEXC_TOBUF, msg, sizeof msg) == 0);
+		TEST_ASSERT(strstr(msg, "stack overflow") != NULL);
+		ow_drop(om, 1);
+	}
+	ow_drop(om, 2);
+	ow_destroy(om);
+	stack_reserve = 0;
+	TEST_ASSERT(ow_sysctl(OW_CTL_STACKRESERVE, &stack_reserve, sizeof stack_reserve) == 0);
 }
 
 int main(void) {
@@ -160,5 +583,18 @@ int main(void) {
 	test_literals(om);
 	test_expressions(om);
 	test_statements(om);
+	test_maps(om);
+	test_operators(om);
+	test_records(om);
+	test_gc(om);
 	ow_destroy(om);
+	test_incremental_gc();
+	test_parallel_gc();
+	test_compacting_gc();
+	test_gc_pacer();
+	test_heap_limit();
+	test_allocator();
+	test_call_depth();
+	test_stack_segments();
+	test_stack_reserve();
 }
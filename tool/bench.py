@@ -0,0 +1,118 @@
+#!/bin/env python3
+
+import argparse
+import dataclasses
+import pathlib
+import shutil
+import subprocess
+import time
+
+
+@dataclasses.dataclass
+class BenchResult:
+    times: list[float]
+    counters: dict[str, int]
+
+    @property
+    def best(self) -> float:
+        return min(self.times)
+
+    @property
+    def mean(self) -> float:
+        return sum(self.times) / len(self.times)
+
+
+PERF_EVENTS = ['instructions', 'branches', 'branch-misses']
+
+
+def parse_perf_output(text: str) -> dict[str, int]:
+    counters = {}
+    for line in text.splitlines():
+        fields = line.split(',')
+        if len(fields) < 3:
+            continue
+        value, event = fields[0], fields[2]
+        event = event.split(':')[0]
+        if event in PERF_EVENTS and value.isdigit():
+            counters[event] = int(value)
+    return counters
+
+
+def run_once(cmd: list[str], use_perf: bool) -> tuple[float, dict[str, int]]:
+    if use_perf:
+        cmd = ['perf', 'stat', '-x,', '-e', ','.join(PERF_EVENTS), '--'] + cmd
+    t0 = time.perf_counter()
+    proc = subprocess.run(
+        cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+    t1 = time.perf_counter()
+    if proc.returncode != 0:
+        raise RuntimeError(
+            f'command failed ({proc.returncode}): {" ".join(cmd)}\n'
+            + proc.stderr)
+    return t1 - t0, parse_perf_output(proc.stderr) if use_perf else {}
+
+
+def run_bench(
+        exe: pathlib.Path, script: pathlib.Path, extra_args: list[str],
+        repeat: int, use_perf: bool) -> BenchResult:
+    result = BenchResult([], {})
+    cmd = [str(exe)] + extra_args + [str(script)]
+    for _ in range(repeat):
+        t, counters = run_once(cmd, use_perf)
+        result.times.append(t)
+        for k, v in counters.items():
+            result.counters[k] = min(result.counters.get(k, v), v)
+    return result
+
+
+def print_result(script: str, exe: str, result: BenchResult):
+    text = f'{script: <20} {exe: <32} ' \
+        + f'{result.best * 1000: >9.1f} ms {result.mean * 1000: >9.1f} ms'
+    if result.counters:
+        instr = result.counters.get('instructions')
+        branches = result.counters.get('branches')
+        misses = result.counters.get('branch-misses')
+        if instr is not None:
+            text += f' {instr / 1e6: >10.1f} M-instr'
+        if branches and misses is not None:
+            text += f' {misses / 1e6: >8.2f} M-miss ({misses / branches:6.2%})'
+    print(text)
+
+
+def main():
+    arg_parser = argparse.ArgumentParser()
+    arg_parser.description = 'Run benchmark scripts with OW executables.'
+    arg_parser.add_argument(
+        '-e', '--exe', action='append', type=pathlib.Path, required=True,
+        help='OW executable to test; can be given more than once to compare')
+    arg_parser.add_argument(
+        '-a', '--arg', action='append', default=[],
+        help='extra command-line argument passed to the executable')
+    arg_parser.add_argument(
+        '-n', '--repeat', type=int, default=5, help='runs per script')
+    arg_parser.add_argument(
+        '-p', '--perf', action='store_true',
+        help='collect instruction and branch-miss counts with `perf stat`')
+    arg_parser.add_argument(
+        'SCRIPT', nargs='*', type=pathlib.Path,
+        help='benchmark scripts; default to all scripts in bench/')
+    args = arg_parser.parse_args()
+
+    scripts = args.SCRIPT
+    if not scripts:
+        bench_dir = pathlib.Path(__file__).parent.parent / 'bench'
+        scripts = sorted(bench_dir.glob('*.ow'))
+    if args.perf and shutil.which('perf') is None:
+        print('*** Cannot find the `perf` command')
+        exit(1)
+
+    print(f'{"SCRIPT": <20} {"EXECUTABLE": <32} '
+        + f'{"BEST": >12} {"MEAN": >12}')
+    for script in scripts:
+        for exe in args.exe:
+            result = run_bench(exe, script, args.arg, args.repeat, args.perf)
+            print_result(script.name, str(exe)[-32:], result)
+
+
+if __name__ == '__main__':
+    main()